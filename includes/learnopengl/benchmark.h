@@ -0,0 +1,245 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define BENCHMARK_HAVE_TSC 1
+#endif
+
+// keeps the compiler from optimizing away a result nobody reads
+template <typename T>
+inline void benchmark_keep(const T &value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r"(&value) : "memory");
+#else
+    static volatile char sink;
+    sink = *reinterpret_cast<const volatile char *>(&value);
+#endif
+}
+
+// One benchmark case: times per call of the benchmarked function, which handles Items items.
+struct BenchmarkResult {
+    std::string Name;
+    size_t Items;
+    unsigned int Repetitions;
+    unsigned long long Iterations; // calls per repetition
+    double MedianNs, P95Ns, MinNs;  // per call
+    double NsPerItem;               // median
+    double CyclesPerItem;           // median, in time stamp counter ticks, 0 where there is none
+    double Bytes;                   // per call, for throughput cases, 0 otherwise
+};
+
+// Small micro-benchmark harness. Run calls the function often enough that one repetition lasts
+// at least MinRepetitionTime, runs Warmup repetitions that are thrown away, then Repetitions timed
+// ones, and keeps the median, the 95th percentile and the fastest. Cycles are counted with the time
+// stamp counter where the CPU has one: reference cycles at the counter's fixed rate, not core
+// clock cycles, but stable across runs on one machine.
+//
+//   BenchmarkSuite suite("math");
+//   suite.Run("transpose(inverse(model))", models.size(), [&]() { ... });
+//   suite.WriteJson(file);
+class BenchmarkSuite
+{
+public:
+    std::string Name;
+    std::string Label;      // free text saved with the results, a commit hash for instance
+    std::string Filter;     // only cases whose name contains it run
+    unsigned int Warmup;
+    unsigned int Repetitions;
+    double MinRepetitionTime; // seconds
+    std::vector<BenchmarkResult> Results;
+
+    explicit BenchmarkSuite(const std::string &name) : Name(name), Warmup(3), Repetitions(25), MinRepetitionTime(0.002)
+    {
+    }
+
+    // parses --filter, --repetitions, --warmup and --label, leaves other arguments alone
+    void ParseArguments(int argc, char **argv)
+    {
+        for (int i = 1; i + 1 < argc; i++)
+        {
+            std::string arg = argv[i];
+            if (arg == "--filter")
+                Filter = argv[++i];
+            else if (arg == "--repetitions")
+                Repetitions = std::max(1, std::atoi(argv[++i]));
+            else if (arg == "--warmup")
+                Warmup = std::atoi(argv[++i]);
+            else if (arg == "--label")
+                Label = argv[++i];
+        }
+    }
+
+    bool Selected(const std::string &name) const
+    {
+        return Filter.empty() || name.find(Filter) != std::string::npos;
+    }
+
+    // times 'f', which processes 'items' items per call and optionally reads or writes 'bytes',
+    // false if the filter skipped it
+    template <typename F>
+    bool Run(const std::string &name, size_t items, const F &f, double bytes = 0.0)
+    {
+        if (!Selected(name))
+            return false;
+
+        // as many calls per repetition as fit into MinRepetitionTime
+        unsigned long long iterations = 1;
+        for (;;)
+        {
+            double seconds = time(f, iterations, NULL);
+            if (seconds >= MinRepetitionTime || iterations >= (1ull << 40))
+                break;
+            iterations *= seconds > 0.0 ? std::max(2.0, std::min(100.0, 1.2 * MinRepetitionTime / seconds)) : 100.0;
+        }
+        for (unsigned int i = 0; i < Warmup; i++)
+            time(f, iterations, NULL);
+
+        std::vector<double> samples(Repetitions);
+        std::vector<double> ticks(Repetitions);
+        for (unsigned int i = 0; i < Repetitions; i++)
+        {
+            double tick = 0.0;
+            samples[i] = time(f, iterations, &tick) * 1e9 / iterations;
+            ticks[i] = tick / iterations;
+        }
+        AddSamples(name, items, iterations, samples, ticks, bytes);
+        return true;
+    }
+
+    // adds a case timed elsewhere, for work that cannot be repeated by calling a function: one
+    // duration in nanoseconds per repetition, and time stamp counter ticks if there are any
+    void AddSamples(const std::string &name, size_t items, unsigned long long iterations, const std::vector<double> &nanoseconds,
+        const std::vector<double> &ticks = std::vector<double>(), double bytes = 0.0)
+    {
+        if (nanoseconds.empty() || !Selected(name))
+            return;
+        BenchmarkResult result;
+        result.Name = name;
+        result.Items = std::max<size_t>(items, 1);
+        result.Repetitions = nanoseconds.size();
+        result.Iterations = iterations;
+        result.MedianNs = percentile(nanoseconds, 0.5);
+        result.P95Ns = percentile(nanoseconds, 0.95);
+        result.MinNs = *std::min_element(nanoseconds.begin(), nanoseconds.end());
+        result.NsPerItem = result.MedianNs / result.Items;
+        result.CyclesPerItem = ticks.empty() ? 0.0 : percentile(ticks, 0.5) / result.Items;
+        result.Bytes = bytes;
+        Results.push_back(result);
+        print(result);
+    }
+
+    void WriteJson(std::ostream &out) const
+    {
+        out << "{\n  \"suite\": \"" << escape(Name) << "\",\n  \"label\": \"" << escape(Label) << "\",\n";
+        out << "  \"compiler\": \"" << escape(compiler()) << "\",\n  \"tsc\": " << (haveCounter() ? "true" : "false") << ",\n";
+        out << "  \"results\": [";
+        out << std::setprecision(6);
+        for (size_t i = 0; i < Results.size(); i++)
+        {
+            const BenchmarkResult &r = Results[i];
+            out << (i ? ",\n" : "\n") << "    { \"name\": \"" << escape(r.Name) << "\", \"items\": " << r.Items
+                << ", \"repetitions\": " << r.Repetitions << ", \"iterations\": " << r.Iterations
+                << ", \"median_ns\": " << r.MedianNs << ", \"p95_ns\": " << r.P95Ns << ", \"min_ns\": " << r.MinNs
+                << ", \"ns_per_item\": " << r.NsPerItem << ", \"cycles_per_item\": " << r.CyclesPerItem
+                << ", \"items_per_second\": " << 1e9 / r.NsPerItem;
+            if (r.Bytes > 0.0)
+                out << ", \"bytes\": " << r.Bytes << ", \"megabytes_per_second\": " << r.Bytes / r.MedianNs * 1e3;
+            out << " }";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    static std::string escape(const std::string &text)
+    {
+        std::string escaped;
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            if (text[i] == '"' || text[i] == '\\')
+                escaped += '\\';
+            escaped += text[i];
+        }
+        return escaped;
+    }
+
+private:
+    template <typename F>
+    static double time(const F &f, unsigned long long iterations, double *ticks)
+    {
+        unsigned long long startTicks = counter();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (unsigned long long i = 0; i < iterations; i++)
+            f();
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        if (ticks)
+            *ticks = (double)(counter() - startTicks);
+        return std::chrono::duration<double>(end - start).count();
+    }
+
+    static unsigned long long counter()
+    {
+#if defined(BENCHMARK_HAVE_TSC)
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    static bool haveCounter()
+    {
+#if defined(BENCHMARK_HAVE_TSC)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    static double percentile(std::vector<double> values, double fraction)
+    {
+        std::sort(values.begin(), values.end());
+        size_t index = (size_t)(fraction * (values.size() - 1) + 0.5);
+        return values[std::min(index, values.size() - 1)];
+    }
+
+    static std::string compiler()
+    {
+#if defined(__clang__)
+        return std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+        return std::string("gcc ") + __VERSION__;
+#elif defined(_MSC_VER)
+        return "msvc " + std::to_string(_MSC_VER);
+#else
+        return "unknown";
+#endif
+    }
+
+    void print(const BenchmarkResult &r) const
+    {
+        char line[256];
+        std::snprintf(line, sizeof(line), "%-44s %12.1f ns median %12.1f ns p95 %10.2f ns/item %12.1f items/s %9.1f cycles/item",
+            r.Name.c_str(), r.MedianNs, r.P95Ns, r.NsPerItem, 1e9 / r.NsPerItem, r.CyclesPerItem);
+        std::printf("%s", line);
+        if (r.Bytes > 0.0)
+            std::printf(" %9.1f MB/s", r.Bytes / r.MedianNs * 1e3);
+        std::printf("\n");
+        std::fflush(stdout);
+    }
+};
+
+#endif
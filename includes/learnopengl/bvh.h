@@ -0,0 +1,460 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/frustum.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <vector>
+
+// Result of BVH::Raycast
+struct RayHit {
+    int Proxy;      // -1 if nothing was hit
+    float Distance; // along the ray, in units of the direction's length
+};
+
+// Bounding volume hierarchy over axis aligned boxes (proxies). The tree is built top down with the
+// surface area heuristic. Moving a proxy refits the boxes on the path from its leaf to the root, so
+// moving objects stay in the tree without a rebuild; Maintain rebuilds when proxies were added or
+// removed, or when refitting has made the tree noticeably worse than it was when it was built.
+// Frustum, radius and ray queries visit O(log n) nodes for well separated objects.
+class BVH
+{
+public:
+    // leaves hold at most this many proxies
+    static const int MAX_LEAF_SIZE = 4;
+
+    BVH() : NeedsBuild(false), BuildCost(0.0f), Moved(false), Stale(false)
+    {
+    }
+
+    // adds a box carrying 'userData', returns its proxy. The tree is rebuilt by the next Maintain or query.
+    int Insert(const AABB &bounds, unsigned int userData)
+    {
+        Proxy proxy;
+        proxy.Bounds = bounds;
+        proxy.UserData = userData;
+        proxy.Alive = true;
+        proxy.Leaf = -1;
+        NeedsBuild = true;
+        if (!FreeProxies.empty())
+        {
+            int index = FreeProxies.back();
+            FreeProxies.pop_back();
+            Proxies[index] = proxy;
+            return index;
+        }
+        Proxies.push_back(proxy);
+        return Proxies.size() - 1;
+    }
+
+    void Remove(int proxy)
+    {
+        Proxies[proxy].Alive = false;
+        FreeProxies.push_back(proxy);
+        NeedsBuild = true;
+    }
+
+    // gives the proxy new bounds and refits the tree above it
+    void Move(int proxy, const AABB &bounds)
+    {
+        Proxies[proxy].Bounds = bounds;
+        if (NeedsBuild || Proxies[proxy].Leaf < 0)
+            return;
+        Moved = true;
+        for (int node = Proxies[proxy].Leaf; node >= 0; node = Nodes[node].Parent)
+            refitNode(node);
+    }
+
+    // removes every proxy, keeping the storage
+    void Clear()
+    {
+        Proxies.clear();
+        FreeProxies.clear();
+        Nodes.clear();
+        Primitives.clear();
+        NeedsBuild = false;
+        Moved = false;
+        Stale = false;
+        BuildCost = 0.0f;
+    }
+
+    // gives the proxy new bounds but leaves the tree alone until the next Maintain or query, which
+    // refits every node once. Cheaper than Move when a large share of the proxies moves every frame.
+    void SetBounds(int proxy, const AABB &bounds)
+    {
+        Proxies[proxy].Bounds = bounds;
+        Stale = true;
+    }
+
+    unsigned int UserData(int proxy) const
+    {
+        return Proxies[proxy].UserData;
+    }
+
+    const AABB &Bounds(int proxy) const
+    {
+        return Proxies[proxy].Bounds;
+    }
+
+    // rebuilds the tree if proxies were added or removed, or if moves degraded it by more than half
+    void Maintain()
+    {
+        if (NeedsBuild)
+            Build();
+        else if (Stale)
+        {
+            // children are stored after their parents, so a backward pass refits bottom up
+            for (int i = Nodes.size() - 1; i >= 0; i--)
+                refitNode(i);
+            Stale = false;
+            Moved = true;
+        }
+        if (Moved)
+        {
+            Moved = false;
+            if (cost() > BuildCost * 1.5f)
+                Build();
+        }
+    }
+
+    // builds the tree from scratch
+    void Build()
+    {
+        Nodes.clear();
+        Primitives.clear();
+        for (unsigned int i = 0; i < Proxies.size(); i++)
+        {
+            Proxies[i].Leaf = -1;
+            if (Proxies[i].Alive)
+                Primitives.push_back(i);
+        }
+        NeedsBuild = false;
+        Moved = false;
+        Stale = false;
+        if (!Primitives.empty())
+            buildNode(-1, 0, Primitives.size());
+        BuildCost = cost();
+    }
+
+    // appends the proxies whose boxes intersect 'frustum' to 'result'
+    void QueryFrustum(const Frustum &frustum, std::vector<int> &result)
+    {
+        Maintain();
+        if (Nodes.empty())
+            return;
+        Stack.clear();
+        Stack.push_back(0);
+        while (!Stack.empty())
+        {
+            const Node &node = Nodes[Stack.back()];
+            Stack.pop_back();
+            if (!frustum.Intersects(node.Bounds))
+                continue;
+            if (node.Count > 0)
+            {
+                for (int i = node.First; i < node.First + node.Count; i++)
+                    if (frustum.Intersects(Proxies[Primitives[i]].Bounds))
+                        result.push_back(Primitives[i]);
+            }
+            else
+            {
+                Stack.push_back(node.Left);
+                Stack.push_back(node.Right);
+            }
+        }
+    }
+
+    // appends the proxies whose boxes are within 'radius' of 'center' to 'result'
+    void QueryRadius(const glm::vec3 &center, float radius, std::vector<int> &result)
+    {
+        Maintain();
+        if (Nodes.empty())
+            return;
+        float radiusSquared = radius * radius;
+        Stack.clear();
+        Stack.push_back(0);
+        while (!Stack.empty())
+        {
+            const Node &node = Nodes[Stack.back()];
+            Stack.pop_back();
+            if (distanceSquared(node.Bounds, center) > radiusSquared)
+                continue;
+            if (node.Count > 0)
+            {
+                for (int i = node.First; i < node.First + node.Count; i++)
+                    if (distanceSquared(Proxies[Primitives[i]].Bounds, center) <= radiusSquared)
+                        result.push_back(Primitives[i]);
+            }
+            else
+            {
+                Stack.push_back(node.Left);
+                Stack.push_back(node.Right);
+            }
+        }
+    }
+
+    // closest proxy box hit by the ray origin + t * direction with 0 <= t <= maxDistance
+    RayHit Raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance = FLT_MAX)
+    {
+        Maintain();
+        RayHit hit;
+        hit.Proxy = -1;
+        hit.Distance = maxDistance;
+        if (Nodes.empty())
+            return hit;
+        glm::vec3 inverse(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+        Stack.clear();
+        Stack.push_back(0);
+        while (!Stack.empty())
+        {
+            const Node &node = Nodes[Stack.back()];
+            Stack.pop_back();
+            float t;
+            if (!intersectRay(node.Bounds, origin, inverse, hit.Distance, t))
+                continue;
+            if (node.Count > 0)
+            {
+                for (int i = node.First; i < node.First + node.Count; i++)
+                {
+                    if (intersectRay(Proxies[Primitives[i]].Bounds, origin, inverse, hit.Distance, t))
+                    {
+                        hit.Proxy = Primitives[i];
+                        hit.Distance = t;
+                    }
+                }
+            }
+            else
+            {
+                // visit the nearer child first so the farther one is more likely to be pruned
+                float tLeft, tRight;
+                bool left = intersectRay(Nodes[node.Left].Bounds, origin, inverse, hit.Distance, tLeft);
+                bool right = intersectRay(Nodes[node.Right].Bounds, origin, inverse, hit.Distance, tRight);
+                if (left && right)
+                {
+                    Stack.push_back(tLeft <= tRight ? node.Right : node.Left);
+                    Stack.push_back(tLeft <= tRight ? node.Left : node.Right);
+                }
+                else if (left)
+                    Stack.push_back(node.Left);
+                else if (right)
+                    Stack.push_back(node.Right);
+            }
+        }
+        return hit;
+    }
+
+    // number of nodes, for statistics
+    size_t NodeCount() const
+    {
+        return Nodes.size();
+    }
+
+private:
+    struct Proxy {
+        AABB Bounds;
+        unsigned int UserData;
+        bool Alive;
+        int Leaf; // node holding the proxy, -1 before the first build
+    };
+
+    // interior nodes have Count == 0 and two children, leaves a range of Primitives
+    struct Node {
+        AABB Bounds;
+        int Parent;
+        int Left, Right;
+        int First, Count;
+    };
+
+    std::vector<Proxy> Proxies;
+    std::vector<int> FreeProxies;
+    std::vector<Node> Nodes;
+    std::vector<int> Primitives; // proxy indices, grouped by leaf
+    std::vector<int> Stack;
+    bool NeedsBuild;
+    float BuildCost;
+    bool Moved;
+    bool Stale; // proxies got new bounds through SetBounds
+
+    static float area(const AABB &box)
+    {
+        glm::vec3 size = glm::max(box.Max - box.Min, glm::vec3(0.0f));
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    static AABB merge(const AABB &a, const AABB &b)
+    {
+        return AABB(glm::min(a.Min, b.Min), glm::max(a.Max, b.Max));
+    }
+
+    static float distanceSquared(const AABB &box, const glm::vec3 &point)
+    {
+        glm::vec3 closest = glm::clamp(point, box.Min, box.Max);
+        glm::vec3 offset = point - closest;
+        return glm::dot(offset, offset);
+    }
+
+    // slab test, 'entry' receives the distance at which the ray enters the box
+    static bool intersectRay(const AABB &box, const glm::vec3 &origin, const glm::vec3 &inverse, float maxDistance, float &entry)
+    {
+        glm::vec3 t0 = (box.Min - origin) * inverse;
+        glm::vec3 t1 = (box.Max - origin) * inverse;
+        glm::vec3 tNear = glm::min(t0, t1);
+        glm::vec3 tFar = glm::max(t0, t1);
+        float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+        entry = enter;
+        return enter <= exit;
+    }
+
+    // sum of the interior nodes' surface areas relative to the root's, the SAH cost of the tree
+    float cost() const
+    {
+        if (Nodes.empty())
+            return 0.0f;
+        float rootArea = std::max(area(Nodes[0].Bounds), FLT_MIN);
+        float total = 0.0f;
+        for (unsigned int i = 0; i < Nodes.size(); i++)
+            total += Nodes[i].Count > 0 ? area(Nodes[i].Bounds) * Nodes[i].Count : area(Nodes[i].Bounds);
+        return total / rootArea;
+    }
+
+    void refitNode(int index)
+    {
+        Node &node = Nodes[index];
+        if (node.Count > 0)
+        {
+            node.Bounds = Proxies[Primitives[node.First]].Bounds;
+            for (int i = node.First + 1; i < node.First + node.Count; i++)
+                node.Bounds = merge(node.Bounds, Proxies[Primitives[i]].Bounds);
+        }
+        else
+            node.Bounds = merge(Nodes[node.Left].Bounds, Nodes[node.Right].Bounds);
+    }
+
+    // builds the subtree over Primitives[first, last), returns its node
+    int buildNode(int parent, int first, int last)
+    {
+        int index = Nodes.size();
+        Nodes.push_back(Node());
+        Nodes[index].Parent = parent;
+        Nodes[index].Left = Nodes[index].Right = -1;
+
+        AABB bounds = Proxies[Primitives[first]].Bounds;
+        AABB centroids;
+        for (int i = first; i < last; i++)
+        {
+            const AABB &box = Proxies[Primitives[i]].Bounds;
+            bounds = merge(bounds, box);
+            centroids.Extend((box.Min + box.Max) * 0.5f);
+        }
+        Nodes[index].Bounds = bounds;
+
+        int count = last - first;
+        int split = count > MAX_LEAF_SIZE ? findSplit(first, last, centroids) : -1;
+        if (split < 0)
+        {
+            Nodes[index].First = first;
+            Nodes[index].Count = count;
+            for (int i = first; i < last; i++)
+                Proxies[Primitives[i]].Leaf = index;
+            return index;
+        }
+        Nodes[index].First = 0;
+        Nodes[index].Count = 0;
+        int left = buildNode(index, first, split);
+        int right = buildNode(index, split, last);
+        Nodes[index].Left = left;
+        Nodes[index].Right = right;
+        return index;
+    }
+
+    // binned SAH: partitions Primitives[first, last) at the cheapest of 12 candidate planes per axis
+    // and returns the split point
+    int findSplit(int first, int last, const AABB &centroids)
+    {
+        const int BINS = 12;
+        int count = last - first;
+        float bestCost = FLT_MAX;
+        int bestAxis = -1, bestBin = 0;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float extent = centroids.Max[axis] - centroids.Min[axis];
+            if (extent <= 0.0f)
+                continue;
+            AABB binBounds[BINS];
+            int binCounts[BINS] = { 0 };
+            for (int i = first; i < last; i++)
+            {
+                const AABB &box = Proxies[Primitives[i]].Bounds;
+                int bin = binIndex((box.Min[axis] + box.Max[axis]) * 0.5f, centroids.Min[axis], extent, BINS);
+                binCounts[bin]++;
+                binBounds[bin].Extend(box.Min);
+                binBounds[bin].Extend(box.Max);
+            }
+            // sweep from both sides to get the cost of every split plane
+            float rightArea[BINS];
+            int rightCount[BINS];
+            AABB accumulated;
+            int accumulatedCount = 0;
+            for (int b = BINS - 1; b > 0; b--)
+            {
+                accumulated = binCounts[b] ? merge(accumulated, binBounds[b]) : accumulated;
+                accumulatedCount += binCounts[b];
+                rightArea[b] = accumulatedCount ? area(accumulated) : 0.0f;
+                rightCount[b] = accumulatedCount;
+            }
+            accumulated = AABB();
+            accumulatedCount = 0;
+            for (int b = 0; b < BINS - 1; b++)
+            {
+                accumulated = binCounts[b] ? merge(accumulated, binBounds[b]) : accumulated;
+                accumulatedCount += binCounts[b];
+                if (accumulatedCount == 0 || rightCount[b + 1] == 0)
+                    continue;
+                float splitCost = area(accumulated) * accumulatedCount + rightArea[b + 1] * rightCount[b + 1];
+                if (splitCost < bestCost)
+                {
+                    bestCost = splitCost;
+                    bestAxis = axis;
+                    bestBin = b;
+                }
+            }
+        }
+
+        // all centroids coincide, split by count
+        if (bestAxis < 0)
+            return first + count / 2;
+
+        float minimum = centroids.Min[bestAxis];
+        float extent = centroids.Max[bestAxis] - minimum;
+        std::vector<int>::iterator middle = std::partition(Primitives.begin() + first, Primitives.begin() + last, BinPredicate(this, bestAxis, minimum, extent, bestBin, BINS));
+        return middle - Primitives.begin();
+    }
+
+    static int binIndex(float centroid, float minimum, float extent, int bins)
+    {
+        int bin = (int)((centroid - minimum) / extent * bins);
+        return std::min(std::max(bin, 0), bins - 1);
+    }
+
+    // true for proxies left of the split plane after bin 'Bin'
+    struct BinPredicate {
+        const BVH *Tree;
+        int Axis;
+        float Minimum, Extent;
+        int Bin, Bins;
+
+        BinPredicate(const BVH *tree, int axis, float minimum, float extent, int bin, int bins)
+            : Tree(tree), Axis(axis), Minimum(minimum), Extent(extent), Bin(bin), Bins(bins) {}
+
+        bool operator()(int proxy) const
+        {
+            const AABB &box = Tree->Proxies[proxy].Bounds;
+            return binIndex((box.Min[Axis] + box.Max[Axis]) * 0.5f, Minimum, Extent, Bins) <= Bin;
+        }
+    };
+};
+#endif
@@ -5,6 +5,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <learnopengl/frustum.h>
+
 #include <vector>
 
 // Defines several possible options for camera movement. Used as abstraction to stay away from window-system specific input methods
@@ -22,6 +24,7 @@ const float PITCH       =  0.0f;
 const float SPEED       =  2.5f;
 const float SENSITIVITY =  0.1f;
 const float ZOOM        =  45.0f;
+const float JUMP_SPEED  =  6.0f;  // units per second going up and coming down
 
 // An abstract camera class that processes input and calculates the corresponding Euler Angles, Vectors and Matrices for use in OpenGL
 class Camera
@@ -72,6 +75,12 @@ public:
         return glm::lookAt(Position, Position + Front, Up);
     }
 
+    // Returns the planes of the view frustum for the given projection matrix, in world space
+    Frustum GetFrustum(const glm::mat4 &projection)
+    {
+        return Frustum(projection * GetViewMatrix());
+    }
+
     // Processes input received from any keyboard-like input system. Accepts input parameter in the form of camera defined ENUM (to abstract it from windowing systems)
     void ProcessKeyboard(Camera_Movement direction, float deltaTime)
     {
@@ -92,9 +101,10 @@ public:
         }
     }
 
-    //jump function                                                                 
-    void jump()
+    //jump function, advances a jump started by ProcessKeyboard(JUMP) by deltaTime seconds
+    void jump(float deltaTime)
     {
+        float velocity = JUMP_SPEED * deltaTime;
         if(CurrJumping)
         {
             if ((JumpGoal - Position.y) < 0.01f )
@@ -102,13 +112,13 @@ public:
                 Falling = true;
                 CurrJumping = false;
             }
-            Position.y += 0.1;
+            Position.y += velocity;
         }
         else if (Falling)
         {
             if ((Position.y - 1.0f) < 0.01f) // 1.0f represents floor value
                 Falling = false;
-            Position.y -= 0.1;
+            Position.y -= velocity;
         }
     }
     // Processes input received from a mouse input system. Expects the offset value in both the x and y direction.
@@ -144,6 +154,14 @@ public:
             Zoom = 45.0f;
     }
 
+    // Points the camera at the given Euler angles, for scripted cameras
+    void SetOrientation(float yaw, float pitch)
+    {
+        Yaw = yaw;
+        Pitch = pitch;
+        updateCameraVectors();
+    }
+
 private:
     // Calculates the front vector from the Camera's (updated) Euler Angles
     void updateCameraVectors()
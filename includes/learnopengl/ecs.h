@@ -0,0 +1,370 @@
+#ifndef ECS_H
+#define ECS_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+// Handle of an entity. The generation changes every time the slot is reused, so handles of
+// destroyed entities are recognised as stale.
+struct Entity {
+    unsigned int Index;
+    unsigned int Generation;
+
+    bool operator==(const Entity &other) const
+    {
+        return Index == other.Index && Generation == other.Generation;
+    }
+    bool operator!=(const Entity &other) const
+    {
+        return !(*this == other);
+    }
+};
+
+// one bit per component type, so a world supports up to 64 of them
+typedef unsigned long long ComponentMask;
+
+// Archetype based entity component system. All entities with exactly the same set of components
+// share an archetype, which keeps every component type in its own dense array (structure of arrays),
+// so a system touching two components of ten thousand entities walks two contiguous arrays.
+// Components are moved around with memcpy and must be plain data (no pointers to themselves, no
+// destructors that matter). Adding or removing a component moves the entity to another archetype;
+// none of that may happen inside Each.
+//
+//   Entity e = world.Create(Transform(), Velocity());
+//   world.Each<Transform, Velocity>([&](Entity e, Transform &t, Velocity &v) { t.Position += v.Value * dt; });
+class EntityWorld
+{
+public:
+    EntityWorld() : Alive(0)
+    {
+        std::memset(ComponentSizes, 0, sizeof(ComponentSizes));
+    }
+
+    template <typename... C>
+    Entity Create(const C &... components)
+    {
+        Entity entity = allocate();
+        int archetype = archetypeFor(registerTypes<C...>());
+        unsigned int row = pushRow(archetype, entity);
+        int expand[] = { 0, (write(archetype, row, components), 0)... };
+        (void)expand;
+        return entity;
+    }
+
+    void Destroy(Entity entity)
+    {
+        assert(IsAlive(entity));
+        Record &record = Records[entity.Index];
+        removeRow(record.Archetype, record.Row);
+        record.Archetype = -1;
+        record.Generation++;
+        FreeSlots.push_back(entity.Index);
+        Alive--;
+    }
+
+    bool IsAlive(Entity entity) const
+    {
+        return entity.Index < Records.size() && Records[entity.Index].Generation == entity.Generation && Records[entity.Index].Archetype >= 0;
+    }
+
+    template <typename C>
+    bool Has(Entity entity) const
+    {
+        return IsAlive(entity) && (Archetypes[Records[entity.Index].Archetype].Mask & bit<C>()) != 0;
+    }
+
+    template <typename C>
+    C &Get(Entity entity)
+    {
+        assert(Has<C>(entity));
+        const Record &record = Records[entity.Index];
+        return column<C>(Archetypes[record.Archetype])[record.Row];
+    }
+
+    // adds (or overwrites) a component
+    template <typename C>
+    void Add(Entity entity, const C &component)
+    {
+        assert(IsAlive(entity));
+        if (Has<C>(entity))
+        {
+            Get<C>(entity) = component;
+            return;
+        }
+        Record &record = Records[entity.Index];
+        move(entity, archetypeFor(Archetypes[record.Archetype].Mask | registerTypes<C>()));
+        write(record.Archetype, record.Row, component);
+    }
+
+    template <typename C>
+    void Remove(Entity entity)
+    {
+        if (!Has<C>(entity))
+            return;
+        move(entity, archetypeFor(Archetypes[Records[entity.Index].Archetype].Mask & ~bit<C>()));
+    }
+
+    // calls f(Entity, C&...) for every entity that has all of C...
+    template <typename... C, typename F>
+    void Each(F f)
+    {
+        ComponentMask mask = maskOf<C...>();
+        for (unsigned int i = 0; i < Archetypes.size(); i++)
+        {
+            Archetype &archetype = Archetypes[i];
+            if ((archetype.Mask & mask) == mask && !archetype.Entities.empty())
+                iterate(archetype.Entities.size(), &archetype.Entities[0], f, column<C>(archetype)...);
+        }
+    }
+
+    // calls f(count, entities, C*...) once per archetype that has all of C..., with the archetype's
+    // dense arrays, for systems that split the work themselves (across threads for instance)
+    template <typename... C, typename F>
+    void EachArray(F f)
+    {
+        ComponentMask mask = maskOf<C...>();
+        for (unsigned int i = 0; i < Archetypes.size(); i++)
+        {
+            Archetype &archetype = Archetypes[i];
+            if ((archetype.Mask & mask) == mask && !archetype.Entities.empty())
+                f(archetype.Entities.size(), (const Entity*)&archetype.Entities[0], column<C>(archetype)...);
+        }
+    }
+
+    // number of entities that have all of C...
+    template <typename... C>
+    size_t Count() const
+    {
+        ComponentMask mask = maskOf<C...>();
+        size_t count = 0;
+        for (unsigned int i = 0; i < Archetypes.size(); i++)
+            if ((Archetypes[i].Mask & mask) == mask)
+                count += Archetypes[i].Entities.size();
+        return count;
+    }
+
+    // first entity that has all of C..., or an invalid handle
+    template <typename... C>
+    Entity First() const
+    {
+        ComponentMask mask = maskOf<C...>();
+        for (unsigned int i = 0; i < Archetypes.size(); i++)
+            if ((Archetypes[i].Mask & mask) == mask && !Archetypes[i].Entities.empty())
+                return Archetypes[i].Entities[0];
+        Entity none = { 0xFFFFFFFF, 0 };
+        return none;
+    }
+
+    // destroys every entity at once. The archetypes keep their storage, so the world fills up again
+    // without allocating.
+    void Clear()
+    {
+        for (unsigned int i = 0; i < Archetypes.size(); i++)
+        {
+            Archetypes[i].Entities.clear();
+            for (unsigned int c = 0; c < Archetypes[i].Columns.size(); c++)
+                Archetypes[i].Columns[c].clear();
+        }
+        FreeSlots.clear();
+        for (unsigned int i = 0; i < Records.size(); i++)
+        {
+            if (Records[i].Archetype >= 0)
+                Records[i].Generation++;
+            Records[i].Archetype = -1;
+            FreeSlots.push_back(Records.size() - 1 - i);
+        }
+        Alive = 0;
+    }
+
+    size_t Size() const
+    {
+        return Alive;
+    }
+
+private:
+    static const int MAX_COMPONENT_TYPES = 64;
+
+    struct Archetype {
+        ComponentMask Mask;
+        int ColumnOf[MAX_COMPONENT_TYPES];              // -1 if the archetype lacks the component
+        std::vector<unsigned int> Types;                // component type of every column
+        std::vector<std::vector<unsigned char> > Columns;
+        std::vector<Entity> Entities;                   // entity of every row
+    };
+
+    struct Record {
+        int Archetype; // -1 if the slot is free
+        unsigned int Row;
+        unsigned int Generation;
+    };
+
+    std::vector<Archetype> Archetypes;
+    std::vector<Record> Records;
+    std::vector<unsigned int> FreeSlots;
+    size_t ComponentSizes[MAX_COMPONENT_TYPES];
+    size_t Alive;
+
+    static unsigned int nextType()
+    {
+        static unsigned int next = 0;
+        assert(next < MAX_COMPONENT_TYPES);
+        return next++;
+    }
+
+    // component types are numbered in the order they are first used, shared by every world
+    template <typename C>
+    static unsigned int typeOf()
+    {
+        static unsigned int type = nextType();
+        return type;
+    }
+
+    template <typename C>
+    static ComponentMask bit()
+    {
+        return 1ULL << typeOf<C>();
+    }
+
+    template <typename... C>
+    static ComponentMask maskOf()
+    {
+        ComponentMask mask = 0;
+        int expand[] = { 0, (mask |= bit<C>(), 0)... };
+        (void)expand;
+        return mask;
+    }
+
+    // remembers the component sizes, archetypes only know their components by mask
+    template <typename... C>
+    ComponentMask registerTypes()
+    {
+        int expand[] = { 0, (ComponentSizes[typeOf<C>()] = sizeof(C), 0)... };
+        (void)expand;
+        return maskOf<C...>();
+    }
+
+    template <typename C>
+    C *column(Archetype &archetype)
+    {
+        std::vector<unsigned char> &data = archetype.Columns[archetype.ColumnOf[typeOf<C>()]];
+        return data.empty() ? NULL : (C*)&data[0];
+    }
+
+    template <typename C>
+    const C *column(const Archetype &archetype) const
+    {
+        const std::vector<unsigned char> &data = archetype.Columns[archetype.ColumnOf[typeOf<C>()]];
+        return data.empty() ? NULL : (const C*)&data[0];
+    }
+
+    template <typename C>
+    void write(int archetype, unsigned int row, const C &component)
+    {
+        std::memcpy(&column<C>(Archetypes[archetype])[row], &component, sizeof(C));
+    }
+
+    template <typename F, typename... C>
+    static void iterate(size_t count, const Entity *entities, F &f, C *... columns)
+    {
+        for (size_t i = 0; i < count; i++)
+            f(entities[i], columns[i]...);
+    }
+
+    Entity allocate()
+    {
+        Entity entity;
+        if (!FreeSlots.empty())
+        {
+            entity.Index = FreeSlots.back();
+            FreeSlots.pop_back();
+        }
+        else
+        {
+            entity.Index = Records.size();
+            Record record = { -1, 0, 0 };
+            Records.push_back(record);
+        }
+        entity.Generation = Records[entity.Index].Generation;
+        Alive++;
+        return entity;
+    }
+
+    int archetypeFor(ComponentMask mask)
+    {
+        for (unsigned int i = 0; i < Archetypes.size(); i++)
+            if (Archetypes[i].Mask == mask)
+                return i;
+        Archetype archetype;
+        archetype.Mask = mask;
+        for (int type = 0; type < MAX_COMPONENT_TYPES; type++)
+        {
+            archetype.ColumnOf[type] = -1;
+            if (mask & (1ULL << type))
+            {
+                archetype.ColumnOf[type] = archetype.Columns.size();
+                archetype.Types.push_back(type);
+                archetype.Columns.push_back(std::vector<unsigned char>());
+            }
+        }
+        Archetypes.push_back(archetype);
+        return Archetypes.size() - 1;
+    }
+
+    // appends an uninitialised row for 'entity' and points its record at it
+    unsigned int pushRow(int index, Entity entity)
+    {
+        Archetype &archetype = Archetypes[index];
+        unsigned int row = archetype.Entities.size();
+        archetype.Entities.push_back(entity);
+        for (unsigned int c = 0; c < archetype.Columns.size(); c++)
+            archetype.Columns[c].resize((row + 1) * ComponentSizes[archetype.Types[c]]);
+        Records[entity.Index].Archetype = index;
+        Records[entity.Index].Row = row;
+        return row;
+    }
+
+    // removes a row by moving the last one into its place
+    void removeRow(int index, unsigned int row)
+    {
+        Archetype &archetype = Archetypes[index];
+        unsigned int last = archetype.Entities.size() - 1;
+        if (row != last)
+        {
+            for (unsigned int c = 0; c < archetype.Columns.size(); c++)
+            {
+                size_t size = ComponentSizes[archetype.Types[c]];
+                std::memcpy(&archetype.Columns[c][row * size], &archetype.Columns[c][last * size], size);
+            }
+            archetype.Entities[row] = archetype.Entities[last];
+            Records[archetype.Entities[row].Index].Row = row;
+        }
+        archetype.Entities.pop_back();
+        for (unsigned int c = 0; c < archetype.Columns.size(); c++)
+            archetype.Columns[c].resize(last * ComponentSizes[archetype.Types[c]]);
+    }
+
+    // moves the entity to another archetype, carrying over the components both have in common
+    void move(Entity entity, int target)
+    {
+        Record &record = Records[entity.Index];
+        int source = record.Archetype;
+        unsigned int sourceRow = record.Row;
+        unsigned int row = pushRow(target, entity);
+        Archetype &from = Archetypes[source];
+        Archetype &to = Archetypes[target];
+        for (unsigned int c = 0; c < to.Columns.size(); c++)
+        {
+            int sourceColumn = from.ColumnOf[to.Types[c]];
+            if (sourceColumn < 0)
+                continue;
+            size_t size = ComponentSizes[to.Types[c]];
+            std::memcpy(&to.Columns[c][row * size], &from.Columns[sourceColumn][sourceRow * size], size);
+        }
+        removeRow(source, sourceRow);
+        record.Archetype = target;
+        record.Row = row;
+    }
+};
+#endif
@@ -0,0 +1,203 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define FRUSTUM_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRUSTUM_SSE 1
+#endif
+
+// Axis aligned bounding box
+struct AABB {
+    glm::vec3 Min;
+    glm::vec3 Max;
+
+    AABB() : Min(FLT_MAX), Max(-FLT_MAX) {}
+    AABB(const glm::vec3 &min, const glm::vec3 &max) : Min(min), Max(max) {}
+
+    // grows the box to contain 'point'
+    void Extend(const glm::vec3 &point)
+    {
+        Min = glm::min(Min, point);
+        Max = glm::max(Max, point);
+    }
+
+    // box in the space 'transform' maps into that contains this box (Arvo's method)
+    AABB Transformed(const glm::mat4 &transform) const
+    {
+        glm::vec3 center = (Min + Max) * 0.5f;
+        glm::vec3 extents = (Max - Min) * 0.5f;
+        glm::vec3 newCenter = glm::vec3(transform * glm::vec4(center, 1.0f));
+        glm::vec3 newExtents;
+        for (int i = 0; i < 3; i++)
+            newExtents[i] = std::fabs(transform[0][i]) * extents.x + std::fabs(transform[1][i]) * extents.y + std::fabs(transform[2][i]) * extents.z;
+        return AABB(newCenter - newExtents, newCenter + newExtents);
+    }
+};
+
+// The six planes of a view frustum as (normal, distance), normals pointing inwards, so a point p
+// is inside if dot(plane.xyz, p) + plane.w >= 0 for every plane.
+struct Frustum {
+    glm::vec4 Planes[6];
+
+    Frustum() {}
+
+    // extracts the planes from a combined projection * view matrix (Gribb & Hartmann)
+    explicit Frustum(const glm::mat4 &viewProjection)
+    {
+        glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+        glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+        glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+        glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+        Planes[0] = row3 + row0; // left
+        Planes[1] = row3 - row0; // right
+        Planes[2] = row3 + row1; // bottom
+        Planes[3] = row3 - row1; // top
+        Planes[4] = row3 + row2; // near
+        Planes[5] = row3 - row2; // far
+        for (int i = 0; i < 6; i++)
+            Planes[i] /= glm::length(glm::vec3(Planes[i]));
+    }
+
+    // scalar reference test, true if the box is at least partially inside
+    bool Intersects(const AABB &box) const
+    {
+        glm::vec3 center = (box.Min + box.Max) * 0.5f;
+        glm::vec3 extents = (box.Max - box.Min) * 0.5f;
+        for (int i = 0; i < 6; i++)
+        {
+            glm::vec3 normal(Planes[i]);
+            float distance = glm::dot(normal, center) + Planes[i].w;
+            float radius = glm::dot(glm::abs(normal), extents);
+            if (distance + radius < 0.0f)
+                return false;
+        }
+        return true;
+    }
+};
+
+// Boxes stored as centers and extents in separate arrays so the culling pass can test
+// 4 (SSE) or 8 (AVX) of them per iteration. The arrays are padded to a multiple of 8.
+class BoundsList
+{
+public:
+    std::vector<float> CenterX, CenterY, CenterZ;
+    std::vector<float> ExtentX, ExtentY, ExtentZ;
+
+    BoundsList() : Count(0) {}
+
+    // adds a box, returns its index
+    unsigned int Add(const AABB &box)
+    {
+        if (Count == CenterX.size())
+            resize(Count + 8);
+        glm::vec3 center = (box.Min + box.Max) * 0.5f;
+        glm::vec3 extents = (box.Max - box.Min) * 0.5f;
+        CenterX[Count] = center.x;
+        CenterY[Count] = center.y;
+        CenterZ[Count] = center.z;
+        ExtentX[Count] = extents.x;
+        ExtentY[Count] = extents.y;
+        ExtentZ[Count] = extents.z;
+        return Count++;
+    }
+
+    void Clear()
+    {
+        Count = 0;
+    }
+
+    unsigned int Size() const
+    {
+        return Count;
+    }
+
+private:
+    unsigned int Count;
+
+    void resize(unsigned int size)
+    {
+        CenterX.resize(size, 0.0f);
+        CenterY.resize(size, 0.0f);
+        CenterZ.resize(size, 0.0f);
+        ExtentX.resize(size, 0.0f);
+        ExtentY.resize(size, 0.0f);
+        ExtentZ.resize(size, 0.0f);
+    }
+};
+
+// Tests every box of 'bounds' against 'frustum' and writes the indices of the ones that are at least
+// partially inside to 'visible' (in order). Returns the number of boxes culled.
+inline unsigned int CullBounds(const Frustum &frustum, const BoundsList &bounds, std::vector<unsigned int> &visible)
+{
+    visible.clear();
+    unsigned int count = bounds.Size();
+    unsigned int i = 0;
+#if defined(FRUSTUM_AVX)
+    for (; i < count; i += 8)
+    {
+        __m256 cx = _mm256_loadu_ps(&bounds.CenterX[i]);
+        __m256 cy = _mm256_loadu_ps(&bounds.CenterY[i]);
+        __m256 cz = _mm256_loadu_ps(&bounds.CenterZ[i]);
+        __m256 ex = _mm256_loadu_ps(&bounds.ExtentX[i]);
+        __m256 ey = _mm256_loadu_ps(&bounds.ExtentY[i]);
+        __m256 ez = _mm256_loadu_ps(&bounds.ExtentZ[i]);
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            const glm::vec4 &plane = frustum.Planes[p];
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.x), cx), _mm256_mul_ps(_mm256_set1_ps(plane.y), cy)),
+                                            _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.z), cz), _mm256_set1_ps(plane.w)));
+            __m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(std::fabs(plane.x)), ex), _mm256_mul_ps(_mm256_set1_ps(std::fabs(plane.y)), ey)),
+                                          _mm256_mul_ps(_mm256_set1_ps(std::fabs(plane.z)), ez));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+        int mask = _mm256_movemask_ps(inside);
+        for (unsigned int j = 0; j < 8 && i + j < count; j++)
+            if (mask & (1 << j))
+                visible.push_back(i + j);
+    }
+#elif defined(FRUSTUM_SSE)
+    for (; i < count; i += 4)
+    {
+        __m128 cx = _mm_loadu_ps(&bounds.CenterX[i]);
+        __m128 cy = _mm_loadu_ps(&bounds.CenterY[i]);
+        __m128 cz = _mm_loadu_ps(&bounds.CenterZ[i]);
+        __m128 ex = _mm_loadu_ps(&bounds.ExtentX[i]);
+        __m128 ey = _mm_loadu_ps(&bounds.ExtentY[i]);
+        __m128 ez = _mm_loadu_ps(&bounds.ExtentZ[i]);
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            const glm::vec4 &plane = frustum.Planes[p];
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), cx), _mm_mul_ps(_mm_set1_ps(plane.y), cy)),
+                                         _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), cz), _mm_set1_ps(plane.w)));
+            __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(std::fabs(plane.x)), ex), _mm_mul_ps(_mm_set1_ps(std::fabs(plane.y)), ey)),
+                                       _mm_mul_ps(_mm_set1_ps(std::fabs(plane.z)), ez));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+        }
+        int mask = _mm_movemask_ps(inside);
+        for (unsigned int j = 0; j < 4 && i + j < count; j++)
+            if (mask & (1 << j))
+                visible.push_back(i + j);
+    }
+#else
+    for (; i < count; i++)
+    {
+        glm::vec3 center(bounds.CenterX[i], bounds.CenterY[i], bounds.CenterZ[i]);
+        glm::vec3 extents(bounds.ExtentX[i], bounds.ExtentY[i], bounds.ExtentZ[i]);
+        if (frustum.Intersects(AABB(center - extents, center + extents)))
+            visible.push_back(i);
+    }
+#endif
+    return count - visible.size();
+}
+#endif
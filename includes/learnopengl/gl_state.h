@@ -0,0 +1,230 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <glad/glad.h>
+
+// Shadows the OpenGL state the render loop touches most (program, vertex array, texture bindings,
+// active texture unit, depth/blend state and viewport) and drops calls that would not change it.
+// All code in the render path has to go through it; anything that changes this state behind its
+// back must call Invalidate afterwards. There is one instance for the (single) GL context.
+class GLState
+{
+public:
+    // number of calls forwarded to OpenGL and dropped as redundant since the last ResetStats
+    unsigned long long Issued;
+    unsigned long long Dropped;
+
+    static GLState &Get()
+    {
+        static GLState state;
+        return state;
+    }
+
+    // ------------------------------------------------------------------------
+    void UseProgram(unsigned int program)
+    {
+        if (Program == program)
+        {
+            Dropped++;
+            return;
+        }
+        glUseProgram(program);
+        Program = program;
+        Issued++;
+    }
+    // ------------------------------------------------------------------------
+    void BindVertexArray(unsigned int vao)
+    {
+        if (VAO == vao)
+        {
+            Dropped++;
+            return;
+        }
+        glBindVertexArray(vao);
+        VAO = vao;
+        Issued++;
+    }
+    // ------------------------------------------------------------------------
+    void ActiveTexture(GLenum unit)
+    {
+        if (ActiveUnit == unit)
+        {
+            Dropped++;
+            return;
+        }
+        glActiveTexture(unit);
+        ActiveUnit = unit;
+        Issued++;
+    }
+    // binds 'texture' to the active texture unit
+    void BindTexture(GLenum target, unsigned int texture)
+    {
+        int slot = targetSlot(target);
+        unsigned int unit = ActiveUnit - GL_TEXTURE0;
+        if (slot < 0 || unit >= MAX_UNITS)
+        {
+            // not shadowed, always forward
+            glBindTexture(target, texture);
+            Issued++;
+            return;
+        }
+        if (Textures[unit][slot] == texture)
+        {
+            Dropped++;
+            return;
+        }
+        glBindTexture(target, texture);
+        Textures[unit][slot] = texture;
+        Issued++;
+    }
+    // binds 'texture' to texture unit GL_TEXTURE0 + unit, only switching the active unit if needed
+    void BindTextureUnit(unsigned int unit, GLenum target, unsigned int texture)
+    {
+        int slot = targetSlot(target);
+        if (slot >= 0 && unit < MAX_UNITS && Textures[unit][slot] == texture)
+        {
+            Dropped++;
+            return;
+        }
+        ActiveTexture(GL_TEXTURE0 + unit);
+        BindTexture(target, texture);
+    }
+    // ------------------------------------------------------------------------
+    void Enable(GLenum capability)
+    {
+        setCapability(capability, true);
+    }
+    void Disable(GLenum capability)
+    {
+        setCapability(capability, false);
+    }
+    // ------------------------------------------------------------------------
+    void DepthFunc(GLenum func)
+    {
+        if (DepthFunction == func)
+        {
+            Dropped++;
+            return;
+        }
+        glDepthFunc(func);
+        DepthFunction = func;
+        Issued++;
+    }
+    void DepthMask(GLboolean flag)
+    {
+        if (DepthWrite == (int)flag)
+        {
+            Dropped++;
+            return;
+        }
+        glDepthMask(flag);
+        DepthWrite = flag;
+        Issued++;
+    }
+    // ------------------------------------------------------------------------
+    void BlendFunc(GLenum sfactor, GLenum dfactor)
+    {
+        if (BlendSrc == sfactor && BlendDst == dfactor)
+        {
+            Dropped++;
+            return;
+        }
+        glBlendFunc(sfactor, dfactor);
+        BlendSrc = sfactor;
+        BlendDst = dfactor;
+        Issued++;
+    }
+    // ------------------------------------------------------------------------
+    void Viewport(int x, int y, int width, int height)
+    {
+        if (ViewportRect[0] == x && ViewportRect[1] == y && ViewportRect[2] == width && ViewportRect[3] == height)
+        {
+            Dropped++;
+            return;
+        }
+        glViewport(x, y, width, height);
+        ViewportRect[0] = x;
+        ViewportRect[1] = y;
+        ViewportRect[2] = width;
+        ViewportRect[3] = height;
+        Issued++;
+    }
+
+    // forgets everything, the next call of every kind goes through to OpenGL
+    void Invalidate()
+    {
+        Program = INVALID;
+        VAO = INVALID;
+        ActiveUnit = INVALID;
+        for (unsigned int i = 0; i < MAX_UNITS; i++)
+            for (unsigned int j = 0; j < TARGET_COUNT; j++)
+                Textures[i][j] = INVALID;
+        DepthTest = -1;
+        Blend = -1;
+        DepthWrite = -1;
+        DepthFunction = INVALID;
+        BlendSrc = INVALID;
+        BlendDst = INVALID;
+        for (unsigned int i = 0; i < 4; i++)
+            ViewportRect[i] = -1;
+    }
+
+    void ResetStats()
+    {
+        Issued = 0;
+        Dropped = 0;
+    }
+
+private:
+    static const unsigned int INVALID = 0xFFFFFFFF;
+    static const unsigned int MAX_UNITS = 32;
+    static const unsigned int TARGET_COUNT = 4;
+
+    unsigned int Program;
+    unsigned int VAO;
+    unsigned int ActiveUnit;
+    unsigned int Textures[MAX_UNITS][TARGET_COUNT];
+    int DepthTest;
+    int Blend;
+    int DepthWrite;
+    unsigned int DepthFunction;
+    unsigned int BlendSrc, BlendDst;
+    int ViewportRect[4];
+
+    GLState()
+    {
+        Invalidate();
+        ResetStats();
+    }
+
+    // index of the shadowed binding point of a texture target, -1 if it is not shadowed
+    static int targetSlot(GLenum target)
+    {
+        switch (target)
+        {
+        case GL_TEXTURE_2D: return 0;
+        case GL_TEXTURE_2D_ARRAY: return 1;
+        case GL_TEXTURE_CUBE_MAP: return 2;
+        case GL_TEXTURE_3D: return 3;
+        default: return -1;
+        }
+    }
+
+    void setCapability(GLenum capability, bool enabled)
+    {
+        int *shadow = capability == GL_DEPTH_TEST ? &DepthTest : (capability == GL_BLEND ? &Blend : NULL);
+        if (shadow && *shadow == (int)enabled)
+        {
+            Dropped++;
+            return;
+        }
+        if (enabled)
+            glEnable(capability);
+        else
+            glDisable(capability);
+        if (shadow)
+            *shadow = enabled;
+        Issued++;
+    }
+};
+#endif
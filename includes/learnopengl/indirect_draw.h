@@ -0,0 +1,100 @@
+#ifndef INDIRECT_DRAW_H
+#define INDIRECT_DRAW_H
+
+#include <glad/glad.h>
+
+#include <vector>
+
+// Layout glDrawElementsIndirect and glMultiDrawElementsIndirect read from GL_DRAW_INDIRECT_BUFFER.
+struct DrawElementsIndirectCommand {
+    unsigned int Count;         // number of indices
+    unsigned int InstanceCount; // 0 skips the draw
+    unsigned int FirstIndex;    // in indices, not bytes
+    int BaseVertex;
+    unsigned int BaseInstance;
+};
+
+// A list of indexed draws recorded into a GPU buffer, so any number of meshes living in one vertex
+// and index buffer are drawn with a single glMultiDrawElementsIndirect and the CPU cost does not grow
+// with the number of meshes. Without GL 4.3 the same commands go through glMultiDrawElementsBaseVertex,
+// still one call, but instance counts above one and base instances are not supported there.
+class IndirectBuffer
+{
+public:
+    std::vector<DrawElementsIndirectCommand> Commands;
+    unsigned int Buffer;
+
+    IndirectBuffer() : Buffer(0), Uploaded(0)
+    {
+    }
+
+    // queues a command, returns its index
+    unsigned int Add(unsigned int count, unsigned int firstIndex, int baseVertex, unsigned int instanceCount = 1, unsigned int baseInstance = 0)
+    {
+        DrawElementsIndirectCommand command;
+        command.Count = count;
+        command.InstanceCount = instanceCount;
+        command.FirstIndex = firstIndex;
+        command.BaseVertex = baseVertex;
+        command.BaseInstance = baseInstance;
+        Commands.push_back(command);
+        return Commands.size() - 1;
+    }
+
+    // copies Commands into the GPU buffer, call again after changing them
+    void Upload()
+    {
+        if (!GLAD_GL_VERSION_4_3 || Commands.empty())
+            return;
+        if (Buffer == 0)
+            glGenBuffers(1, &Buffer);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, Buffer);
+        size_t size = Commands.size() * sizeof(DrawElementsIndirectCommand);
+        if (Commands.size() > Uploaded)
+            glBufferData(GL_DRAW_INDIRECT_BUFFER, size, &Commands[0], GL_DYNAMIC_DRAW);
+        else
+            glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, size, &Commands[0]);
+        Uploaded = Commands.size();
+    }
+
+    // draws commands first .. first + count - 1 with unsigned int indices. The VAO holding the
+    // vertex and index buffer the commands refer to has to be bound.
+    void Draw(GLenum mode, unsigned int first, unsigned int count)
+    {
+        if (count == 0)
+            return;
+        if (GLAD_GL_VERSION_4_3)
+        {
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, Buffer);
+            glMultiDrawElementsIndirect(mode, GL_UNSIGNED_INT, (void*)(first * sizeof(DrawElementsIndirectCommand)), count, 0);
+            return;
+        }
+        Counts.clear();
+        Offsets.clear();
+        BaseVertices.clear();
+        for (unsigned int i = first; i < first + count; i++)
+        {
+            if (Commands[i].InstanceCount == 0)
+                continue;
+            Counts.push_back(Commands[i].Count);
+            Offsets.push_back((const void*)(Commands[i].FirstIndex * sizeof(unsigned int)));
+            BaseVertices.push_back(Commands[i].BaseVertex);
+        }
+        if (!Counts.empty())
+            glMultiDrawElementsBaseVertex(mode, &Counts[0], GL_UNSIGNED_INT, &Offsets[0], Counts.size(), &BaseVertices[0]);
+    }
+
+    // draws every command
+    void Draw(GLenum mode)
+    {
+        Draw(mode, 0, Commands.size());
+    }
+
+private:
+    size_t Uploaded;
+    // arguments of the GL 3.3 fallback
+    std::vector<GLsizei> Counts;
+    std::vector<const void*> Offsets;
+    std::vector<GLint> BaseVertices;
+};
+#endif
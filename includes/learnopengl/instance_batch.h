@@ -0,0 +1,171 @@
+#ifndef INSTANCE_BATCH_H
+#define INSTANCE_BATCH_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/gl_state.h>
+#include <learnopengl/matrix_kernels.h>
+#include <learnopengl/ring_buffer.h>
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+// Per-instance data streamed next to a shared mesh. The model matrix takes
+// four consecutive attribute locations (one per column), the material index one more
+// and the normal matrix, filled in on upload, the three after that.
+struct InstanceData {
+    glm::mat4 Model;
+    unsigned int Material;
+    glm::mat3 Normal;
+};
+
+// Collects instances of a single mesh for one frame and draws them with one
+// glDrawArraysInstanced call per material (or a single one when the shader reads the
+// material per instance), so a scene built out of the same mesh costs a handful of
+// draw calls no matter how many parts it is made of. The instance data is streamed
+// through a RingBuffer, so Draw has to be called between its BeginFrame and EndFrame.
+class InstanceBatch
+{
+public:
+    // number of draw calls issued by the last Draw call
+    unsigned int DrawCalls;
+
+    // constructor, attaches the instance data to the given VAO starting at attribute 'location'
+    // (locations location .. location + 3 receive the model matrix, location + 4 the material index,
+    // location + 5 .. location + 7 the normal matrix)
+    InstanceBatch(unsigned int vao, RingBuffer &ring, unsigned int materialCount, unsigned int location = 3)
+        : DrawCalls(0), VAO(vao), Location(location), Ring(ring), Base(0), Count(0), Groups(materialCount)
+    {
+        GLState::Get().BindVertexArray(VAO);
+        for (unsigned int i = 0; i < 4; i++)
+        {
+            glEnableVertexAttribArray(Location + i);
+            glVertexAttribDivisor(Location + i, 1);
+        }
+        glEnableVertexAttribArray(Location + 4);
+        glVertexAttribDivisor(Location + 4, 1);
+        for (unsigned int i = 5; i < 8; i++)
+        {
+            glEnableVertexAttribArray(Location + i);
+            glVertexAttribDivisor(Location + i, 1);
+        }
+        setAttribPointers(0);
+        GLState::Get().BindVertexArray(0);
+    }
+
+    // queues one instance of the mesh for this frame
+    void Add(unsigned int material, const glm::mat4 &model)
+    {
+        InstanceData instance;
+        instance.Model = model;
+        instance.Material = material;
+        Groups[material].push_back(instance);
+    }
+
+    // uploads all queued instances and draws them grouped by material. 'bindMaterial' is called
+    // once per non-empty material before its draw so the caller can bind the matching textures.
+    // The shader has to be active before calling this.
+    template <typename BindMaterial>
+    void Draw(GLenum mode, unsigned int vertexCount, BindMaterial bindMaterial)
+    {
+        DrawCalls = 0;
+        if (!upload())
+            return;
+
+        GLState::Get().BindVertexArray(VAO);
+        size_t first = 0;
+        for (unsigned int i = 0; i < Groups.size(); i++)
+        {
+            size_t count = Groups[i].size();
+            if (count == 0)
+                continue;
+            bindMaterial(i);
+            // GL 3.3 has no base instance, so point the instance attributes at the start of the group instead
+            setAttribPointers(first);
+            glDrawArraysInstanced(mode, 0, vertexCount, (GLsizei)count);
+            DrawCalls++;
+            first += count;
+            Groups[i].clear();
+        }
+    }
+
+    // uploads all queued instances and draws them with a single call. Only for shaders that pick
+    // the textures of each instance from its material index themselves.
+    void Draw(GLenum mode, unsigned int vertexCount)
+    {
+        DrawCalls = 0;
+        if (!upload())
+            return;
+
+        GLState::Get().BindVertexArray(VAO);
+        setAttribPointers(0);
+        glDrawArraysInstanced(mode, 0, vertexCount, (GLsizei)Count);
+        DrawCalls++;
+        for (unsigned int i = 0; i < Groups.size(); i++)
+            Groups[i].clear();
+    }
+
+    // number of instances queued so far this frame
+    size_t Size() const
+    {
+        size_t total = 0;
+        for (unsigned int i = 0; i < Groups.size(); i++)
+            total += Groups[i].size();
+        return total;
+    }
+
+private:
+    unsigned int VAO;
+    unsigned int Location;
+    RingBuffer &Ring;
+    // offset of this frame's instances in the ring and how many there are
+    size_t Base;
+    size_t Count;
+    std::vector<std::vector<InstanceData> > Groups;
+
+    // lays all groups out back to back in this frame's slot of the ring, returns false if there is nothing to draw
+    bool upload()
+    {
+        Count = Size();
+        if (Count == 0)
+            return false;
+
+        RingAllocation allocation = Ring.Allocate(Count * sizeof(InstanceData), sizeof(glm::vec4));
+        if (!allocation.Pointer)
+        {
+            for (unsigned int i = 0; i < Groups.size(); i++)
+                Groups[i].clear();
+            return false;
+        }
+        // normal matrices batched per group, so the vertex shader does not invert the model matrix per
+        // vertex. They are filled in on the CPU side, the mapping is write only and written exactly once.
+        InstanceData *instances = (InstanceData*)allocation.Pointer;
+        for (unsigned int i = 0; i < Groups.size(); i++)
+        {
+            std::vector<InstanceData> &group = Groups[i];
+            if (group.empty())
+                continue;
+            MatrixKernels::Active().NormalMatrices(&group[0].Model, sizeof(InstanceData), &group[0].Normal, sizeof(InstanceData), group.size());
+            std::memcpy(instances, &group[0], group.size() * sizeof(InstanceData));
+            instances += group.size();
+        }
+        Ring.Flush();
+        Base = allocation.Offset;
+        return true;
+    }
+
+    // points the instance attributes at instance 'first' of this frame's data, expects the VAO to be bound
+    void setAttribPointers(size_t first)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, Ring.Buffer);
+        size_t base = Base + first * sizeof(InstanceData);
+        for (unsigned int i = 0; i < 4; i++)
+            glVertexAttribPointer(Location + i, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(base + offsetof(InstanceData, Model) + i * sizeof(glm::vec4)));
+        glVertexAttribIPointer(Location + 4, 1, GL_UNSIGNED_INT, sizeof(InstanceData), (void*)(base + offsetof(InstanceData, Material)));
+        for (unsigned int i = 0; i < 3; i++)
+            glVertexAttribPointer(Location + 5 + i, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(base + offsetof(InstanceData, Normal) + i * sizeof(glm::vec3)));
+    }
+};
+#endif
@@ -0,0 +1,317 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Counts the jobs started with it that have not finished yet, JobSystem::Wait blocks on it
+struct JobCounter {
+    std::atomic<int> Pending;
+
+    JobCounter() : Pending(0)
+    {
+    }
+};
+
+// Work stealing thread pool. Every worker owns a deque: it pushes and pops jobs at the back of its
+// own deque (newest first, the data is still in cache) and, once that is empty, steals the oldest
+// job from the front of somebody else's. The thread that created the pool takes part through
+// queue 0 whenever it waits, so a pool without workers still runs everything, just serially.
+// One pool per program; the queue a thread uses is kept in a thread local.
+class JobSystem
+{
+public:
+    typedef std::function<void()> Job;
+
+    // jobs run and how many of them were taken from another thread's deque
+    std::atomic<unsigned long long> Executed;
+    std::atomic<unsigned long long> Stolen;
+
+    // 'workers' threads besides the calling one, by default one less than the hardware has
+    explicit JobSystem(int workers = -1) : Executed(0), Stolen(0), Queued(0), Quit(false)
+    {
+        if (workers < 0)
+            workers = std::max(1u, std::thread::hardware_concurrency()) - 1;
+        for (int i = 0; i <= workers; i++)
+            Queues.push_back(std::unique_ptr<Queue>(new Queue()));
+        for (int i = 1; i <= workers; i++)
+            Threads.push_back(std::thread(&JobSystem::workerLoop, this, i));
+    }
+
+    ~JobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock(SleepLock);
+            Quit = true;
+        }
+        Wake.notify_all();
+        for (unsigned int i = 0; i < Threads.size(); i++)
+            Threads[i].join();
+    }
+
+    int WorkerCount() const
+    {
+        return Threads.size();
+    }
+
+    // queues 'job' on the calling thread's deque, 'counter' drops back once it finished
+    void Run(const Job &job, JobCounter &counter)
+    {
+        counter.Pending++;
+        Queue &queue = *Queues[currentQueue()];
+        {
+            std::lock_guard<std::mutex> lock(queue.Lock);
+            queue.Tasks.push_back(Task(job, &counter));
+        }
+        Queued++;
+        {
+            std::lock_guard<std::mutex> lock(SleepLock);
+        }
+        Wake.notify_one();
+    }
+
+    // runs jobs, its own or stolen ones, until every job of 'counter' finished
+    void Wait(JobCounter &counter)
+    {
+        while (counter.Pending > 0)
+            if (!RunOne())
+                std::this_thread::yield();
+    }
+
+    // runs a single queued job on the calling thread, false if there was none
+    bool RunOne()
+    {
+        int own = currentQueue();
+        Task task;
+        if (!pop(own, task) && !steal(own, task))
+            return false;
+        task.Work();
+        Executed++;
+        task.Counter->Pending--;
+        return true;
+    }
+
+    // calls f(first, last) for consecutive ranges of at most 'grain' items covering [begin, end)
+    // and returns once all of them are done
+    template <typename F>
+    void ParallelFor(size_t begin, size_t end, size_t grain, const F &f)
+    {
+        if (grain == 0)
+            grain = 1;
+        if (end - begin <= grain || Threads.empty())
+        {
+            if (begin < end)
+                f(begin, end);
+            return;
+        }
+        JobCounter counter;
+        for (size_t first = begin; first < end; first += grain)
+        {
+            size_t last = std::min(first + grain, end);
+            Run([&f, first, last]() { f(first, last); }, counter);
+        }
+        Wait(counter);
+    }
+
+private:
+    struct Task {
+        Job Work;
+        JobCounter *Counter;
+
+        Task() : Counter(NULL)
+        {
+        }
+        Task(const Job &work, JobCounter *counter) : Work(work), Counter(counter)
+        {
+        }
+    };
+
+    struct Queue {
+        std::mutex Lock;
+        std::deque<Task> Tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue> > Queues; // 0 belongs to the thread that created the pool
+    std::vector<std::thread> Threads;
+    std::atomic<int> Queued; // jobs sitting in any deque, idle workers sleep while it is 0
+    std::mutex SleepLock;
+    std::condition_variable Wake;
+    bool Quit;
+
+    static int &currentQueue()
+    {
+        static thread_local int queue = 0;
+        return queue;
+    }
+
+    // newest job of the thread's own deque
+    bool pop(int index, Task &task)
+    {
+        Queue &queue = *Queues[index];
+        std::lock_guard<std::mutex> lock(queue.Lock);
+        if (queue.Tasks.empty())
+            return false;
+        task = queue.Tasks.back();
+        queue.Tasks.pop_back();
+        Queued--;
+        return true;
+    }
+
+    // oldest job of any other deque, the victims are tried round robin starting after the thief
+    bool steal(int thief, Task &task)
+    {
+        for (unsigned int i = 1; i < Queues.size(); i++)
+        {
+            Queue &queue = *Queues[(thief + i) % Queues.size()];
+            std::lock_guard<std::mutex> lock(queue.Lock);
+            if (queue.Tasks.empty())
+                continue;
+            task = queue.Tasks.front();
+            queue.Tasks.pop_front();
+            Queued--;
+            Stolen++;
+            return true;
+        }
+        return false;
+    }
+
+    void workerLoop(int index)
+    {
+        currentQueue() = index;
+        while (true)
+        {
+            if (RunOne())
+                continue;
+            std::unique_lock<std::mutex> lock(SleepLock);
+            Wake.wait(lock, [this]() { return Quit || Queued > 0; });
+            if (Quit)
+                return;
+        }
+    }
+};
+
+// Tasks of a frame and what each of them has to wait for. The graph is built once, Run executes
+// it on a JobSystem as often as needed: every task starts as soon as the tasks it depends on are
+// done, tasks marked MAIN_THREAD (everything touching OpenGL or the window) only ever run on the
+// thread calling Run, the rest wherever a worker is free.
+class TaskGraph
+{
+public:
+    enum Affinity {
+        ANY_THREAD,
+        MAIN_THREAD
+    };
+
+    TaskGraph() : RemainingSize(0), Finished(0)
+    {
+    }
+
+    // returns the task's index for Depend
+    int Add(const std::string &name, const std::function<void()> &work, Affinity affinity = ANY_THREAD)
+    {
+        Node node;
+        node.Name = name;
+        node.Work = work;
+        node.Where = affinity;
+        node.Dependencies = 0;
+        Nodes.push_back(node);
+        return Nodes.size() - 1;
+    }
+
+    // 'task' may only start once 'dependency' finished
+    void Depend(int task, int dependency)
+    {
+        Nodes[dependency].Dependents.push_back(task);
+        Nodes[task].Dependencies++;
+    }
+
+    const std::string &Name(int task) const
+    {
+        return Nodes[task].Name;
+    }
+
+    // runs every task once, returns when all of them finished. Call from the main thread.
+    void Run(JobSystem &jobs)
+    {
+        if (!Remaining || RemainingSize != Nodes.size())
+        {
+            Remaining.reset(new std::atomic<int>[Nodes.size()]);
+            RemainingSize = Nodes.size();
+        }
+        for (unsigned int i = 0; i < Nodes.size(); i++)
+            Remaining[i] = Nodes[i].Dependencies;
+        Finished = 0;
+        for (unsigned int i = 0; i < Nodes.size(); i++)
+            if (Nodes[i].Dependencies == 0)
+                schedule(jobs, i);
+        while (Finished < (int)Nodes.size())
+        {
+            int task = popMainThread();
+            if (task >= 0)
+                execute(jobs, task);
+            else if (!jobs.RunOne())
+                std::this_thread::yield();
+        }
+        // the last jobs may still be on their way out of JobSystem::RunOne
+        jobs.Wait(Pending);
+    }
+
+private:
+    struct Node {
+        std::string Name;
+        std::function<void()> Work;
+        Affinity Where;
+        int Dependencies;
+        std::vector<int> Dependents;
+    };
+
+    std::vector<Node> Nodes;
+    std::unique_ptr<std::atomic<int>[]> Remaining; // unfinished dependencies of every task
+    size_t RemainingSize;
+    std::atomic<int> Finished;
+    JobCounter Pending;
+    std::mutex MainLock;
+    std::vector<int> MainReady; // MAIN_THREAD tasks whose dependencies are done
+
+    void schedule(JobSystem &jobs, int task)
+    {
+        if (Nodes[task].Where == MAIN_THREAD)
+        {
+            std::lock_guard<std::mutex> lock(MainLock);
+            MainReady.push_back(task);
+        }
+        else
+            jobs.Run([this, &jobs, task]() { execute(jobs, task); }, Pending);
+    }
+
+    void execute(JobSystem &jobs, int task)
+    {
+        Nodes[task].Work();
+        for (unsigned int i = 0; i < Nodes[task].Dependents.size(); i++)
+        {
+            int dependent = Nodes[task].Dependents[i];
+            if (--Remaining[dependent] == 0)
+                schedule(jobs, dependent);
+        }
+        Finished++;
+    }
+
+    int popMainThread()
+    {
+        std::lock_guard<std::mutex> lock(MainLock);
+        if (MainReady.empty())
+            return -1;
+        int task = MainReady.back();
+        MainReady.pop_back();
+        return task;
+    }
+};
+#endif
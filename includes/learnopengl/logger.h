@@ -0,0 +1,427 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+
+enum LogLevel {
+    LEVEL_TRACE,
+    LEVEL_DEBUG,
+    LEVEL_INFO,
+    LEVEL_WARNING,
+    LEVEL_ERROR
+};
+
+enum LogCategory {
+    CATEGORY_GENERAL,
+    CATEGORY_RENDER,
+    CATEGORY_GAME,
+    CATEGORY_ASSETS,
+    LOG_CATEGORY_COUNT
+};
+
+// One entry of the logger's ring: a formatted message, a telemetry sample or a telemetry channel
+// definition. Fixed size so the ring never allocates.
+struct LogRecord {
+    static const unsigned int TEXT_SIZE = 224;
+    static const unsigned int MAX_VALUES = 16;
+    enum Kind { MESSAGE, SAMPLE, CHANNEL };
+
+    long long Time;
+    unsigned int Suppressed; // messages the callsite held back since its last one
+    unsigned int Frame;
+    int Thread;
+    unsigned short Channel;
+    unsigned char Type, Level, Category, Count;
+    union {
+        char Text[TEXT_SIZE];
+        float Values[MAX_VALUES];
+    };
+};
+
+// Holds back a callsite that logs more often than once per interval. Lives in a static at the
+// callsite, see LOG_EVERY, and counts what it held back so the next message can say so.
+class LogRateLimit
+{
+public:
+    explicit LogRateLimit(double seconds) : Interval((long long)(seconds * 1e9)), Next(0), Suppressed(0) { }
+
+    // true if the callsite may log at 'now', 'suppressed' is then set to how many it held back
+    bool Allow(long long now, unsigned int &suppressed)
+    {
+        long long next = Next.load(std::memory_order_relaxed);
+        if (now < next || !Next.compare_exchange_strong(next, now + Interval, std::memory_order_relaxed))
+        {
+            Suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        suppressed = Suppressed.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    long long Interval;
+    std::atomic<long long> Next;
+    std::atomic<unsigned int> Suppressed;
+};
+
+// Asynchronous logger. Any thread formats its message into a slot of a lock-free ring of
+// RING_SIZE records (a bounded multi-producer single-consumer queue, each slot has a sequence
+// number telling whether it is free or written) and goes on; a background thread takes the
+// records out in order and does the writing. Callers never wait and never touch a file: when the
+// ring is full the record is dropped and counted, and the writer reports the drops.
+//
+// Messages below Level or in a disabled category cost a branch. Telemetry samples are a few floats
+// per channel and frame, written in binary to the file given to OpenTelemetry:
+//
+//   "LOGLTLM1"                                          file header
+//   'C' u16 channel, u8 components, u8 length, name     a channel, before its first sample
+//   'S' u16 channel, u32 frame, f32 x components        a sample
+//
+// in the machine's byte order. Without a telemetry file samples are not even queued.
+//
+//   LOG_INFO(CATEGORY_GAME, "restarted after %d seconds", seconds);
+//   LOG_EVERY(1.0, LEVEL_DEBUG, CATEGORY_RENDER, "linear: %g", linear); // at most once a second
+//   unsigned int player = Logger::Get().Channel("player", 3);
+//   Logger::Get().Sample(player, frame, &position[0]);
+class Logger
+{
+public:
+    static const unsigned int RING_SIZE = 4096;
+
+    static Logger &Get()
+    {
+        static Logger logger;
+        return logger;
+    }
+
+    LogLevel Level;
+    std::atomic<unsigned long long> Dropped; // records lost to a full ring
+
+    // nanoseconds since the logger started
+    long long Now() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Start).count();
+    }
+
+    bool Enabled(LogLevel level, LogCategory category) const
+    {
+        return level >= Level && (CategoryMask & (1u << category)) != 0;
+    }
+
+    void EnableCategory(LogCategory category, bool enable)
+    {
+        if (enable)
+            CategoryMask |= 1u << category;
+        else
+            CategoryMask &= ~(1u << category);
+    }
+
+    // messages go to 'output' from then on, stdout by default
+    void SetOutput(FILE *output)
+    {
+        Flush();
+        Output = output;
+    }
+
+    void Log(LogLevel level, LogCategory category, const char *format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        logv(level, category, 0, format, args);
+        va_end(args);
+    }
+
+    // as Log, noting how many messages the callsite's rate limit held back
+    void LogSuppressed(LogLevel level, LogCategory category, unsigned int suppressed, const char *format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        logv(level, category, suppressed, format, args);
+        va_end(args);
+    }
+
+    // opens the telemetry file, channels defined before are written to it first
+    bool OpenTelemetry(const char *path)
+    {
+        Flush();
+        Telemetry = std::fopen(path, "wb");
+        if (!Telemetry)
+            return false;
+        std::fwrite("LOGLTLM1", 1, 8, Telemetry);
+        for (unsigned int i = 0; i < ChannelCount; i++)
+            writeChannel(i);
+        TelemetryOpen.store(true, std::memory_order_release);
+        return true;
+    }
+
+    bool TelemetryEnabled() const
+    {
+        return TelemetryOpen.load(std::memory_order_relaxed);
+    }
+
+    // defines a channel of up to MAX_VALUES floats per sample, call from one thread before sampling it
+    unsigned int Channel(const char *name, unsigned int components)
+    {
+        if (ChannelCount == MAX_CHANNELS)
+            return MAX_CHANNELS - 1;
+        unsigned int channel = ChannelCount++;
+        std::strncpy(ChannelNames[channel], name, sizeof(ChannelNames[channel]) - 1);
+        ChannelComponents[channel] = (unsigned char)std::min(components, LogRecord::MAX_VALUES);
+        if (TelemetryEnabled())
+        {
+            Slot *slot = acquire();
+            if (!slot)
+                return channel;
+            slot->Record.Type = LogRecord::CHANNEL;
+            slot->Record.Channel = (unsigned short)channel;
+            publish(slot);
+        }
+        return channel;
+    }
+
+    void Sample(unsigned int channel, unsigned int frame, const float *values)
+    {
+        if (!TelemetryEnabled())
+            return;
+        Slot *slot = acquire();
+        if (!slot)
+            return;
+        LogRecord &record = slot->Record;
+        record.Type = LogRecord::SAMPLE;
+        record.Channel = (unsigned short)channel;
+        record.Frame = frame;
+        record.Count = ChannelComponents[channel];
+        std::memcpy(record.Values, values, record.Count * sizeof(float));
+        publish(slot);
+    }
+
+    // waits until everything queued so far is written out
+    void Flush()
+    {
+        unsigned long long target = EnqueuePos.load(std::memory_order_acquire);
+        while (Written.load(std::memory_order_acquire) < target)
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    static const char *LevelName(LogLevel level)
+    {
+        static const char *names[] = { "TRACE", "DEBUG", "INFO", "WARN", "ERROR" };
+        return names[level];
+    }
+
+    static const char *CategoryName(LogCategory category)
+    {
+        static const char *names[] = { "general", "render", "game", "assets" };
+        return names[category];
+    }
+
+    // "trace", "debug", "info", "warning" or "error"
+    static bool ParseLevel(const std::string &name, LogLevel &level)
+    {
+        static const char *names[] = { "trace", "debug", "info", "warning", "error" };
+        for (int i = 0; i <= LEVEL_ERROR; i++)
+        {
+            if (name == names[i])
+            {
+                level = (LogLevel)i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    struct Slot {
+        std::atomic<unsigned long long> Sequence;
+        LogRecord Record;
+    };
+
+    static const unsigned int MAX_CHANNELS = 64;
+
+    std::chrono::steady_clock::time_point Start;
+    unsigned int CategoryMask;
+    FILE *Output;
+    FILE *Telemetry;
+    std::atomic<bool> TelemetryOpen;
+    Slot *Slots;
+    std::atomic<unsigned long long> EnqueuePos;
+    unsigned long long DequeuePos; // only the writer touches it
+    std::atomic<unsigned long long> Written;
+    unsigned long long ReportedDrops;
+    std::atomic<bool> Quit;
+    std::thread Writer;
+    std::atomic<int> NextThread;
+    unsigned int ChannelCount;
+    char ChannelNames[MAX_CHANNELS][32];
+    unsigned char ChannelComponents[MAX_CHANNELS];
+
+    Logger() : Level(LEVEL_INFO), Dropped(0), Start(std::chrono::steady_clock::now()), CategoryMask(~0u),
+        Output(stdout), Telemetry(NULL), TelemetryOpen(false), Slots(new Slot[RING_SIZE]), EnqueuePos(0),
+        DequeuePos(0), Written(0), ReportedDrops(0), Quit(false), NextThread(0), ChannelCount(0)
+    {
+        std::memset(ChannelNames, 0, sizeof(ChannelNames));
+        for (unsigned int i = 0; i < RING_SIZE; i++)
+            Slots[i].Sequence.store(i, std::memory_order_relaxed);
+        Writer = std::thread(&Logger::writerLoop, this);
+    }
+
+    ~Logger()
+    {
+        Quit.store(true, std::memory_order_release);
+        Writer.join();
+        if (Telemetry)
+            std::fclose(Telemetry);
+        delete[] Slots;
+    }
+
+    int currentThread()
+    {
+        static thread_local int thread = NextThread++;
+        return thread;
+    }
+
+    // claims the next free slot, NULL if the ring is full
+    Slot *acquire()
+    {
+        unsigned long long pos = EnqueuePos.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Slot &slot = Slots[pos & (RING_SIZE - 1)];
+            unsigned long long sequence = slot.Sequence.load(std::memory_order_acquire);
+            long long difference = (long long)(sequence - pos);
+            if (difference == 0)
+            {
+                if (EnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    slot.Record.Time = Now();
+                    slot.Record.Thread = currentThread();
+                    return &slot;
+                }
+            }
+            else if (difference < 0)
+            {
+                Dropped.fetch_add(1, std::memory_order_relaxed);
+                return NULL;
+            }
+            else
+                pos = EnqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    // hands a filled slot to the writer
+    void publish(Slot *slot)
+    {
+        unsigned long long pos = slot->Sequence.load(std::memory_order_relaxed);
+        slot->Sequence.store(pos + 1, std::memory_order_release);
+    }
+
+    void logv(LogLevel level, LogCategory category, unsigned int suppressed, const char *format, va_list args)
+    {
+        Slot *slot = acquire();
+        if (!slot)
+            return;
+        LogRecord &record = slot->Record;
+        record.Type = LogRecord::MESSAGE;
+        record.Level = (unsigned char)level;
+        record.Category = (unsigned char)category;
+        record.Suppressed = suppressed;
+        std::vsnprintf(record.Text, LogRecord::TEXT_SIZE, format, args);
+        publish(slot);
+    }
+
+    void writerLoop()
+    {
+        for (;;)
+        {
+            bool quitting = Quit.load(std::memory_order_acquire);
+            unsigned int written = 0;
+            for (;;)
+            {
+                Slot &slot = Slots[DequeuePos & (RING_SIZE - 1)];
+                if (slot.Sequence.load(std::memory_order_acquire) != DequeuePos + 1)
+                    break;
+                write(slot.Record);
+                slot.Sequence.store(DequeuePos + RING_SIZE, std::memory_order_release);
+                DequeuePos++;
+                written++;
+            }
+            unsigned long long dropped = Dropped.load(std::memory_order_relaxed);
+            if (dropped != ReportedDrops)
+            {
+                std::fprintf(Output, "[logger] %llu records dropped, the ring was full\n", dropped - ReportedDrops);
+                ReportedDrops = dropped;
+            }
+            if (written > 0)
+            {
+                std::fflush(Output);
+                if (TelemetryEnabled())
+                    std::fflush(Telemetry);
+                Written.store(DequeuePos, std::memory_order_release);
+            }
+            else if (quitting)
+                break;
+            else
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    void write(const LogRecord &record)
+    {
+        if (record.Type == LogRecord::MESSAGE)
+        {
+            std::fprintf(Output, "[%10.4f] %-5s %s: %s", record.Time * 1e-9, LevelName((LogLevel)record.Level),
+                CategoryName((LogCategory)record.Category), record.Text);
+            if (record.Suppressed > 0)
+                std::fprintf(Output, " (%u more suppressed)", record.Suppressed);
+            std::fputc('\n', Output);
+        }
+        else if (record.Type == LogRecord::CHANNEL && TelemetryEnabled())
+            writeChannel(record.Channel);
+        else if (TelemetryEnabled())
+        {
+            unsigned short channel = record.Channel;
+            std::fputc('S', Telemetry);
+            std::fwrite(&channel, sizeof(channel), 1, Telemetry);
+            std::fwrite(&record.Frame, sizeof(record.Frame), 1, Telemetry);
+            std::fwrite(record.Values, sizeof(float), record.Count, Telemetry);
+        }
+    }
+
+    void writeChannel(unsigned int channel)
+    {
+        unsigned short id = (unsigned short)channel;
+        unsigned char length = (unsigned char)std::strlen(ChannelNames[channel]);
+        std::fputc('C', Telemetry);
+        std::fwrite(&id, sizeof(id), 1, Telemetry);
+        std::fputc(ChannelComponents[channel], Telemetry);
+        std::fputc(length, Telemetry);
+        std::fwrite(ChannelNames[channel], 1, length, Telemetry);
+    }
+};
+
+// logs unless the level or the category is filtered out, the arguments are not evaluated then
+#define LOG(level, category, ...) \
+    do { if (Logger::Get().Enabled(level, category)) Logger::Get().Log(level, category, __VA_ARGS__); } while (0)
+#define LOG_TRACE(category, ...) LOG(LEVEL_TRACE, category, __VA_ARGS__)
+#define LOG_DEBUG(category, ...) LOG(LEVEL_DEBUG, category, __VA_ARGS__)
+#define LOG_INFO(category, ...) LOG(LEVEL_INFO, category, __VA_ARGS__)
+#define LOG_WARNING(category, ...) LOG(LEVEL_WARNING, category, __VA_ARGS__)
+#define LOG_ERROR(category, ...) LOG(LEVEL_ERROR, category, __VA_ARGS__)
+
+// logs at most once every 'seconds' from this callsite, for messages in loops that run every frame
+#define LOG_EVERY(seconds, level, category, ...) \
+    do { \
+        static LogRateLimit logRateLimit(seconds); \
+        unsigned int logSuppressed = 0; \
+        if (Logger::Get().Enabled(level, category) && logRateLimit.Allow(Logger::Get().Now(), logSuppressed)) \
+            Logger::Get().LogSuppressed(level, category, logSuppressed, __VA_ARGS__); \
+    } while (0)
+
+#endif
@@ -0,0 +1,541 @@
+#ifndef MATRIX_KERNELS_H
+#define MATRIX_KERNELS_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <learnopengl/frustum.h>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MATRIX_KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define MATRIX_KERNELS_TARGET(isa)
+#else
+// lets the SSE4.1 and AVX2 kernels be compiled into any build, they only run on CPUs that have them
+#define MATRIX_KERNELS_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+enum SimdLevel {
+    SIMD_SCALAR,
+    SIMD_SSE41,
+    SIMD_AVX2
+};
+
+// T * R * S with the rotation matrix written out from the quaternion, instead of building the three
+// matrices and multiplying them together
+inline glm::mat4 ComposeTRS(const glm::vec3 &translation, const glm::quat &rotation, const glm::vec3 &scale)
+{
+    float xx = rotation.x * rotation.x, yy = rotation.y * rotation.y, zz = rotation.z * rotation.z;
+    float xy = rotation.x * rotation.y, xz = rotation.x * rotation.z, yz = rotation.y * rotation.z;
+    float wx = rotation.w * rotation.x, wy = rotation.w * rotation.y, wz = rotation.w * rotation.z;
+    glm::mat4 result;
+    result[0] = glm::vec4((1.0f - 2.0f * (yy + zz)) * scale.x, 2.0f * (xy + wz) * scale.x, 2.0f * (xz - wy) * scale.x, 0.0f);
+    result[1] = glm::vec4(2.0f * (xy - wz) * scale.y, (1.0f - 2.0f * (xx + zz)) * scale.y, 2.0f * (yz + wx) * scale.y, 0.0f);
+    result[2] = glm::vec4(2.0f * (xz + wy) * scale.z, 2.0f * (yz - wx) * scale.z, (1.0f - 2.0f * (xx + yy)) * scale.z, 0.0f);
+    result[3] = glm::vec4(translation, 1.0f);
+    return result;
+}
+
+// One implementation of every batched kernel. All arrays hold 'count' elements and inputs and
+// outputs may not overlap.
+struct MatrixKernelSet {
+    SimdLevel Level;
+    const char *Name;
+    // out[i] = a[i] * b[i]
+    void (*Multiply)(const glm::mat4 *a, const glm::mat4 *b, glm::mat4 *out, size_t count);
+    // out[i] = parent * local[i], for the children of one node
+    void (*MultiplyParent)(const glm::mat4 &parent, const glm::mat4 *local, glm::mat4 *out, size_t count);
+    // out[i] = ComposeTRS(translation[i], rotation[i], scale[i])
+    void (*ComposeTRS)(const glm::vec3 *translation, const glm::quat *rotation, const glm::vec3 *scale, glm::mat4 *out, size_t count);
+    // normal matrices, transpose(inverse(mat3(model))), of affine transforms. The strides are in
+    // bytes so the matrices can sit inside larger structs (per instance data, ...).
+    void (*NormalMatrices)(const glm::mat4 *models, size_t modelStride, glm::mat3 *normals, size_t normalStride, size_t count);
+    // out[i] = transform * (points[i], 1)
+    void (*TransformPoints)(const glm::mat4 &transform, const glm::vec3 *points, glm::vec3 *out, size_t count);
+    // out[i] = box.Transformed(transforms[i])
+    void (*TransformBounds)(const glm::mat4 *transforms, const AABB &box, AABB *out, size_t count);
+};
+
+// Batched matrix kernels for the transform hot paths, with a scalar reference implementation and
+// SSE4.1 and AVX2 (+FMA) versions picked at runtime from what the CPU supports. The SIMD versions
+// follow the reference's order of operations; the AVX2 ones use fused multiply-adds and therefore
+// differ from it in the last bits. The LOGL_SIMD environment variable (scalar, sse4.1 or avx2)
+// caps the level, so results and timings can be compared without rebuilding.
+//
+//   MatrixKernels::Active().MultiplyParent(parent, &locals[0], &world[0], locals.size());
+class MatrixKernels
+{
+public:
+    // kernels of the best level the CPU supports (and LOGL_SIMD allows), chosen on first use
+    static const MatrixKernelSet &Active()
+    {
+        return *current();
+    }
+
+    // the scalar implementation every other one is checked against by logl_bench --check
+    static const MatrixKernelSet &Reference()
+    {
+        return set(SIMD_SCALAR);
+    }
+
+    // highest level this CPU can run
+    static SimdLevel Supported()
+    {
+        static SimdLevel level = detect();
+        return level;
+    }
+
+    // switches Active to 'level', or to the highest supported one below it
+    static void Select(SimdLevel level)
+    {
+        current() = &set(level > Supported() ? Supported() : level);
+    }
+
+private:
+    static const MatrixKernelSet *&current()
+    {
+        static const MatrixKernelSet *active = &set(requested());
+        return active;
+    }
+
+    static SimdLevel requested()
+    {
+        SimdLevel level = Supported();
+        const char *name = std::getenv("LOGL_SIMD");
+        if (name && std::strcmp(name, "scalar") == 0)
+            level = SIMD_SCALAR;
+        else if (name && std::strcmp(name, "sse4.1") == 0 && level > SIMD_SSE41)
+            level = SIMD_SSE41;
+        return level;
+    }
+
+    static const MatrixKernelSet &set(SimdLevel level)
+    {
+        static const MatrixKernelSet scalar = { SIMD_SCALAR, "scalar", multiplyScalar, multiplyParentScalar, composeScalar, normalsScalar, pointsScalar, boundsScalar };
+#if defined(MATRIX_KERNELS_X86)
+        static const MatrixKernelSet sse41 = { SIMD_SSE41, "sse4.1", multiplySSE41, multiplyParentSSE41, composeSSE41, normalsSSE41, pointsSSE41, boundsSSE41 };
+        static const MatrixKernelSet avx2 = { SIMD_AVX2, "avx2", multiplyAVX2, multiplyParentAVX2, composeAVX2, normalsAVX2, pointsAVX2, boundsAVX2 };
+        if (level == SIMD_AVX2)
+            return avx2;
+        if (level == SIMD_SSE41)
+            return sse41;
+#endif
+        return scalar;
+    }
+
+    static SimdLevel detect()
+    {
+#if defined(MATRIX_KERNELS_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 0);
+        int leaves = info[0];
+        __cpuid(info, 1);
+        bool sse41 = (info[2] & (1 << 19)) != 0;
+        bool fma = (info[2] & (1 << 12)) != 0;
+        // the OS has to save the YMM registers for AVX to be usable
+        bool ymm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+        bool avx2 = false;
+        if (leaves >= 7 && fma && ymm)
+        {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0;
+        }
+#else
+        __builtin_cpu_init();
+        bool sse41 = __builtin_cpu_supports("sse4.1");
+        bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+        if (avx2)
+            return SIMD_AVX2;
+        if (sse41)
+            return SIMD_SSE41;
+#endif
+        return SIMD_SCALAR;
+    }
+
+    // scalar reference
+    // ----------------
+    static void multiplyScalar(const glm::mat4 *a, const glm::mat4 *b, glm::mat4 *out, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+            out[i] = a[i] * b[i];
+    }
+
+    static void multiplyParentScalar(const glm::mat4 &parent, const glm::mat4 *local, glm::mat4 *out, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+            out[i] = parent * local[i];
+    }
+
+    static void composeScalar(const glm::vec3 *translation, const glm::quat *rotation, const glm::vec3 *scale, glm::mat4 *out, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+            out[i] = ::ComposeTRS(translation[i], rotation[i], scale[i]);
+    }
+
+    static void normalsScalar(const glm::mat4 *models, size_t modelStride, glm::mat3 *normals, size_t normalStride, size_t count)
+    {
+        const char *in = (const char*)models;
+        char *out = (char*)normals;
+        for (size_t i = 0; i < count; i++, in += modelStride, out += normalStride)
+            *(glm::mat3*)out = glm::transpose(glm::inverse(glm::mat3(*(const glm::mat4*)in)));
+    }
+
+    static void pointsScalar(const glm::mat4 &transform, const glm::vec3 *points, glm::vec3 *out, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+            out[i] = glm::vec3(transform * glm::vec4(points[i], 1.0f));
+    }
+
+    static void boundsScalar(const glm::mat4 *transforms, const AABB &box, AABB *out, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+            out[i] = box.Transformed(transforms[i]);
+    }
+
+#if defined(MATRIX_KERNELS_X86)
+    // SSE4.1, one matrix (column by column) per iteration
+    // ----------------------------------------------------
+    MATRIX_KERNELS_TARGET("sse4.1")
+    static void multiplySSE41(const glm::mat4 *a, const glm::mat4 *b, glm::mat4 *out, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            const float *left = &a[i][0][0];
+            const float *right = &b[i][0][0];
+            float *result = &out[i][0][0];
+            __m128 a0 = _mm_loadu_ps(left), a1 = _mm_loadu_ps(left + 4), a2 = _mm_loadu_ps(left + 8), a3 = _mm_loadu_ps(left + 12);
+            for (int c = 0; c < 4; c++)
+            {
+                __m128 column = _mm_mul_ps(a0, _mm_set1_ps(right[4 * c]));
+                column = _mm_add_ps(column, _mm_mul_ps(a1, _mm_set1_ps(right[4 * c + 1])));
+                column = _mm_add_ps(column, _mm_mul_ps(a2, _mm_set1_ps(right[4 * c + 2])));
+                column = _mm_add_ps(column, _mm_mul_ps(a3, _mm_set1_ps(right[4 * c + 3])));
+                _mm_storeu_ps(result + 4 * c, column);
+            }
+        }
+    }
+
+    MATRIX_KERNELS_TARGET("sse4.1")
+    static void multiplyParentSSE41(const glm::mat4 &parent, const glm::mat4 *local, glm::mat4 *out, size_t count)
+    {
+        const float *left = &parent[0][0];
+        __m128 a0 = _mm_loadu_ps(left), a1 = _mm_loadu_ps(left + 4), a2 = _mm_loadu_ps(left + 8), a3 = _mm_loadu_ps(left + 12);
+        for (size_t i = 0; i < count; i++)
+        {
+            const float *right = &local[i][0][0];
+            float *result = &out[i][0][0];
+            for (int c = 0; c < 4; c++)
+            {
+                __m128 column = _mm_mul_ps(a0, _mm_set1_ps(right[4 * c]));
+                column = _mm_add_ps(column, _mm_mul_ps(a1, _mm_set1_ps(right[4 * c + 1])));
+                column = _mm_add_ps(column, _mm_mul_ps(a2, _mm_set1_ps(right[4 * c + 2])));
+                column = _mm_add_ps(column, _mm_mul_ps(a3, _mm_set1_ps(right[4 * c + 3])));
+                _mm_storeu_ps(result + 4 * c, column);
+            }
+        }
+    }
+
+    // writes column 'column' of out[0] .. out[3], lane j of x, y, z and w goes to out[j]
+    MATRIX_KERNELS_TARGET("sse4.1")
+    static void storeColumns(__m128 x, __m128 y, __m128 z, __m128 w, glm::mat4 *out, int column)
+    {
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        _mm_storeu_ps(&out[0][column][0], x);
+        _mm_storeu_ps(&out[1][column][0], y);
+        _mm_storeu_ps(&out[2][column][0], z);
+        _mm_storeu_ps(&out[3][column][0], w);
+    }
+
+    // the quaternion setup has nothing to share between the columns of one matrix, so the compose runs
+    // on four instances at once, one per lane, and transposes the columns back out at the end
+    MATRIX_KERNELS_TARGET("sse4.1")
+    static void composeSSE41(const glm::vec3 *translation, const glm::quat *rotation, const glm::vec3 *scale, glm::mat4 *out, size_t count)
+    {
+        const __m128 one = _mm_set1_ps(1.0f), two = _mm_set1_ps(2.0f), zero = _mm_setzero_ps();
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            const glm::quat *q = rotation + i;
+            const glm::vec3 *t = translation + i, *s = scale + i;
+            __m128 x = _mm_setr_ps(q[0].x, q[1].x, q[2].x, q[3].x), y = _mm_setr_ps(q[0].y, q[1].y, q[2].y, q[3].y);
+            __m128 z = _mm_setr_ps(q[0].z, q[1].z, q[2].z, q[3].z), w = _mm_setr_ps(q[0].w, q[1].w, q[2].w, q[3].w);
+            __m128 sx = _mm_setr_ps(s[0].x, s[1].x, s[2].x, s[3].x), sy = _mm_setr_ps(s[0].y, s[1].y, s[2].y, s[3].y);
+            __m128 sz = _mm_setr_ps(s[0].z, s[1].z, s[2].z, s[3].z);
+            __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+            __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+            __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+            storeColumns(_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx),
+                         _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx),
+                         _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx), zero, out + i, 0);
+            storeColumns(_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy),
+                         _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy),
+                         _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy), zero, out + i, 1);
+            storeColumns(_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz),
+                         _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz),
+                         _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz), zero, out + i, 2);
+            storeColumns(_mm_setr_ps(t[0].x, t[1].x, t[2].x, t[3].x), _mm_setr_ps(t[0].y, t[1].y, t[2].y, t[3].y),
+                         _mm_setr_ps(t[0].z, t[1].z, t[2].z, t[3].z), one, out + i, 3);
+        }
+        composeScalar(translation + i, rotation + i, scale + i, out + i, count - i);
+    }
+
+    // the columns of the normal matrix are the cross products of the model's columns over the determinant
+    MATRIX_KERNELS_TARGET("sse4.1")
+    static void normalsSSE41(const glm::mat4 *models, size_t modelStride, glm::mat3 *normals, size_t normalStride, size_t count)
+    {
+        const char *in = (const char*)models;
+        char *out = (char*)normals;
+        float columns[12];
+        for (size_t i = 0; i < count; i++, in += modelStride, out += normalStride)
+        {
+            const float *model = (const float*)in;
+            __m128 a = _mm_loadu_ps(model), b = _mm_loadu_ps(model + 4), c = _mm_loadu_ps(model + 8);
+            __m128 bc = _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 1, 0, 2))),
+                                   _mm_mul_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1))));
+            __m128 ca = _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1)), _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2))),
+                                   _mm_mul_ps(_mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 1, 0, 2)), _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1))));
+            __m128 ab = _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2))),
+                                   _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1))));
+            __m128 inverseDeterminant = _mm_div_ps(_mm_set1_ps(1.0f), _mm_dp_ps(a, bc, 0x7F));
+            _mm_storeu_ps(columns, _mm_mul_ps(bc, inverseDeterminant));
+            _mm_storeu_ps(columns + 3, _mm_mul_ps(ca, inverseDeterminant));
+            _mm_storeu_ps(columns + 6, _mm_mul_ps(ab, inverseDeterminant));
+            std::memcpy(out, columns, sizeof(glm::mat3));
+        }
+    }
+
+    MATRIX_KERNELS_TARGET("sse4.1")
+    static void pointsSSE41(const glm::mat4 &transform, const glm::vec3 *points, glm::vec3 *out, size_t count)
+    {
+        const float *m = &transform[0][0];
+        __m128 m0 = _mm_loadu_ps(m), m1 = _mm_loadu_ps(m + 4), m2 = _mm_loadu_ps(m + 8), m3 = _mm_loadu_ps(m + 12);
+        float result[4];
+        for (size_t i = 0; i < count; i++)
+        {
+            __m128 p = _mm_mul_ps(m0, _mm_set1_ps(points[i].x));
+            p = _mm_add_ps(p, _mm_mul_ps(m1, _mm_set1_ps(points[i].y)));
+            p = _mm_add_ps(p, _mm_mul_ps(m2, _mm_set1_ps(points[i].z)));
+            p = _mm_add_ps(p, m3);
+            _mm_storeu_ps(result, p);
+            out[i] = glm::vec3(result[0], result[1], result[2]);
+        }
+    }
+
+    MATRIX_KERNELS_TARGET("sse4.1")
+    static void boundsSSE41(const glm::mat4 *transforms, const AABB &box, AABB *out, size_t count)
+    {
+        glm::vec3 center = (box.Min + box.Max) * 0.5f;
+        glm::vec3 extents = (box.Max - box.Min) * 0.5f;
+        __m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+        __m128 ex = _mm_set1_ps(extents.x), ey = _mm_set1_ps(extents.y), ez = _mm_set1_ps(extents.z);
+        __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+        float corners[8];
+        for (size_t i = 0; i < count; i++)
+        {
+            const float *m = &transforms[i][0][0];
+            __m128 m0 = _mm_loadu_ps(m), m1 = _mm_loadu_ps(m + 4), m2 = _mm_loadu_ps(m + 8), m3 = _mm_loadu_ps(m + 12);
+            __m128 c = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, cx), _mm_mul_ps(m1, cy)), _mm_mul_ps(m2, cz)), m3);
+            __m128 e = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_and_ps(m0, absMask), ex), _mm_mul_ps(_mm_and_ps(m1, absMask), ey)), _mm_mul_ps(_mm_and_ps(m2, absMask), ez));
+            _mm_storeu_ps(corners, _mm_sub_ps(c, e));
+            _mm_storeu_ps(corners + 3, _mm_add_ps(c, e));
+            out[i] = AABB(glm::vec3(corners[0], corners[1], corners[2]), glm::vec3(corners[3], corners[4], corners[5]));
+        }
+    }
+
+    // AVX2 + FMA, two columns or two matrices per iteration
+    // ------------------------------------------------------
+    MATRIX_KERNELS_TARGET("avx2,fma")
+    static void multiplyAVX2(const glm::mat4 *a, const glm::mat4 *b, glm::mat4 *out, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            const float *left = &a[i][0][0];
+            const float *right = &b[i][0][0];
+            float *result = &out[i][0][0];
+            // every column of 'a' in both halves, each half of 'right' holds one column of b
+            __m256 a0 = _mm256_broadcast_ps((const __m128*)left), a1 = _mm256_broadcast_ps((const __m128*)(left + 4));
+            __m256 a2 = _mm256_broadcast_ps((const __m128*)(left + 8)), a3 = _mm256_broadcast_ps((const __m128*)(left + 12));
+            for (int c = 0; c < 4; c += 2)
+            {
+                __m256 columns = _mm256_loadu_ps(right + 4 * c);
+                __m256 product = _mm256_mul_ps(a0, _mm256_permute_ps(columns, 0x00));
+                product = _mm256_fmadd_ps(a1, _mm256_permute_ps(columns, 0x55), product);
+                product = _mm256_fmadd_ps(a2, _mm256_permute_ps(columns, 0xAA), product);
+                product = _mm256_fmadd_ps(a3, _mm256_permute_ps(columns, 0xFF), product);
+                _mm256_storeu_ps(result + 4 * c, product);
+            }
+        }
+    }
+
+    MATRIX_KERNELS_TARGET("avx2,fma")
+    static void multiplyParentAVX2(const glm::mat4 &parent, const glm::mat4 *local, glm::mat4 *out, size_t count)
+    {
+        const float *left = &parent[0][0];
+        __m256 a0 = _mm256_broadcast_ps((const __m128*)left), a1 = _mm256_broadcast_ps((const __m128*)(left + 4));
+        __m256 a2 = _mm256_broadcast_ps((const __m128*)(left + 8)), a3 = _mm256_broadcast_ps((const __m128*)(left + 12));
+        for (size_t i = 0; i < count; i++)
+        {
+            const float *right = &local[i][0][0];
+            float *result = &out[i][0][0];
+            for (int c = 0; c < 4; c += 2)
+            {
+                __m256 columns = _mm256_loadu_ps(right + 4 * c);
+                __m256 product = _mm256_mul_ps(a0, _mm256_permute_ps(columns, 0x00));
+                product = _mm256_fmadd_ps(a1, _mm256_permute_ps(columns, 0x55), product);
+                product = _mm256_fmadd_ps(a2, _mm256_permute_ps(columns, 0xAA), product);
+                product = _mm256_fmadd_ps(a3, _mm256_permute_ps(columns, 0xFF), product);
+                _mm256_storeu_ps(result + 4 * c, product);
+            }
+        }
+    }
+
+    // loads column 'column' of two matrices into the low and high half
+    MATRIX_KERNELS_TARGET("avx2,fma")
+    static __m256 loadPair(const float *first, const float *second, int column)
+    {
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(first + 4 * column)), _mm_loadu_ps(second + 4 * column), 1);
+    }
+
+    MATRIX_KERNELS_TARGET("avx2,fma")
+    static __m256 cross(__m256 u, __m256 v)
+    {
+        return _mm256_fmsub_ps(_mm256_permute_ps(u, _MM_SHUFFLE(3, 0, 2, 1)), _mm256_permute_ps(v, _MM_SHUFFLE(3, 1, 0, 2)),
+                               _mm256_mul_ps(_mm256_permute_ps(u, _MM_SHUFFLE(3, 1, 0, 2)), _mm256_permute_ps(v, _MM_SHUFFLE(3, 0, 2, 1))));
+    }
+
+    // the low half of every lane set goes to out[0] .. out[3], the high half to out[4] .. out[7]
+    MATRIX_KERNELS_TARGET("avx2,fma")
+    static void storeColumns(__m256 x, __m256 y, __m256 z, __m256 w, glm::mat4 *out, int column)
+    {
+        storeColumns(_mm256_castps256_ps128(x), _mm256_castps256_ps128(y), _mm256_castps256_ps128(z), _mm256_castps256_ps128(w), out, column);
+        storeColumns(_mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1), _mm256_extractf128_ps(z, 1), _mm256_extractf128_ps(w, 1), out + 4, column);
+    }
+
+    // gathers member 'member' (0 x, 1 y, ...) of eight consecutive vectors or quaternions into the lanes
+    template <typename T>
+    MATRIX_KERNELS_TARGET("avx2,fma")
+    static __m256 lanes(const T *v, int member)
+    {
+        return _mm256_setr_ps(v[0][member], v[1][member], v[2][member], v[3][member], v[4][member], v[5][member], v[6][member], v[7][member]);
+    }
+
+    MATRIX_KERNELS_TARGET("avx2,fma")
+    static void composeAVX2(const glm::vec3 *translation, const glm::quat *rotation, const glm::vec3 *scale, glm::mat4 *out, size_t count)
+    {
+        const __m256 one = _mm256_set1_ps(1.0f), two = _mm256_set1_ps(2.0f), zero = _mm256_setzero_ps();
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256 x = lanes(rotation + i, 0), y = lanes(rotation + i, 1), z = lanes(rotation + i, 2), w = lanes(rotation + i, 3);
+            __m256 sx = lanes(scale + i, 0), sy = lanes(scale + i, 1), sz = lanes(scale + i, 2);
+            __m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+            __m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+            __m256 wx = _mm256_mul_ps(w, x), wy = _mm256_mul_ps(w, y), wz = _mm256_mul_ps(w, z);
+            storeColumns(_mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))), sx),
+                         _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx),
+                         _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx), zero, out + i, 0);
+            storeColumns(_mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy),
+                         _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))), sy),
+                         _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy), zero, out + i, 1);
+            storeColumns(_mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz),
+                         _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz),
+                         _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))), sz), zero, out + i, 2);
+            storeColumns(lanes(translation + i, 0), lanes(translation + i, 1), lanes(translation + i, 2), one, out + i, 3);
+        }
+        if (i < count)
+            composeSSE41(translation + i, rotation + i, scale + i, out + i, count - i);
+    }
+
+    MATRIX_KERNELS_TARGET("avx2,fma")
+    static void normalsAVX2(const glm::mat4 *models, size_t modelStride, glm::mat3 *normals, size_t normalStride, size_t count)
+    {
+        const char *in = (const char*)models;
+        char *out = (char*)normals;
+        size_t i = 0;
+        float columns[24];
+        for (; i + 2 <= count; i += 2, in += 2 * modelStride, out += 2 * normalStride)
+        {
+            const float *first = (const float*)in;
+            const float *second = (const float*)(in + modelStride);
+            __m256 a = loadPair(first, second, 0), b = loadPair(first, second, 1), c = loadPair(first, second, 2);
+            __m256 bc = cross(b, c), ca = cross(c, a), ab = cross(a, b);
+            __m256 inverseDeterminant = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_dp_ps(a, bc, 0x7F));
+            bc = _mm256_mul_ps(bc, inverseDeterminant);
+            ca = _mm256_mul_ps(ca, inverseDeterminant);
+            ab = _mm256_mul_ps(ab, inverseDeterminant);
+            _mm_storeu_ps(columns, _mm256_castps256_ps128(bc));
+            _mm_storeu_ps(columns + 3, _mm256_castps256_ps128(ca));
+            _mm_storeu_ps(columns + 6, _mm256_castps256_ps128(ab));
+            _mm_storeu_ps(columns + 12, _mm256_extractf128_ps(bc, 1));
+            _mm_storeu_ps(columns + 15, _mm256_extractf128_ps(ca, 1));
+            _mm_storeu_ps(columns + 18, _mm256_extractf128_ps(ab, 1));
+            std::memcpy(out, columns, sizeof(glm::mat3));
+            std::memcpy(out + normalStride, columns + 12, sizeof(glm::mat3));
+        }
+        if (i < count)
+            normalsSSE41((const glm::mat4*)in, modelStride, (glm::mat3*)out, normalStride, count - i);
+    }
+
+    MATRIX_KERNELS_TARGET("avx2,fma")
+    static void pointsAVX2(const glm::mat4 &transform, const glm::vec3 *points, glm::vec3 *out, size_t count)
+    {
+        const float *m = &transform[0][0];
+        __m256 m0 = _mm256_broadcast_ps((const __m128*)m), m1 = _mm256_broadcast_ps((const __m128*)(m + 4));
+        __m256 m2 = _mm256_broadcast_ps((const __m128*)(m + 8)), m3 = _mm256_broadcast_ps((const __m128*)(m + 12));
+        float result[8];
+        size_t i = 0;
+        for (; i + 2 <= count; i += 2)
+        {
+            __m256 x = _mm256_insertf128_ps(_mm256_set1_ps(points[i].x), _mm_set1_ps(points[i + 1].x), 1);
+            __m256 y = _mm256_insertf128_ps(_mm256_set1_ps(points[i].y), _mm_set1_ps(points[i + 1].y), 1);
+            __m256 z = _mm256_insertf128_ps(_mm256_set1_ps(points[i].z), _mm_set1_ps(points[i + 1].z), 1);
+            __m256 p = _mm256_fmadd_ps(m2, z, _mm256_fmadd_ps(m1, y, _mm256_fmadd_ps(m0, x, m3)));
+            _mm256_storeu_ps(result, p);
+            out[i] = glm::vec3(result[0], result[1], result[2]);
+            out[i + 1] = glm::vec3(result[4], result[5], result[6]);
+        }
+        if (i < count)
+            pointsSSE41(transform, points + i, out + i, count - i);
+    }
+
+    MATRIX_KERNELS_TARGET("avx2,fma")
+    static void boundsAVX2(const glm::mat4 *transforms, const AABB &box, AABB *out, size_t count)
+    {
+        glm::vec3 center = (box.Min + box.Max) * 0.5f;
+        glm::vec3 extents = (box.Max - box.Min) * 0.5f;
+        __m256 cx = _mm256_set1_ps(center.x), cy = _mm256_set1_ps(center.y), cz = _mm256_set1_ps(center.z);
+        __m256 ex = _mm256_set1_ps(extents.x), ey = _mm256_set1_ps(extents.y), ez = _mm256_set1_ps(extents.z);
+        __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+        float corners[16];
+        size_t i = 0;
+        for (; i + 2 <= count; i += 2)
+        {
+            const float *first = &transforms[i][0][0];
+            const float *second = &transforms[i + 1][0][0];
+            __m256 m0 = loadPair(first, second, 0), m1 = loadPair(first, second, 1), m2 = loadPair(first, second, 2), m3 = loadPair(first, second, 3);
+            __m256 c = _mm256_fmadd_ps(m2, cz, _mm256_fmadd_ps(m1, cy, _mm256_fmadd_ps(m0, cx, m3)));
+            __m256 e = _mm256_fmadd_ps(_mm256_and_ps(m2, absMask), ez, _mm256_fmadd_ps(_mm256_and_ps(m1, absMask), ey, _mm256_mul_ps(_mm256_and_ps(m0, absMask), ex)));
+            __m256 minimum = _mm256_sub_ps(c, e), maximum = _mm256_add_ps(c, e);
+            _mm_storeu_ps(corners, _mm256_castps256_ps128(minimum));
+            _mm_storeu_ps(corners + 3, _mm256_castps256_ps128(maximum));
+            _mm_storeu_ps(corners + 8, _mm256_extractf128_ps(minimum, 1));
+            _mm_storeu_ps(corners + 11, _mm256_extractf128_ps(maximum, 1));
+            out[i] = AABB(glm::vec3(corners[0], corners[1], corners[2]), glm::vec3(corners[3], corners[4], corners[5]));
+            out[i + 1] = AABB(glm::vec3(corners[8], corners[9], corners[10]), glm::vec3(corners[11], corners[12], corners[13]));
+        }
+        if (i < count)
+            boundsSSE41(transforms + i, box, out + i, count - i);
+    }
+#endif
+};
+#endif
@@ -6,6 +6,9 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <learnopengl/frustum.h>
+#include <learnopengl/gl_state.h>
+#include <learnopengl/profiler.h>
 #include <learnopengl/shader.h>
 
 #include <string>
@@ -41,6 +44,8 @@ public:
     vector<unsigned int> indices;
     vector<Texture> textures;
     unsigned int VAO;
+    // bounds of the vertices in model space
+    AABB Bounds;
 
     /*  Functions  */
     // constructor
@@ -49,6 +54,8 @@ public:
         this->vertices = vertices;
         this->indices = indices;
         this->textures = textures;
+        for(unsigned int i = 0; i < this->vertices.size(); i++)
+            Bounds.Extend(this->vertices[i].Position);
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
         setupMesh();
@@ -56,6 +63,17 @@ public:
 
     // render the mesh
     void Draw(Shader shader) 
+    {
+        BindTextures(shader);
+        
+        // draw mesh. The state cache knows what is bound, so there is no need to reset the
+        // vertex array or the active texture unit afterwards.
+        GLState::Get().BindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+    }
+
+    // binds the mesh's textures to consecutive units and points the shader's samplers at them
+    void BindTextures(const Shader &shader) const
     {
         // bind appropriate textures
         unsigned int diffuseNr  = 1;
@@ -64,7 +82,6 @@ public:
         unsigned int heightNr   = 1;
         for(unsigned int i = 0; i < textures.size(); i++)
         {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
             // retrieve texture number (the N in diffuse_textureN)
             string number;
             string name = textures[i].type;
@@ -78,18 +95,10 @@ public:
 			    number = std::to_string(heightNr++); // transfer unsigned int to stream
 
 													 // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+            shader.setInt(name + number, i);
+            // and finally bind the texture (skipped if the unit already holds it)
+            GLState::Get().BindTextureUnit(i, GL_TEXTURE_2D, textures[i].id);
         }
-        
-        // draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
     }
 
 private:
@@ -100,12 +109,13 @@ private:
     // initializes all the buffer objects/arrays
     void setupMesh()
     {
+        PROFILE_ZONE("Mesh::setupMesh");
         // create buffers/arrays
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
         glGenBuffers(1, &EBO);
 
-        glBindVertexArray(VAO);
+        GLState::Get().BindVertexArray(VAO);
         // load data into vertex buffers
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
         // A great thing about structs is that their memory layout is sequential for all its items.
@@ -133,7 +143,7 @@ private:
         glEnableVertexAttribArray(4);
         glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
 
-        glBindVertexArray(0);
+        GLState::Get().BindVertexArray(0);
     }
 };
 #endif
@@ -10,7 +10,10 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include <learnopengl/gl_state.h>
+#include <learnopengl/indirect_draw.h>
 #include <learnopengl/mesh.h>
+#include <learnopengl/profiler.h>
 #include <learnopengl/shader.h>
 
 #include <string>
@@ -34,7 +37,7 @@ public:
 
     /*  Functions   */
     // constructor, expects a filepath to a 3D model.
-    Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+    Model(string const &path, bool gamma = false) : gammaCorrection(gamma), indirectVAO(0)
     {
         loadModel(path);
     }
@@ -45,15 +48,118 @@ public:
         for(unsigned int i = 0; i < meshes.size(); i++)
             meshes[i].Draw(shader);
     }
+
+    // draws the meshes of the model whose bounds, placed with 'model', intersect 'frustum'.
+    // Returns the number of meshes culled.
+    unsigned int Draw(Shader shader, const Frustum &frustum, const glm::mat4 &model)
+    {
+        meshBounds.Clear();
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            meshBounds.Add(meshes[i].Bounds.Transformed(model));
+        unsigned int culled = CullBounds(frustum, meshBounds, visibleMeshes);
+        for(unsigned int i = 0; i < visibleMeshes.size(); i++)
+            meshes[visibleMeshes[i]].Draw(shader);
+        return culled;
+    }
+
+    // draws the model from one vertex/index buffer holding every mesh, with one multi-draw per
+    // distinct set of textures (a single one if all meshes share their textures), so the number
+    // of draw calls does not depend on the number of meshes
+    void DrawIndirect(const Shader &shader)
+    {
+        if(indirectVAO == 0)
+            setupIndirect();
+        GLState::Get().BindVertexArray(indirectVAO);
+        for(unsigned int i = 0; i < textureGroups.size(); i++)
+        {
+            meshes[textureGroups[i].mesh].BindTextures(shader);
+            indirect.Draw(GL_TRIANGLES, textureGroups[i].first, textureGroups[i].count);
+        }
+    }
     
 private:
+    // meshes sharing their textures, drawn by commands first .. first + count - 1
+    struct TextureGroup {
+        unsigned int mesh;
+        unsigned int first;
+        unsigned int count;
+    };
+
+    /*  Indirect render data  */
+    unsigned int indirectVAO, indirectVBO, indirectEBO;
+    IndirectBuffer indirect;
+    vector<TextureGroup> textureGroups;
+    /*  Culling data  */
+    BoundsList meshBounds;
+    vector<unsigned int> visibleMeshes;
+
     /*  Functions   */
+    // copies all meshes into one set of buffers and records a draw command per mesh, grouped by textures
+    void setupIndirect()
+    {
+        map<vector<unsigned int>, vector<unsigned int> > groups;
+        for(unsigned int i = 0; i < meshes.size(); i++)
+        {
+            vector<unsigned int> ids;
+            for(unsigned int j = 0; j < meshes[i].textures.size(); j++)
+                ids.push_back(meshes[i].textures[j].id);
+            groups[ids].push_back(i);
+        }
+
+        vector<Vertex> vertices;
+        vector<unsigned int> indices;
+        for(map<vector<unsigned int>, vector<unsigned int> >::iterator it = groups.begin(); it != groups.end(); ++it)
+        {
+            TextureGroup group;
+            group.mesh = it->second[0];
+            group.first = indirect.Commands.size();
+            group.count = it->second.size();
+            textureGroups.push_back(group);
+            for(unsigned int i = 0; i < it->second.size(); i++)
+            {
+                const Mesh &mesh = meshes[it->second[i]];
+                indirect.Add(mesh.indices.size(), indices.size(), vertices.size());
+                vertices.insert(vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+                indices.insert(indices.end(), mesh.indices.begin(), mesh.indices.end());
+            }
+        }
+        indirect.Upload();
+        if(indices.empty())
+            return;
+
+        glGenVertexArrays(1, &indirectVAO);
+        glGenBuffers(1, &indirectVBO);
+        glGenBuffers(1, &indirectEBO);
+        GLState::Get().BindVertexArray(indirectVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, indirectVBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indirectEBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        // same layout as Mesh::setupMesh
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+        GLState::Get().BindVertexArray(0);
+    }
+
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
     void loadModel(string const &path)
     {
+        PROFILE_ZONE("Model::loadModel");
         // read file via ASSIMP
         Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        const aiScene* scene;
+        {
+            PROFILE_ZONE("Assimp::ReadFile");
+            scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        }
         // check for errors
         if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
         {
@@ -88,6 +194,7 @@ private:
 
     Mesh processMesh(aiMesh *mesh, const aiScene *scene)
     {
+        PROFILE_ZONE("Model::processMesh");
         // data to fill
         vector<Vertex> vertices;
         vector<unsigned int> indices;
@@ -203,6 +310,7 @@ private:
 
 unsigned int TextureFromFile(const char *path, const string &directory, bool gamma)
 {
+    PROFILE_ZONE("TextureFromFile");
     string filename = string(path);
     filename = directory + '/' + filename;
 
@@ -221,7 +329,7 @@ unsigned int TextureFromFile(const char *path, const string &directory, bool gam
         else if (nrComponents == 4)
             format = GL_RGBA;
 
-        glBindTexture(GL_TEXTURE_2D, textureID);
+        GLState::Get().BindTexture(GL_TEXTURE_2D, textureID);
         glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
         glGenerateMipmap(GL_TEXTURE_2D);
 
@@ -0,0 +1,452 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// ARB_pipeline_statistics_query (core since 4.6), newer than the loaded OpenGL headers
+#ifndef GL_VERTICES_SUBMITTED_ARB
+#define GL_VERTICES_SUBMITTED_ARB         0x82EE
+#define GL_VERTEX_SHADER_INVOCATIONS_ARB  0x82F0
+#define GL_FRAGMENT_SHADER_INVOCATIONS_ARB 0x82F4
+#define GL_CLIPPING_INPUT_PRIMITIVES_ARB  0x82F6
+#endif
+
+// One timed zone: Begin and End are nanoseconds since the profiler started, on the CPU's clock
+// also for GPU zones, whose Thread is Profiler::GPU_THREAD.
+struct ProfileEvent {
+    const char *Name;
+    long long Begin, End;
+    int Thread;
+};
+
+// Frame profiler for the CPU and the GPU. CPU zones are timed by ProfileZone objects living on the
+// stack, from any thread, and go into a ring buffer that keeps the latest RING_SIZE of them. GPU
+// zones (GpuProfileZone) put a GL_TIMESTAMP query at either end; each frame also gets a
+// GL_TIME_ELAPSED query and, if the driver has them, pipeline statistics queries. Query results are
+// only read LATENCY frames later and only once they are available, so profiling never waits on
+// the GPU. Queries come from a pool and are reused.
+//
+// Zone names must outlive the profiler, string literals are best. While the profiler is disabled
+// a zone costs one branch.
+//
+//   Profiler::Get().Enable(true);
+//   { PROFILE_ZONE("update"); ... }
+//   { PROFILE_GPU_ZONE("draw"); ... }
+//   Profiler::Get().EndFrame();
+//   Profiler::Get().WriteChromeTrace("trace.json"); // open in chrome://tracing or Perfetto
+class Profiler
+{
+public:
+    static const unsigned int RING_SIZE = 1 << 16;
+    static const unsigned int LATENCY = 3;
+    static const int GPU_THREAD = 1000;
+
+    static Profiler &Get()
+    {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    bool Enabled;
+    bool GpuEnabled;
+    bool PipelineStatistics; // the driver has ARB_pipeline_statistics_query
+    unsigned long long Frames;
+
+    // starts recording, GPU zones need a current context. Call before other threads record zones.
+    void Enable(bool gpu)
+    {
+        Enabled = true;
+        NameThread("main");
+        if (!gpu || GpuEnabled)
+            return;
+        GpuEnabled = true;
+        // maps GPU timestamps onto the CPU timeline
+        GLint64 gpuNow = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        GpuOffset = gpuNow - Now();
+        PipelineStatistics = hasExtension("GL_ARB_pipeline_statistics_query");
+        beginFrameQueries();
+    }
+
+    // nanoseconds since the profiler was created
+    long long Now() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Start).count();
+    }
+
+    // name of the calling thread in the trace
+    void NameThread(const std::string &name)
+    {
+        int thread = CurrentThread();
+        if ((int)ThreadNames.size() <= thread)
+            ThreadNames.resize(thread + 1);
+        ThreadNames[thread] = name;
+    }
+
+    // small number of the calling thread, in the order threads first asked for it
+    int CurrentThread()
+    {
+        static thread_local int thread = NextThread++;
+        return thread;
+    }
+
+    void Record(const char *name, long long begin, long long end, int thread)
+    {
+        ProfileEvent &event = Events[Next++ & (RING_SIZE - 1)];
+        event.Name = name;
+        event.Begin = begin;
+        event.End = end;
+        event.Thread = thread;
+    }
+
+    // GPU zones are pairs of timestamp queries, they may nest. Returns the zone's index for EndGpuZone.
+    int BeginGpuZone(const char *name)
+    {
+        if (!GpuEnabled)
+            return -1;
+        GpuZone zone;
+        zone.Name = name;
+        zone.Frame = Frames;
+        zone.Queries[0] = acquireQuery(GL_TIMESTAMP);
+        zone.Queries[1] = acquireQuery(GL_TIMESTAMP);
+        glQueryCounter(zone.Queries[0], GL_TIMESTAMP);
+        PendingZones.push_back(zone);
+        return PendingZones.size() - 1;
+    }
+
+    void EndGpuZone(int zone)
+    {
+        if (zone >= 0)
+            glQueryCounter(PendingZones[zone].Queries[1], GL_TIMESTAMP);
+    }
+
+    // closes the frame's queries, collects whatever results of earlier frames arrived and opens the
+    // next frame's queries. Call once per frame on the thread owning the context.
+    void EndFrame()
+    {
+        if (!Enabled)
+            return;
+        Frames++;
+        if (!GpuEnabled)
+            return;
+        endFrameQueries();
+        collect(false);
+        beginFrameQueries();
+    }
+
+    // waits for every query still in flight, for the end of the program
+    void Finish()
+    {
+        if (!GpuEnabled)
+            return;
+        endFrameQueries();
+        collect(true);
+        for (std::map<GLenum, std::vector<unsigned int> >::iterator it = QueryPools.begin(); it != QueryPools.end(); ++it)
+            if (!it->second.empty())
+                glDeleteQueries(it->second.size(), &it->second[0]);
+        QueryPools.clear();
+        GpuEnabled = false;
+    }
+
+    // GPU time of every frame collected so far in nanoseconds, oldest first
+    const std::vector<long long> &GpuFrameTimes() const
+    {
+        return FrameTimes;
+    }
+
+    // events still in the ring, oldest first
+    std::vector<ProfileEvent> Recorded() const
+    {
+        unsigned long long next = Next;
+        unsigned long long count = std::min(next, (unsigned long long)RING_SIZE);
+        std::vector<ProfileEvent> events;
+        events.reserve(count);
+        for (unsigned long long i = next - count; i < next; i++)
+            events.push_back(Events[i & (RING_SIZE - 1)]);
+        return events;
+    }
+
+    // Chrome trace_event JSON, one complete ("X") event per zone
+    bool WriteChromeTrace(const std::string &path) const
+    {
+        std::ofstream file(path.c_str());
+        if (!file)
+            return false;
+        std::vector<ProfileEvent> events = Recorded();
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        for (unsigned int i = 0; i < ThreadNames.size(); i++)
+            file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i << ",\"args\":{\"name\":\"" << threadName(i) << "\"}},\n";
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << GPU_THREAD << ",\"args\":{\"name\":\"GPU\"}}";
+        file << std::fixed << std::setprecision(3);
+        for (unsigned int i = 0; i < events.size(); i++)
+        {
+            const ProfileEvent &event = events[i];
+            file << ",\n{\"name\":\"" << event.Name << "\",\"cat\":\"" << (event.Thread == GPU_THREAD ? "gpu" : "cpu")
+                << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.Thread
+                << ",\"ts\":" << event.Begin / 1000.0 << ",\"dur\":" << (event.End - event.Begin) / 1000.0 << "}";
+        }
+        file << "\n]}\n";
+        return file.good();
+    }
+
+    // calls, min, average and 99th percentile of every zone, then the GPU frame time and the
+    // pipeline statistics per frame
+    void PrintSummary(std::ostream &out) const
+    {
+        std::map<std::string, std::vector<long long> > durations;
+        std::vector<ProfileEvent> events = Recorded();
+        for (unsigned int i = 0; i < events.size(); i++)
+            durations[std::string(events[i].Thread == GPU_THREAD ? "GPU " : "CPU ") + events[i].Name].push_back(events[i].End - events[i].Begin);
+        if (!FrameTimes.empty())
+            durations["GPU frame (time elapsed)"] = FrameTimes;
+
+        out << "Profiler: " << Frames << " frames\n";
+        out << "  " << std::left << std::setw(32) << "zone" << std::right << std::setw(8) << "calls"
+            << std::setw(11) << "min ms" << std::setw(11) << "avg ms" << std::setw(11) << "p99 ms" << "\n";
+        out << std::fixed << std::setprecision(3);
+        for (std::map<std::string, std::vector<long long> >::iterator it = durations.begin(); it != durations.end(); ++it)
+        {
+            std::vector<long long> &times = it->second;
+            std::sort(times.begin(), times.end());
+            double total = 0.0;
+            for (unsigned int i = 0; i < times.size(); i++)
+                total += times[i];
+            size_t p99 = std::min(times.size() - 1, (size_t)(times.size() * 0.99));
+            out << "  " << std::left << std::setw(32) << it->first << std::right << std::setw(8) << times.size()
+                << std::setw(11) << times.front() / 1e6 << std::setw(11) << total / times.size() / 1e6 << std::setw(11) << times[p99] / 1e6 << "\n";
+        }
+        if (StatisticsFrames > 0)
+        {
+            out << std::setprecision(0) << "  per frame: " << Statistics[0] / (double)StatisticsFrames << " primitives generated";
+            if (PipelineStatistics)
+                out << ", " << Statistics[1] / (double)StatisticsFrames << " vertices submitted, "
+                    << Statistics[2] / (double)StatisticsFrames << " vertex shader invocations, "
+                    << Statistics[3] / (double)StatisticsFrames << " clipping input primitives, "
+                    << Statistics[4] / (double)StatisticsFrames << " fragment shader invocations";
+            out << "\n";
+        }
+        out.unsetf(std::ios::floatfield);
+        out << std::setprecision(6);
+    }
+
+private:
+    static const int STATISTICS_COUNT = 5;
+
+    struct GpuZone {
+        const char *Name;
+        unsigned long long Frame;
+        unsigned int Queries[2];
+    };
+
+    struct FrameQueries {
+        unsigned long long Frame;
+        long long Begin; // CPU time the queries started
+        unsigned int TimeElapsed;
+        unsigned int Statistics[STATISTICS_COUNT];
+    };
+
+    std::chrono::steady_clock::time_point Start;
+    std::vector<ProfileEvent> Events;
+    std::atomic<unsigned long long> Next;
+    std::atomic<int> NextThread;
+    std::vector<std::string> ThreadNames;
+
+    long long GpuOffset;
+    std::map<GLenum, std::vector<unsigned int> > QueryPools; // free query objects of every target, a query keeps its target for good
+    std::vector<GpuZone> PendingZones;     // in the order they were issued, so they complete in order
+    std::vector<FrameQueries> PendingFrames;
+    FrameQueries Current;
+    bool FrameOpen;
+    std::vector<long long> FrameTimes;
+    unsigned long long Statistics[STATISTICS_COUNT];
+    unsigned long long StatisticsFrames;
+
+    Profiler() : Enabled(false), GpuEnabled(false), PipelineStatistics(false), Frames(0), Start(std::chrono::steady_clock::now()),
+        Events(RING_SIZE), Next(0), NextThread(0), GpuOffset(0), FrameOpen(false), StatisticsFrames(0)
+    {
+        std::memset(Statistics, 0, sizeof(Statistics));
+    }
+
+    std::string threadName(int thread) const
+    {
+        if (thread < (int)ThreadNames.size() && !ThreadNames[thread].empty())
+            return ThreadNames[thread];
+        return "thread " + std::to_string(thread);
+    }
+
+    static bool hasExtension(const char *name)
+    {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; i++)
+            if (std::strcmp((const char*)glGetStringi(GL_EXTENSIONS, i), name) == 0)
+                return true;
+        return false;
+    }
+
+    static GLenum statisticsTarget(int i)
+    {
+        static const GLenum targets[STATISTICS_COUNT] = {
+            GL_PRIMITIVES_GENERATED, GL_VERTICES_SUBMITTED_ARB, GL_VERTEX_SHADER_INVOCATIONS_ARB,
+            GL_CLIPPING_INPUT_PRIMITIVES_ARB, GL_FRAGMENT_SHADER_INVOCATIONS_ARB
+        };
+        return targets[i];
+    }
+
+    int statisticsCount() const
+    {
+        return PipelineStatistics ? STATISTICS_COUNT : 1;
+    }
+
+    unsigned int acquireQuery(GLenum target)
+    {
+        std::vector<unsigned int> &pool = QueryPools[target];
+        if (pool.empty())
+        {
+            unsigned int query;
+            glGenQueries(1, &query);
+            return query;
+        }
+        unsigned int query = pool.back();
+        pool.pop_back();
+        return query;
+    }
+
+    void releaseQuery(GLenum target, unsigned int query)
+    {
+        QueryPools[target].push_back(query);
+    }
+
+    void beginFrameQueries()
+    {
+        Current.Frame = Frames;
+        Current.Begin = Now();
+        Current.TimeElapsed = acquireQuery(GL_TIME_ELAPSED);
+        glBeginQuery(GL_TIME_ELAPSED, Current.TimeElapsed);
+        for (int i = 0; i < statisticsCount(); i++)
+        {
+            Current.Statistics[i] = acquireQuery(statisticsTarget(i));
+            glBeginQuery(statisticsTarget(i), Current.Statistics[i]);
+        }
+        FrameOpen = true;
+    }
+
+    void endFrameQueries()
+    {
+        if (!FrameOpen)
+            return;
+        glEndQuery(GL_TIME_ELAPSED);
+        for (int i = 0; i < statisticsCount(); i++)
+            glEndQuery(statisticsTarget(i));
+        PendingFrames.push_back(Current);
+        FrameOpen = false;
+    }
+
+    static bool available(unsigned int query)
+    {
+        GLint available = 0;
+        glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        return available != 0;
+    }
+
+    static long long result(unsigned int query)
+    {
+        GLuint64 value = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &value);
+        return (long long)value;
+    }
+
+    // reads the queries of frames at least LATENCY old whose results are there; 'wait' takes all of them
+    void collect(bool wait)
+    {
+        unsigned int done = 0;
+        for (; done < PendingZones.size(); done++)
+        {
+            GpuZone &zone = PendingZones[done];
+            if (!wait && (zone.Frame + LATENCY > Frames || !available(zone.Queries[1])))
+                break;
+            Record(zone.Name, result(zone.Queries[0]) - GpuOffset, result(zone.Queries[1]) - GpuOffset, GPU_THREAD);
+            releaseQuery(GL_TIMESTAMP, zone.Queries[0]);
+            releaseQuery(GL_TIMESTAMP, zone.Queries[1]);
+        }
+        PendingZones.erase(PendingZones.begin(), PendingZones.begin() + done);
+
+        done = 0;
+        for (; done < PendingFrames.size(); done++)
+        {
+            FrameQueries &frame = PendingFrames[done];
+            if (!wait && (frame.Frame + LATENCY > Frames || !available(frame.TimeElapsed)))
+                break;
+            // some drivers (llvmpipe) report nonsense for the very first query, no frame takes longer
+            // than the wall time since its query started
+            long long elapsed = result(frame.TimeElapsed);
+            if (elapsed <= Now() - frame.Begin)
+                FrameTimes.push_back(elapsed);
+            releaseQuery(GL_TIME_ELAPSED, frame.TimeElapsed);
+            for (int i = 0; i < statisticsCount(); i++)
+            {
+                Statistics[i] += result(frame.Statistics[i]);
+                releaseQuery(statisticsTarget(i), frame.Statistics[i]);
+            }
+            StatisticsFrames++;
+        }
+        PendingFrames.erase(PendingFrames.begin(), PendingFrames.begin() + done);
+    }
+};
+
+// times the scope it lives in on the CPU
+class ProfileZone
+{
+public:
+    explicit ProfileZone(const char *name) : Name(name), Begin(-1)
+    {
+        if (Profiler::Get().Enabled)
+            Begin = Profiler::Get().Now();
+    }
+
+    ~ProfileZone()
+    {
+        if (Begin < 0)
+            return;
+        Profiler &profiler = Profiler::Get();
+        profiler.Record(Name, Begin, profiler.Now(), profiler.CurrentThread());
+    }
+
+private:
+    const char *Name;
+    long long Begin;
+};
+
+// times the GL commands issued in the scope it lives in, on the GPU
+class GpuProfileZone
+{
+public:
+    explicit GpuProfileZone(const char *name) : Zone(Profiler::Get().BeginGpuZone(name))
+    {
+    }
+
+    ~GpuProfileZone()
+    {
+        Profiler::Get().EndGpuZone(Zone);
+    }
+
+private:
+    int Zone;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_GPU_ZONE(name) GpuProfileZone PROFILE_CONCAT(gpuProfileZone, __LINE__)(name)
+#endif
@@ -0,0 +1,399 @@
+#ifndef RENDER_CONTEXT_H
+#define RENDER_CONTEXT_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#ifdef LOGL_HAVE_EGL
+#define EGL_NO_X11
+#define MESA_EGL_NO_X11_HEADERS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+#ifndef EGL_NO_CONFIG_KHR
+#define EGL_NO_CONFIG_KHR ((EGLConfig)0)
+#endif
+#endif
+
+#ifdef LOGL_HAVE_OSMESA
+#include <GL/osmesa.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Where the frames of a program go: a GLFW window, or, on machines without a display or a GPU, a
+// framebuffer object on an offscreen context (EGL surfaceless or OSMesa, both work on Mesa's
+// llvmpipe). The backend is picked on the command line:
+//
+//   --offscreen egl|osmesa   render offscreen instead of opening a window
+//   --frames N               stop after N frames (offscreen the default is a single frame)
+//   --dump frame.png         write the last frame as PNG, a printf pattern like frame%03d.png
+//                            writes every frame
+//
+// Offscreen time advances by exactly 1/60 s per frame, so a run renders the same images on every
+// machine and they can be diffed. The EGL and OSMesa backends exist if the build found their
+// libraries and defined LOGL_HAVE_EGL or LOGL_HAVE_OSMESA.
+class RenderContext
+{
+public:
+    enum Backend {
+        WINDOW,
+        EGL_SURFACELESS,
+        OSMESA
+    };
+
+    // seconds an offscreen frame lasts
+    static constexpr double OFFSCREEN_FRAME_TIME = 1.0 / 60.0;
+
+    Backend Type;
+    GLFWwindow *Window;       // NULL when rendering offscreen
+    unsigned int Width, Height;
+    unsigned int Framebuffer; // offscreen framebuffer everything renders into, 0 for a window
+    int Frame;                // frames finished so far
+    int MaxFrames;            // the context closes after this many frames, 0 never closes it
+    std::string DumpPath;
+
+    RenderContext(int argc = 0, char **argv = NULL) : Type(WINDOW), Window(NULL), Width(0), Height(0), Framebuffer(0), Frame(0), MaxFrames(0),
+        ColorBuffer(0), DepthBuffer(0)
+    {
+#ifdef LOGL_HAVE_EGL
+        EglDisplay = EGL_NO_DISPLAY;
+        EglContext = EGL_NO_CONTEXT;
+#endif
+#ifdef LOGL_HAVE_OSMESA
+        MesaContext = NULL;
+#endif
+        bool frames = false;
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            if (arg == "--offscreen" && i + 1 < argc)
+            {
+                std::string backend = argv[++i];
+                Type = backend == "osmesa" ? OSMESA : EGL_SURFACELESS;
+            }
+            else if (arg == "--frames" && i + 1 < argc)
+            {
+                MaxFrames = atoi(argv[++i]);
+                frames = true;
+            }
+            else if (arg == "--dump" && i + 1 < argc)
+                DumpPath = argv[++i];
+        }
+        if (Type != WINDOW && !frames)
+            MaxFrames = 1;
+    }
+
+    // creates the window or the offscreen context, makes it current and loads the OpenGL functions
+    bool Create(unsigned int width, unsigned int height, const char *title)
+    {
+        Width = width;
+        Height = height;
+        switch (Type)
+        {
+        case WINDOW:
+            return createWindow(title);
+        case EGL_SURFACELESS:
+            return createEgl();
+        case OSMESA:
+            return createOsMesa();
+        }
+        return false;
+    }
+
+    bool ShouldClose() const
+    {
+        if (MaxFrames > 0 && Frame >= MaxFrames)
+            return true;
+        return Window && glfwWindowShouldClose(Window);
+    }
+
+    // seconds since the context was created, offscreen the time of the current frame
+    double Time() const
+    {
+        if (Window)
+            return glfwGetTime();
+        return Frame * OFFSCREEN_FRAME_TIME;
+    }
+
+    // finishes a frame: dumps it if asked to, then swaps buffers and polls events
+    void EndFrame()
+    {
+        Frame++;
+        if (!DumpPath.empty())
+        {
+            if (DumpPath.find('%') != std::string::npos)
+            {
+                char path[1024];
+                snprintf(path, sizeof(path), DumpPath.c_str(), Frame);
+                SavePNG(path);
+            }
+            else if (Frame == MaxFrames)
+                SavePNG(DumpPath);
+        }
+        if (Window)
+        {
+            glfwSwapBuffers(Window);
+            glfwPollEvents();
+        }
+        else
+            glFlush();
+    }
+
+    // reads back what was rendered so far and writes it to 'path' as 8 bit RGB
+    bool SavePNG(const std::string &path)
+    {
+        std::vector<unsigned char> pixels(Width * Height * 3);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, Framebuffer);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, Width, Height, GL_RGB, GL_UNSIGNED_BYTE, &pixels[0]);
+        if (!writePNG(path, Width, Height, pixels))
+        {
+            std::cout << "ERROR::RENDER_CONTEXT::CANNOT_WRITE " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    void Destroy()
+    {
+        if (Framebuffer)
+        {
+            glDeleteFramebuffers(1, &Framebuffer);
+            glDeleteRenderbuffers(1, &ColorBuffer);
+            glDeleteRenderbuffers(1, &DepthBuffer);
+            Framebuffer = 0;
+        }
+        if (Type == WINDOW)
+            glfwTerminate();
+#ifdef LOGL_HAVE_EGL
+        if (EglDisplay != EGL_NO_DISPLAY)
+        {
+            eglMakeCurrent(EglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            eglDestroyContext(EglDisplay, EglContext);
+            eglTerminate(EglDisplay);
+            EglDisplay = EGL_NO_DISPLAY;
+        }
+#endif
+#ifdef LOGL_HAVE_OSMESA
+        if (MesaContext)
+        {
+            OSMesaDestroyContext(MesaContext);
+            MesaContext = NULL;
+        }
+#endif
+        Window = NULL;
+    }
+
+private:
+    unsigned int ColorBuffer, DepthBuffer;
+#ifdef LOGL_HAVE_EGL
+    EGLDisplay EglDisplay;
+    EGLContext EglContext;
+#endif
+#ifdef LOGL_HAVE_OSMESA
+    OSMesaContext MesaContext;
+    std::vector<unsigned char> MesaBuffer; // OSMesa wants memory to draw into, the framebuffer object is used instead
+#endif
+
+    bool createWindow(const char *title)
+    {
+        // glfw: initialize and configure
+        // ------------------------------
+        glfwInit();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+        // glfw window creation
+        // --------------------
+        Window = glfwCreateWindow(Width, Height, title, NULL, NULL);
+        if (Window == NULL)
+        {
+            std::cout << "Failed to create GLFW window" << std::endl;
+            glfwTerminate();
+            return false;
+        }
+        glfwMakeContextCurrent(Window);
+        return loadFunctions((GLADloadproc)glfwGetProcAddress);
+    }
+
+    bool createEgl()
+    {
+#ifdef LOGL_HAVE_EGL
+        // a display that needs neither X11 nor Wayland nor a GPU, and a context without any surface
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay)
+            EglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+        EGLint major, minor;
+        if (EglDisplay == EGL_NO_DISPLAY || !eglInitialize(EglDisplay, &major, &minor))
+        {
+            std::cout << "Failed to initialize a surfaceless EGL display" << std::endl;
+            EglDisplay = EGL_NO_DISPLAY;
+            return false;
+        }
+        eglBindAPI(EGL_OPENGL_API);
+        const EGLint attributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, 3,
+            EGL_CONTEXT_MINOR_VERSION, 3,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+        EglContext = eglCreateContext(EglDisplay, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attributes);
+        if (EglContext == EGL_NO_CONTEXT || !eglMakeCurrent(EglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EglContext))
+        {
+            std::cout << "Failed to create a surfaceless EGL context" << std::endl;
+            return false;
+        }
+        return loadFunctions((GLADloadproc)eglGetProcAddress) && createFramebuffer();
+#else
+        std::cout << "Built without EGL, the offscreen backend is not available" << std::endl;
+        return false;
+#endif
+    }
+
+    bool createOsMesa()
+    {
+#ifdef LOGL_HAVE_OSMESA
+        const int attributes[] = {
+            OSMESA_FORMAT, OSMESA_RGBA,
+            OSMESA_DEPTH_BITS, 24,
+            OSMESA_STENCIL_BITS, 8,
+            OSMESA_PROFILE, OSMESA_CORE_PROFILE,
+            OSMESA_CONTEXT_MAJOR_VERSION, 3,
+            OSMESA_CONTEXT_MINOR_VERSION, 3,
+            0
+        };
+        MesaContext = OSMesaCreateContextAttribs(attributes, NULL);
+        MesaBuffer.resize(Width * Height * 4);
+        if (!MesaContext || !OSMesaMakeCurrent(MesaContext, &MesaBuffer[0], GL_UNSIGNED_BYTE, Width, Height))
+        {
+            std::cout << "Failed to create an OSMesa context" << std::endl;
+            return false;
+        }
+        return loadFunctions((GLADloadproc)OSMesaGetProcAddress) && createFramebuffer();
+#else
+        std::cout << "Built without OSMesa, the offscreen backend is not available" << std::endl;
+        return false;
+#endif
+    }
+
+    bool loadFunctions(GLADloadproc load)
+    {
+        // glad: load all OpenGL function pointers
+        // ---------------------------------------
+        if (!gladLoadGLLoader(load))
+        {
+            std::cout << "Failed to initialize GLAD" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // colour and depth-stencil renderbuffers the size of the window that is not there, bound for good
+    bool createFramebuffer()
+    {
+        glGenFramebuffers(1, &Framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, Framebuffer);
+        glGenRenderbuffers(1, &ColorBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, ColorBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, Width, Height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, ColorBuffer);
+        glGenRenderbuffers(1, &DepthBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, DepthBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, Width, Height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, DepthBuffer);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
+            return false;
+        }
+        // without a surface nothing sized the viewport yet
+        glViewport(0, 0, Width, Height);
+        return true;
+    }
+
+    // PNG with stored (uncompressed) deflate blocks, large but needs no image library
+    static bool writePNG(const std::string &path, unsigned int width, unsigned int height, const std::vector<unsigned char> &rgb)
+    {
+        // scanlines top to bottom, OpenGL reads them bottom to top, each starts with filter type 0
+        std::vector<unsigned char> raw;
+        raw.reserve((width * 3 + 1) * height);
+        for (unsigned int y = 0; y < height; y++)
+        {
+            raw.push_back(0);
+            const unsigned char *row = &rgb[(height - 1 - y) * width * 3];
+            raw.insert(raw.end(), row, row + width * 3);
+        }
+
+        std::vector<unsigned char> zlib;
+        zlib.push_back(0x78);
+        zlib.push_back(0x01);
+        for (size_t offset = 0; offset < raw.size() || offset == 0; offset += 65535)
+        {
+            size_t size = std::min(raw.size() - offset, (size_t)65535);
+            zlib.push_back(offset + size == raw.size() ? 1 : 0);
+            zlib.push_back(size & 0xFF);
+            zlib.push_back(size >> 8);
+            zlib.push_back(~size & 0xFF);
+            zlib.push_back((~size >> 8) & 0xFF);
+            zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + size);
+        }
+        unsigned int a = 1, b = 0;
+        for (size_t i = 0; i < raw.size(); i++)
+        {
+            a = (a + raw[i]) % 65521;
+            b = (b + a) % 65521;
+        }
+        pushBigEndian(zlib, (b << 16) | a);
+
+        FILE *file = fopen(path.c_str(), "wb");
+        if (!file)
+            return false;
+        const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        fwrite(signature, 1, sizeof(signature), file);
+        std::vector<unsigned char> header;
+        pushBigEndian(header, width);
+        pushBigEndian(header, height);
+        const unsigned char format[5] = { 8, 2, 0, 0, 0 }; // 8 bit RGB, deflate, no filtering, not interlaced
+        header.insert(header.end(), format, format + 5);
+        writeChunk(file, "IHDR", header);
+        writeChunk(file, "IDAT", zlib);
+        writeChunk(file, "IEND", std::vector<unsigned char>());
+        return fclose(file) == 0;
+    }
+
+    static void pushBigEndian(std::vector<unsigned char> &data, unsigned int value)
+    {
+        for (int shift = 24; shift >= 0; shift -= 8)
+            data.push_back((value >> shift) & 0xFF);
+    }
+
+    static void writeChunk(FILE *file, const char *type, const std::vector<unsigned char> &data)
+    {
+        std::vector<unsigned char> chunk;
+        pushBigEndian(chunk, data.size());
+        chunk.insert(chunk.end(), type, type + 4);
+        chunk.insert(chunk.end(), data.begin(), data.end());
+        unsigned int crc = 0xFFFFFFFF;
+        for (size_t i = 4; i < chunk.size(); i++)
+        {
+            crc ^= chunk[i];
+            for (int bit = 0; bit < 8; bit++)
+                crc = (crc >> 1) ^ (0xEDB88320 & (0u - (crc & 1)));
+        }
+        pushBigEndian(chunk, ~crc);
+        fwrite(&chunk[0], 1, chunk.size(), file);
+    }
+};
+#endif
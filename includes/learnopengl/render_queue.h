@@ -0,0 +1,254 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/frustum.h>
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+// One draw request from gameplay code: what to draw, with which shader and textures, and where.
+struct DrawPacket {
+    unsigned int Shader;      // index returned by RenderQueue::AddShader
+    unsigned int Mesh;        // index returned by RenderQueue::AddMesh
+    unsigned int TextureSet;  // index returned by RenderQueue::AddTextureSet
+    unsigned int Material;    // handed through to the mesh, e.g. the per-instance material index
+    glm::mat4 Model;
+};
+
+// State changes made by the last Execute call.
+struct RenderQueueStats {
+    unsigned int Packets;
+    unsigned int Batches;
+    unsigned int ShaderChanges;
+    unsigned int TextureChanges;
+    unsigned int VAOChanges;
+    unsigned int Culled;
+};
+
+// Decouples the order in which gameplay code submits draws from the order they reach OpenGL.
+// Every packet gets a 64 bit sort key
+//
+//   | shader (8) | texture set (12) | VAO (10) | mesh (10) | depth (24) |
+//
+// so after sorting, packets sharing a program, textures and vertex array end up next to each other
+// (and front to back within a mesh). Runs of packets with the same mesh are handed to the mesh's
+// draw function in one go, which lets instanced meshes turn a whole run into a single draw call.
+// The key has room for 256 shaders, 4096 texture sets, 1024 VAOs and 1024 meshes.
+// Packets submitted with a world space bounding box are frustum culled in one batched pass before sorting.
+class RenderQueue
+{
+public:
+    // draws a run of packets that all share shader, textures and mesh. The shader is active and the
+    // textures are bound when this is called.
+    typedef std::function<void(const std::vector<const DrawPacket*> &run)> MeshDrawFunc;
+
+    RenderQueueStats Stats;
+
+    RenderQueue() : View(1.0f), FarPlane(1.0f), Culling(false)
+    {
+        Stats = RenderQueueStats();
+    }
+
+    // registers a program, 'use' makes it current
+    unsigned int AddShader(std::function<void()> use)
+    {
+        Shaders.push_back(use);
+        return Shaders.size() - 1;
+    }
+
+    // registers a set of textures, 'bind' binds all of them
+    unsigned int AddTextureSet(std::function<void()> bind)
+    {
+        TextureSets.push_back(bind);
+        return TextureSets.size() - 1;
+    }
+
+    // registers a mesh living in 'vao'. Meshes sharing a VAO sort next to each other.
+    unsigned int AddMesh(unsigned int vao, MeshDrawFunc draw)
+    {
+        Mesh mesh;
+        mesh.VAOSlot = vaoSlot(vao);
+        mesh.Draw = draw;
+        Meshes.push_back(mesh);
+        return Meshes.size() - 1;
+    }
+
+    // starts a new frame. 'view' and 'farPlane' are used to sort packets front to back.
+    void Begin(const glm::mat4 &view, float farPlane)
+    {
+        View = view;
+        FarPlane = farPlane;
+        Culling = false;
+        Packets.clear();
+        Keys.clear();
+        Bounds.Clear();
+        BoundedPackets.clear();
+    }
+
+    // same, but packets submitted with bounds outside 'frustum' are dropped by Execute
+    void Begin(const glm::mat4 &view, float farPlane, const Frustum &frustum)
+    {
+        Begin(view, farPlane);
+        CullFrustum = frustum;
+        Culling = true;
+    }
+
+    // queues a packet for this frame
+    void Submit(const DrawPacket &packet)
+    {
+        // view space depth of the object's origin
+        float depth = -(View * packet.Model[3]).z;
+        float normalized = glm::clamp(depth / FarPlane, 0.0f, 1.0f);
+        unsigned long long key = 0;
+        key |= (unsigned long long)(packet.Shader & 0xFF) << 56;
+        key |= (unsigned long long)(packet.TextureSet & 0xFFF) << 44;
+        key |= (unsigned long long)(Meshes[packet.Mesh].VAOSlot & 0x3FF) << 34;
+        key |= (unsigned long long)(packet.Mesh & 0x3FF) << 24;
+        key |= (unsigned long long)(normalized * 0xFFFFFF);
+
+        SortKey sortKey;
+        sortKey.Key = key;
+        sortKey.Packet = Packets.size();
+        Keys.push_back(sortKey);
+        Packets.push_back(packet);
+    }
+
+    // queues a packet whose geometry lies within the world space box 'bounds'
+    void Submit(const DrawPacket &packet, const AABB &bounds)
+    {
+        Bounds.Add(bounds);
+        BoundedPackets.push_back(Packets.size());
+        Submit(packet);
+    }
+
+    // convenience overloads building the packet in place
+    void Submit(unsigned int shader, unsigned int mesh, unsigned int textureSet, unsigned int material, const glm::mat4 &model)
+    {
+        Submit(makePacket(shader, mesh, textureSet, material, model));
+    }
+    void Submit(unsigned int shader, unsigned int mesh, unsigned int textureSet, unsigned int material, const glm::mat4 &model, const AABB &bounds)
+    {
+        Submit(makePacket(shader, mesh, textureSet, material, model), bounds);
+    }
+
+    // sorts this frame's packets and submits them to OpenGL, changing state only where the key changes
+    void Execute()
+    {
+        Stats = RenderQueueStats();
+        Stats.Packets = Packets.size();
+        if (Culling && Bounds.Size() > 0)
+            cull();
+        std::sort(Keys.begin(), Keys.end());
+
+        const unsigned long long runMask = ~0xFFFFFFull; // everything but depth
+        unsigned long long previous = ~0ull;
+        size_t i = 0;
+        while (i < Keys.size())
+        {
+            unsigned long long key = Keys[i].Key;
+            const DrawPacket &first = Packets[Keys[i].Packet];
+            if ((key >> 56) != (previous >> 56))
+            {
+                Shaders[first.Shader]();
+                Stats.ShaderChanges++;
+            }
+            if (((key >> 44) & 0xFFF) != ((previous >> 44) & 0xFFF))
+            {
+                TextureSets[first.TextureSet]();
+                Stats.TextureChanges++;
+            }
+            if (((key >> 34) & 0x3FF) != ((previous >> 34) & 0x3FF))
+                Stats.VAOChanges++;
+
+            // gather the run of packets sharing everything but depth
+            Run.clear();
+            while (i < Keys.size() && (Keys[i].Key & runMask) == (key & runMask))
+            {
+                Run.push_back(&Packets[Keys[i].Packet]);
+                i++;
+            }
+            Meshes[first.Mesh].Draw(Run);
+            Stats.Batches++;
+            previous = key;
+        }
+        Packets.clear();
+        Keys.clear();
+        Bounds.Clear();
+        BoundedPackets.clear();
+    }
+
+private:
+    struct Mesh {
+        unsigned int VAOSlot;
+        MeshDrawFunc Draw;
+    };
+
+    struct SortKey {
+        unsigned long long Key;
+        size_t Packet;
+        bool operator<(const SortKey &other) const
+        {
+            // ties keep submission order so sorting is deterministic
+            return Key < other.Key || (Key == other.Key && Packet < other.Packet);
+        }
+    };
+
+    glm::mat4 View;
+    float FarPlane;
+    std::vector<std::function<void()> > Shaders;
+    std::vector<std::function<void()> > TextureSets;
+    std::vector<Mesh> Meshes;
+    std::vector<unsigned int> VAOs;
+    std::vector<DrawPacket> Packets;
+    std::vector<SortKey> Keys;
+    std::vector<const DrawPacket*> Run;
+    // culling state: the frustum, the bounds of the packets that have them and which packet each belongs to
+    Frustum CullFrustum;
+    bool Culling;
+    BoundsList Bounds;
+    std::vector<size_t> BoundedPackets;
+    std::vector<unsigned int> Visible;
+    std::vector<char> Hidden;
+
+    static DrawPacket makePacket(unsigned int shader, unsigned int mesh, unsigned int textureSet, unsigned int material, const glm::mat4 &model)
+    {
+        DrawPacket packet;
+        packet.Shader = shader;
+        packet.Mesh = mesh;
+        packet.TextureSet = textureSet;
+        packet.Material = material;
+        packet.Model = model;
+        return packet;
+    }
+
+    // drops the keys of packets whose bounds are outside the frustum
+    void cull()
+    {
+        Stats.Culled = CullBounds(CullFrustum, Bounds, Visible);
+        Hidden.assign(Packets.size(), 0);
+        for (unsigned int i = 0; i < BoundedPackets.size(); i++)
+            Hidden[BoundedPackets[i]] = 1;
+        for (unsigned int i = 0; i < Visible.size(); i++)
+            Hidden[BoundedPackets[Visible[i]]] = 0;
+        size_t kept = 0;
+        for (size_t i = 0; i < Keys.size(); i++)
+            if (!Hidden[Keys[i].Packet])
+                Keys[kept++] = Keys[i];
+        Keys.resize(kept);
+    }
+
+    // compact index of a VAO name for the sort key
+    unsigned int vaoSlot(unsigned int vao)
+    {
+        for (unsigned int i = 0; i < VAOs.size(); i++)
+            if (VAOs[i] == vao)
+                return i;
+        VAOs.push_back(vao);
+        return VAOs.size() - 1;
+    }
+};
+#endif
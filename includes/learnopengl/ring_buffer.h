@@ -0,0 +1,199 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/logger.h>
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+// A sub-range of the ring handed out for this frame. Write the data through 'Pointer' and source it
+// from 'Buffer' at 'Offset' (as vertex attributes, with glBindBufferRange, ...). A null Pointer means
+// the frame ran out of space.
+struct RingAllocation {
+    unsigned int Buffer;
+    void *Pointer;
+    size_t Offset;
+    size_t Size;
+};
+
+// Streams per-frame data to the GPU without ever waiting on the driver. With GL 4.4 the buffer is
+// allocated with glBufferStorage and mapped once, persistently and coherently, and split into
+// 'frames' slots. Each frame allocates from the next slot; a fence placed at the end of the frame
+// tells when the GPU is done with the slot, which with three slots has always happened by the time it
+// comes round again. On GL 3.3 the ring writes into client memory instead and Flush uploads it into a
+// buffer that is orphaned at the start of every frame.
+//
+//   ring.BeginFrame();
+//   RingAllocation a = ring.Allocate(size, alignment); // write size bytes to a.Pointer
+//   ring.Flush();                                      // before drawing with it
+//   ...
+//   ring.EndFrame();
+class RingBuffer
+{
+public:
+    unsigned int Buffer;
+    // true if the buffer is persistently mapped, false for the orphaning fallback
+    bool Persistent;
+    // times BeginFrame had to wait for the GPU to release a slot
+    unsigned int Stalls;
+
+    // 'frameSize' is the number of bytes every frame may allocate
+    RingBuffer(size_t frameSize, unsigned int frames = 3)
+        : Buffer(0), Persistent(false), Stalls(0), FrameSize(frameSize), Frames(frames), Slot(0), Head(0), Flushed(0),
+          Mapped(NULL), Fences(frames, (GLsync)0), Overflowed(false)
+    {
+        glGenBuffers(1, &Buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, Buffer);
+        if (GLAD_GL_VERSION_4_4)
+        {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_COPY_WRITE_BUFFER, FrameSize * Frames, NULL, flags);
+            Mapped = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, FrameSize * Frames, flags);
+            Persistent = Mapped != NULL;
+        }
+        if (!Persistent)
+        {
+            glBufferData(GL_COPY_WRITE_BUFFER, FrameSize, NULL, GL_STREAM_DRAW);
+            Staging.resize(FrameSize);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    ~RingBuffer()
+    {
+        for (unsigned int i = 0; i < Fences.size(); i++)
+            if (Fences[i])
+                glDeleteSync(Fences[i]);
+        if (Persistent)
+        {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, Buffer);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &Buffer);
+    }
+
+    // moves on to the next slot, waiting for the GPU only if it still reads from it
+    void BeginFrame()
+    {
+        Slot = (Slot + 1) % Frames;
+        Head = 0;
+        Flushed = 0;
+        Overflowed = false;
+        if (Persistent)
+        {
+            if (Fences[Slot])
+            {
+                if (glClientWaitSync(Fences[Slot], 0, 0) == GL_TIMEOUT_EXPIRED)
+                {
+                    Stalls++;
+                    while (glClientWaitSync(Fences[Slot], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+                        ;
+                }
+                glDeleteSync(Fences[Slot]);
+                Fences[Slot] = 0;
+            }
+        }
+        else
+        {
+            // orphan last frame's storage, the driver keeps it alive until the GPU is done with it
+            glBindBuffer(GL_COPY_WRITE_BUFFER, Buffer);
+            glBufferData(GL_COPY_WRITE_BUFFER, FrameSize, NULL, GL_STREAM_DRAW);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+    }
+
+    // hands out 'size' bytes of this frame's slot starting at a multiple of 'alignment'
+    RingAllocation Allocate(size_t size, size_t alignment = 16)
+    {
+        RingAllocation allocation;
+        allocation.Buffer = Buffer;
+        allocation.Size = size;
+        size_t start = (Head + alignment - 1) / alignment * alignment;
+        if (start + size > FrameSize)
+        {
+            // logged from inside the frame, so through the logger and at most once a second
+            if (!Overflowed)
+                LOG_EVERY(1.0, LEVEL_ERROR, CATEGORY_RENDER, "ERROR::RING_BUFFER::OUT_OF_SPACE %lu of %lu bytes",
+                    (unsigned long)(start + size), (unsigned long)FrameSize);
+            Overflowed = true;
+            allocation.Pointer = NULL;
+            allocation.Offset = 0;
+            return allocation;
+        }
+        Head = start + size;
+        if (Persistent)
+        {
+            allocation.Offset = Slot * FrameSize + start;
+            allocation.Pointer = Mapped + allocation.Offset;
+        }
+        else
+        {
+            allocation.Offset = start;
+            allocation.Pointer = &Staging[start];
+        }
+        return allocation;
+    }
+
+    // copies 'size' bytes into a new allocation
+    RingAllocation Write(const void *data, size_t size, size_t alignment = 16)
+    {
+        RingAllocation allocation = Allocate(size, alignment);
+        if (allocation.Pointer)
+            std::memcpy(allocation.Pointer, data, size);
+        return allocation;
+    }
+
+    // makes everything written since the last Flush visible to the GPU. Nothing to do for the
+    // coherent mapping, the fallback uploads the pending bytes.
+    void Flush()
+    {
+        if (!Persistent && Head > Flushed)
+        {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, Buffer);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, Flushed, Head - Flushed, &Staging[Flushed]);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+        Flushed = Head;
+    }
+
+    // fences the slot once all of this frame's commands using it have been issued
+    void EndFrame()
+    {
+        Flush();
+        if (Persistent)
+            Fences[Slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    // bytes allocated so far this frame
+    size_t Used() const
+    {
+        return Head;
+    }
+
+    // alignment glBindBufferRange needs for uniform buffer ranges
+    static size_t UniformAlignment()
+    {
+        GLint alignment = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        return alignment;
+    }
+
+private:
+    size_t FrameSize;
+    unsigned int Frames;
+    unsigned int Slot;
+    size_t Head, Flushed;
+    unsigned char *Mapped;
+    std::vector<unsigned char> Staging;
+    std::vector<GLsync> Fences;
+    bool Overflowed;
+
+    // owns GL objects
+    RingBuffer(const RingBuffer&);
+    RingBuffer &operator=(const RingBuffer&);
+};
+#endif
@@ -0,0 +1,117 @@
+#ifndef SCENE_GRAPH_H
+#define SCENE_GRAPH_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/matrix_kernels.h>
+
+#include <vector>
+
+// Parent/child transform hierarchy. Every node stores its transform relative to its parent once;
+// Update recomputes the world matrices of the nodes whose local transform changed since the last
+// Update and of everything below them, and leaves the rest alone. A parent is always added before
+// its children, so the nodes are kept in plain arrays in that order and one forward pass updates
+// them top down. World is contiguous, indexed by node, and can be handed to an instance buffer as is.
+class SceneGraph
+{
+public:
+    static const int NO_PARENT = -1;
+
+    // world matrix of every node, valid after Update
+    std::vector<glm::mat4> World;
+
+    SceneGraph() : FirstDirty(0)
+    {
+    }
+
+    // adds a node below 'parent' (or a root), returns its index
+    int Add(const glm::mat4 &local, int parent = NO_PARENT)
+    {
+        Locals.push_back(local);
+        Parents.push_back(parent);
+        Dirty.push_back(1);
+        World.push_back(local);
+        return Locals.size() - 1;
+    }
+
+    // changes the node's transform relative to its parent, marking its subtree dirty if it differs
+    void SetLocal(int node, const glm::mat4 &local)
+    {
+        if (Locals[node] == local)
+            return;
+        Locals[node] = local;
+        Dirty[node] = 1;
+        if (node < FirstDirty)
+            FirstDirty = node;
+    }
+
+    // removes every node, keeping the storage
+    void Clear()
+    {
+        Locals.clear();
+        Parents.clear();
+        Dirty.clear();
+        World.clear();
+        FirstDirty = 0;
+    }
+
+    const glm::mat4 &Local(int node) const
+    {
+        return Locals[node];
+    }
+
+    int Parent(int node) const
+    {
+        return Parents[node];
+    }
+
+    size_t Size() const
+    {
+        return Locals.size();
+    }
+
+    // recomputes the world matrices of the dirty subtrees, returns how many nodes it recomputed
+    unsigned int Update()
+    {
+        const MatrixKernelSet &kernels = MatrixKernels::Active();
+        unsigned int updated = 0;
+        int count = Locals.size();
+        for (int i = FirstDirty; i < count; )
+        {
+            int parent = Parents[i];
+            // parents come first, so a dirty flag set here reaches every descendant in the same pass
+            if (parent != NO_PARENT && Dirty[parent])
+                Dirty[i] = 1;
+            if (!Dirty[i])
+            {
+                i++;
+                continue;
+            }
+            if (parent == NO_PARENT)
+            {
+                World[i] = Locals[i];
+                updated++;
+                i++;
+                continue;
+            }
+            // dirty siblings stored next to each other are multiplied by their parent in one batch
+            int last = i + 1;
+            while (last < count && Parents[last] == parent && (Dirty[last] || Dirty[parent]))
+                Dirty[last++] = 1;
+            kernels.MultiplyParent(World[parent], &Locals[i], &World[i], last - i);
+            updated += last - i;
+            i = last;
+        }
+        for (int i = FirstDirty; i < count; i++)
+            Dirty[i] = 0;
+        FirstDirty = count;
+        return updated;
+    }
+
+private:
+    std::vector<glm::mat4> Locals;
+    std::vector<int> Parents;
+    std::vector<unsigned char> Dirty;
+    int FirstDirty; // nodes before it are clean
+};
+#endif
@@ -4,19 +4,28 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <learnopengl/gl_state.h>
+#include <learnopengl/profiler.h>
+#include <learnopengl/uniform_buffer.h>
+#include <learnopengl/uniform_cache.h>
+
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <memory>
 
 class Shader
 {
 public:
     unsigned int ID;
+    // active uniforms of the program, shared between copies of the Shader so they agree on the current values
+    std::shared_ptr<UniformCache> Uniforms;
     // constructor generates the shader on the fly
     // ------------------------------------------------------------------------
     Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
     {
+        PROFILE_ZONE("Shader compile");
         // 1. retrieve the vertex/fragment source code from filePath
         std::string vertexCode;
         std::string fragmentCode;
@@ -91,6 +100,9 @@ public:
             glAttachShader(ID, geometry);
         glLinkProgram(ID);
         checkCompileErrors(ID, "PROGRAM");
+        Uniforms = std::make_shared<UniformCache>();
+        Uniforms->Reflect(ID);
+        bindUniformBlocks(ID);
         // delete the shaders as they're linked into our program now and no longer necessery
         glDeleteShader(vertex);
         glDeleteShader(fragment);
@@ -102,65 +114,125 @@ public:
     // ------------------------------------------------------------------------
     void use() 
     { 
-        glUseProgram(ID); 
+        GLState::Get().UseProgram(ID); 
+    }
+    // handle of the uniform 'name', look it up once and keep it around for the setters below
+    // ------------------------------------------------------------------------
+    UniformHandle uniform(const char *name) const
+    {
+        return Uniforms->Find(name);
+    }
+    // number of uniform writes skipped because the value was already set
+    unsigned long long skippedUniforms() const
+    {
+        return Uniforms->Skipped;
     }
-    // utility uniform functions
+    // utility uniform functions. Locations come from the table built at link time and
+    // values that are already set are not sent again.
     // ------------------------------------------------------------------------
     void setBool(const std::string &name, bool value) const
-    {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+    {
+        Uniforms->Set(Uniforms->Find(name.c_str()), (int)value);
+    }
+    void setBool(UniformHandle uniform, bool value) const
+    {
+        Uniforms->Set(uniform, (int)value);
     }
     // ------------------------------------------------------------------------
     void setInt(const std::string &name, int value) const
-    { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+    {
+        Uniforms->Set(Uniforms->Find(name.c_str()), value);
+    }
+    void setInt(UniformHandle uniform, int value) const
+    {
+        Uniforms->Set(uniform, value);
     }
     // ------------------------------------------------------------------------
     void setFloat(const std::string &name, float value) const
-    { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+    {
+        Uniforms->Set(Uniforms->Find(name.c_str()), value);
+    }
+    void setFloat(UniformHandle uniform, float value) const
+    {
+        Uniforms->Set(uniform, value);
     }
     // ------------------------------------------------------------------------
     void setVec2(const std::string &name, const glm::vec2 &value) const
-    { 
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+    {
+        Uniforms->Set(Uniforms->Find(name.c_str()), value);
+    }
+    void setVec2(UniformHandle uniform, const glm::vec2 &value) const
+    {
+        Uniforms->Set(uniform, value);
     }
     void setVec2(const std::string &name, float x, float y) const
-    { 
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y); 
+    {
+        Uniforms->Set(Uniforms->Find(name.c_str()), glm::vec2(x, y));
+    }
+    void setVec2(UniformHandle uniform, float x, float y) const
+    {
+        Uniforms->Set(uniform, glm::vec2(x, y));
     }
     // ------------------------------------------------------------------------
     void setVec3(const std::string &name, const glm::vec3 &value) const
-    { 
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+    {
+        Uniforms->Set(Uniforms->Find(name.c_str()), value);
+    }
+    void setVec3(UniformHandle uniform, const glm::vec3 &value) const
+    {
+        Uniforms->Set(uniform, value);
     }
     void setVec3(const std::string &name, float x, float y, float z) const
-    { 
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z); 
+    {
+        Uniforms->Set(Uniforms->Find(name.c_str()), glm::vec3(x, y, z));
+    }
+    void setVec3(UniformHandle uniform, float x, float y, float z) const
+    {
+        Uniforms->Set(uniform, glm::vec3(x, y, z));
     }
     // ------------------------------------------------------------------------
     void setVec4(const std::string &name, const glm::vec4 &value) const
-    { 
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+    {
+        Uniforms->Set(Uniforms->Find(name.c_str()), value);
     }
-    void setVec4(const std::string &name, float x, float y, float z, float w) 
-    { 
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w); 
+    void setVec4(UniformHandle uniform, const glm::vec4 &value) const
+    {
+        Uniforms->Set(uniform, value);
+    }
+    void setVec4(const std::string &name, float x, float y, float z, float w) const
+    {
+        Uniforms->Set(Uniforms->Find(name.c_str()), glm::vec4(x, y, z, w));
+    }
+    void setVec4(UniformHandle uniform, float x, float y, float z, float w) const
+    {
+        Uniforms->Set(uniform, glm::vec4(x, y, z, w));
     }
     // ------------------------------------------------------------------------
     void setMat2(const std::string &name, const glm::mat2 &mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        Uniforms->Set(Uniforms->Find(name.c_str()), mat);
+    }
+    void setMat2(UniformHandle uniform, const glm::mat2 &mat) const
+    {
+        Uniforms->Set(uniform, mat);
     }
     // ------------------------------------------------------------------------
     void setMat3(const std::string &name, const glm::mat3 &mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        Uniforms->Set(Uniforms->Find(name.c_str()), mat);
+    }
+    void setMat3(UniformHandle uniform, const glm::mat3 &mat) const
+    {
+        Uniforms->Set(uniform, mat);
     }
     // ------------------------------------------------------------------------
     void setMat4(const std::string &name, const glm::mat4 &mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        Uniforms->Set(Uniforms->Find(name.c_str()), mat);
+    }
+    void setMat4(UniformHandle uniform, const glm::mat4 &mat) const
+    {
+        Uniforms->Set(uniform, mat);
     }
 
 private:
@@ -3,19 +3,28 @@
 
 #include <glad/glad.h>
 
+#include <learnopengl/gl_state.h>
+#include <learnopengl/profiler.h>
+#include <learnopengl/uniform_buffer.h>
+#include <learnopengl/uniform_cache.h>
+
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <memory>
 
 class Shader
 {
 public:
     unsigned int ID;
+    // active uniforms of the program, shared between copies of the Shader so they agree on the current values
+    std::shared_ptr<UniformCache> Uniforms;
     // constructor generates the shader on the fly
     // ------------------------------------------------------------------------
     Shader(const char* vertexPath, const char* fragmentPath)
     {
+        PROFILE_ZONE("Shader compile");
         // 1. retrieve the vertex/fragment source code from filePath
         std::string vertexCode;
         std::string fragmentCode;
@@ -66,6 +75,9 @@ public:
         glAttachShader(ID, fragment);
         glLinkProgram(ID);
         checkCompileErrors(ID, "PROGRAM");
+        Uniforms = std::make_shared<UniformCache>();
+        Uniforms->Reflect(ID);
+        bindUniformBlocks(ID);
         // delete the shaders as they're linked into our program now and no longer necessary
         glDeleteShader(vertex);
         glDeleteShader(fragment);
@@ -74,23 +86,47 @@ public:
     // ------------------------------------------------------------------------
     void use() 
     { 
-        glUseProgram(ID); 
+        GLState::Get().UseProgram(ID); 
     }
-    // utility uniform functions
+    // handle of the uniform 'name', look it up once and keep it around for the setters below
+    // ------------------------------------------------------------------------
+    UniformHandle uniform(const char *name) const
+    {
+        return Uniforms->Find(name);
+    }
+    // number of uniform writes skipped because the value was already set
+    unsigned long long skippedUniforms() const
+    {
+        return Uniforms->Skipped;
+    }
+    // utility uniform functions. Locations come from the table built at link time and
+    // values that are already set are not sent again.
     // ------------------------------------------------------------------------
     void setBool(const std::string &name, bool value) const
-    {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+    {
+        Uniforms->Set(Uniforms->Find(name.c_str()), (int)value);
+    }
+    void setBool(UniformHandle uniform, bool value) const
+    {
+        Uniforms->Set(uniform, (int)value);
     }
     // ------------------------------------------------------------------------
     void setInt(const std::string &name, int value) const
-    { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+    {
+        Uniforms->Set(Uniforms->Find(name.c_str()), value);
+    }
+    void setInt(UniformHandle uniform, int value) const
+    {
+        Uniforms->Set(uniform, value);
     }
     // ------------------------------------------------------------------------
     void setFloat(const std::string &name, float value) const
-    { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+    {
+        Uniforms->Set(Uniforms->Find(name.c_str()), value);
+    }
+    void setFloat(UniformHandle uniform, float value) const
+    {
+        Uniforms->Set(uniform, value);
     }
 
 private:
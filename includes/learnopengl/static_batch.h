@@ -0,0 +1,278 @@
+#ifndef STATIC_BATCH_H
+#define STATIC_BATCH_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/frustum.h>
+#include <learnopengl/gl_state.h>
+#include <learnopengl/indirect_draw.h>
+
+#include <cstddef>
+#include <vector>
+
+// Vertex layout shared by the box geometry: position, normal, texture coordinates,
+// plus the material the vertex belongs to.
+struct BakedVertex {
+    glm::vec3 Position;
+    glm::vec3 Normal;
+    glm::vec2 TexCoords;
+    unsigned int Material;
+};
+
+// Range of the index buffer that is drawn with a single material (a whole material, or one added piece).
+struct DrawRange {
+    unsigned int Material;
+    unsigned int FirstIndex;
+    unsigned int IndexCount;
+    AABB Bounds;             // world space bounds of the range's vertices
+};
+
+// Bakes geometry that never moves into world space once at startup. Every piece added is
+// transformed on the CPU, merged with everything else sharing its material and stored in one
+// vertex and one index buffer, so drawing the whole static world needs no matrix math and only
+// one draw call per material, or a single one for shaders that read the material per vertex.
+class StaticBatch
+{
+public:
+    unsigned int VAO;
+    std::vector<DrawRange> Ranges;
+    // one range per Add call baked by the last Bake, grouped by material
+    std::vector<DrawRange> Objects;
+    // one command per object, for drawing everything with DrawIndirect
+    IndirectBuffer Indirect;
+    // bounds of every object, in the same order, for Cull
+    BoundsList ObjectBounds;
+    // number of draw calls issued by the last Draw call
+    unsigned int DrawCalls;
+
+    // constructor, 'materialCount' is the number of distinct materials the pieces can use. Shaders read
+    // the model matrix at 'modelLocation' (four locations) and the material index right after it,
+    // matching the layout of InstanceData.
+    StaticBatch(unsigned int materialCount, unsigned int modelLocation = 3)
+        : VAO(0), DrawCalls(0), VBO(0), EBO(0), ModelLocation(modelLocation), IndexCount(0), Pieces(materialCount)
+    {
+    }
+
+    // transforms 'vertexCount' interleaved vertices (3 position, 3 normal, 2 texture floats each)
+    // by 'model' and queues them under 'material'. Triangle lists only; duplicate vertices are
+    // merged so the result can be drawn indexed.
+    void Add(unsigned int material, const float *vertices, unsigned int vertexCount, const glm::mat4 &model)
+    {
+        glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+        Piece &piece = Pieces[material];
+        unsigned int base = piece.Vertices.size();
+        DrawRange object;
+        object.Material = material;
+        object.FirstIndex = piece.Indices.size();
+        object.IndexCount = vertexCount;
+        piece.Objects.push_back(Objects.size());
+        Objects.push_back(object);
+        for (unsigned int i = 0; i < vertexCount; i++)
+        {
+            const float *v = vertices + i * 8;
+            BakedVertex vertex;
+            vertex.Position = glm::vec3(model * glm::vec4(v[0], v[1], v[2], 1.0f));
+            vertex.Normal = glm::normalize(normalMatrix * glm::vec3(v[3], v[4], v[5]));
+            vertex.TexCoords = glm::vec2(v[6], v[7]);
+            vertex.Material = material;
+            Objects.back().Bounds.Extend(vertex.Position);
+
+            // reuse an identical vertex of the same piece if there is one
+            unsigned int index = piece.Vertices.size();
+            for (unsigned int j = base; j < piece.Vertices.size(); j++)
+            {
+                if (sameVertex(piece.Vertices[j], vertex))
+                {
+                    index = j;
+                    break;
+                }
+            }
+            if (index == piece.Vertices.size())
+                piece.Vertices.push_back(vertex);
+            piece.Indices.push_back(index);
+        }
+    }
+
+    // uploads everything added so far into the GPU buffers and builds the per-material draw ranges
+    void Bake()
+    {
+        std::vector<BakedVertex> vertices;
+        std::vector<unsigned int> indices;
+        std::vector<DrawRange> objects;
+        Ranges.clear();
+        for (unsigned int i = 0; i < Pieces.size(); i++)
+        {
+            if (Pieces[i].Indices.empty())
+                continue;
+            DrawRange range;
+            range.Material = i;
+            range.FirstIndex = indices.size();
+            range.IndexCount = Pieces[i].Indices.size();
+
+            // object ranges were recorded relative to their piece
+            for (unsigned int j = 0; j < Pieces[i].Objects.size(); j++)
+            {
+                DrawRange object = Objects[Pieces[i].Objects[j]];
+                object.FirstIndex += range.FirstIndex;
+                range.Bounds.Extend(object.Bounds.Min);
+                range.Bounds.Extend(object.Bounds.Max);
+                objects.push_back(object);
+            }
+            Ranges.push_back(range);
+
+            unsigned int base = vertices.size();
+            vertices.insert(vertices.end(), Pieces[i].Vertices.begin(), Pieces[i].Vertices.end());
+            for (unsigned int j = 0; j < Pieces[i].Indices.size(); j++)
+                indices.push_back(base + Pieces[i].Indices[j]);
+            Pieces[i].Vertices.clear();
+            Pieces[i].Indices.clear();
+            Pieces[i].Objects.clear();
+        }
+        Objects.swap(objects);
+        Indirect.Commands.clear();
+        ObjectBounds.Clear();
+        for (unsigned int i = 0; i < Objects.size(); i++)
+        {
+            Indirect.Add(Objects[i].IndexCount, Objects[i].FirstIndex, 0);
+            ObjectBounds.Add(Objects[i].Bounds);
+        }
+        Indirect.Upload();
+        IndexCount = indices.size();
+        if (indices.empty())
+            return;
+
+        if (VAO == 0)
+        {
+            glGenVertexArrays(1, &VAO);
+            glGenBuffers(1, &VBO);
+            glGenBuffers(1, &EBO);
+        }
+        GLState::Get().BindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(BakedVertex), &vertices[0], GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+
+        // vertex positions
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(BakedVertex), (void*)offsetof(BakedVertex, Position));
+        // vertex normals
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(BakedVertex), (void*)offsetof(BakedVertex, Normal));
+        // vertex texture coords
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(BakedVertex), (void*)offsetof(BakedVertex, TexCoords));
+        // vertex material
+        glEnableVertexAttribArray(ModelLocation + 4);
+        glVertexAttribIPointer(ModelLocation + 4, 1, GL_UNSIGNED_INT, sizeof(BakedVertex), (void*)offsetof(BakedVertex, Material));
+        GLState::Get().BindVertexArray(0);
+    }
+
+    // draws every material range, calling 'bindMaterial' before each one
+    template <typename BindMaterial>
+    void Draw(BindMaterial bindMaterial)
+    {
+        DrawCalls = 0;
+        if (Ranges.empty())
+            return;
+        setIdentityModel();
+
+        GLState::Get().BindVertexArray(VAO);
+        for (unsigned int i = 0; i < Ranges.size(); i++)
+        {
+            bindMaterial(Ranges[i].Material);
+            glDrawElements(GL_TRIANGLES, Ranges[i].IndexCount, GL_UNSIGNED_INT, (void*)(Ranges[i].FirstIndex * sizeof(unsigned int)));
+            DrawCalls++;
+        }
+    }
+
+    // draws all ranges with a single call, for shaders that pick their textures from the vertex material
+    void Draw()
+    {
+        DrawCalls = 0;
+        if (Ranges.empty())
+            return;
+        setIdentityModel();
+
+        GLState::Get().BindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, IndexCount, GL_UNSIGNED_INT, 0);
+        DrawCalls++;
+    }
+
+    // draws every object with a single multi-draw from the indirect buffer. Set an object's
+    // InstanceCount in Indirect.Commands to 0 (and Upload) to leave it out.
+    void DrawIndirect()
+    {
+        DrawCalls = 0;
+        if (Ranges.empty())
+            return;
+        setIdentityModel();
+
+        GLState::Get().BindVertexArray(VAO);
+        Indirect.Draw(GL_TRIANGLES);
+        DrawCalls++;
+    }
+
+    // leaves the objects outside 'frustum' out of the following DrawIndirect calls, returns how many that are
+    unsigned int Cull(const Frustum &frustum)
+    {
+        CullBounds(frustum, ObjectBounds, Visible);
+        return SetVisible(Visible);
+    }
+
+    // same as Cull with the visibility worked out elsewhere (e.g. by a BVH query): only the objects listed
+    // in 'visible', in ascending order, are drawn. Returns how many are left out.
+    unsigned int SetVisible(const std::vector<unsigned int> &visible)
+    {
+        bool changed = false;
+        unsigned int next = 0;
+        for (unsigned int i = 0; i < Indirect.Commands.size(); i++)
+        {
+            unsigned int instances = 0;
+            if (next < visible.size() && visible[next] == i)
+            {
+                instances = 1;
+                next++;
+            }
+            changed = changed || Indirect.Commands[i].InstanceCount != instances;
+            Indirect.Commands[i].InstanceCount = instances;
+        }
+        if (changed)
+            Indirect.Upload();
+        return Indirect.Commands.size() - next;
+    }
+
+private:
+    // geometry queued for one material before baking
+    struct Piece {
+        std::vector<BakedVertex> Vertices;
+        std::vector<unsigned int> Indices;
+        std::vector<unsigned int> Objects; // indices into Objects
+    };
+
+    unsigned int VBO, EBO;
+    unsigned int ModelLocation;
+    unsigned int IndexCount;
+    std::vector<Piece> Pieces;
+    std::vector<unsigned int> Visible;
+
+    // the geometry is already in world space, so shaders reading a per-instance model and normal
+    // matrix (laid out as in InstanceBatch) get the identity through the constant attribute values
+    void setIdentityModel()
+    {
+        glVertexAttrib4f(ModelLocation + 0, 1.0f, 0.0f, 0.0f, 0.0f);
+        glVertexAttrib4f(ModelLocation + 1, 0.0f, 1.0f, 0.0f, 0.0f);
+        glVertexAttrib4f(ModelLocation + 2, 0.0f, 0.0f, 1.0f, 0.0f);
+        glVertexAttrib4f(ModelLocation + 3, 0.0f, 0.0f, 0.0f, 1.0f);
+        glVertexAttrib3f(ModelLocation + 5, 1.0f, 0.0f, 0.0f);
+        glVertexAttrib3f(ModelLocation + 6, 0.0f, 1.0f, 0.0f);
+        glVertexAttrib3f(ModelLocation + 7, 0.0f, 0.0f, 1.0f);
+    }
+
+    static bool sameVertex(const BakedVertex &a, const BakedVertex &b)
+    {
+        return a.Position == b.Position && a.Normal == b.Normal && a.TexCoords == b.TexCoords;
+    }
+};
+#endif
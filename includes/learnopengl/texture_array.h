@@ -0,0 +1,167 @@
+#ifndef TEXTURE_ARRAY_H
+#define TEXTURE_ARRAY_H
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include <learnopengl/gl_state.h>
+#include <learnopengl/profiler.h>
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+// Where a loaded image ended up: which size class (and therefore which array texture) and which layer.
+struct TextureLayer {
+    int SizeClass;
+    int Layer;
+};
+
+// Loads images into GL_TEXTURE_2D_ARRAY textures instead of one GL_TEXTURE_2D each. Images are
+// resampled to the power of two closest to their larger side and every size class becomes one array,
+// so a shader can reach every texture through a handful of samplers bound once at startup.
+class TextureArrays
+{
+public:
+    // array texture of each size class, valid after Build
+    std::vector<unsigned int> IDs;
+    // edge length of each size class in texels
+    std::vector<int> Sizes;
+
+    // decodes the image at 'path' and queues it for its size class. Returns its handle for Lookup.
+    unsigned int Add(const std::string &path)
+    {
+        PROFILE_ZONE("TextureArrays::Add");
+        Image image;
+        int width = 1, height = 1, nrComponents;
+        stbi_set_flip_vertically_on_load(true); // tell stb_image.h to flip loaded texture's on the y-axis.
+        unsigned char *data = stbi_load(path.c_str(), &width, &height, &nrComponents, 4);
+        if (data)
+        {
+            image.Size = sizeClass(width, height);
+            image.Pixels = resample(data, width, height, image.Size);
+            stbi_image_free(data);
+        }
+        else
+        {
+            // keep the handle valid, an opaque white layer shows up instead of the missing image
+            std::cout << "Texture failed to load at path: " << path << std::endl;
+            image.Size = 1;
+            image.Pixels.assign(4, 255);
+        }
+        image.Location.SizeClass = classIndex(image.Size);
+        image.Location.Layer = LayerCounts[image.Location.SizeClass]++;
+        Images.push_back(image);
+        return Images.size() - 1;
+    }
+
+    // size class and layer of the image with the given handle
+    TextureLayer Lookup(unsigned int handle) const
+    {
+        return Images[handle].Location;
+    }
+
+    // creates one array texture per size class, uploads all queued images and generates their mipmaps.
+    // The decoded pixels are released afterwards.
+    void Build()
+    {
+        PROFILE_ZONE("TextureArrays::Build");
+        PROFILE_GPU_ZONE("TextureArrays::Build");
+        IDs.resize(Sizes.size());
+        glGenTextures(IDs.size(), &IDs[0]);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (unsigned int i = 0; i < IDs.size(); i++)
+        {
+            GLState::Get().BindTexture(GL_TEXTURE_2D_ARRAY, IDs[i]);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, Sizes[i], Sizes[i], LayerCounts[i], 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+            for (unsigned int j = 0; j < Images.size(); j++)
+            {
+                if (Images[j].Location.SizeClass != (int)i)
+                    continue;
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, Images[j].Location.Layer, Sizes[i], Sizes[i], 1, GL_RGBA, GL_UNSIGNED_BYTE, &Images[j].Pixels[0]);
+                std::vector<unsigned char>().swap(Images[j].Pixels);
+            }
+            glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        }
+        GLState::Get().BindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+
+    // binds size class i to texture unit firstUnit + i, units already holding the right array are skipped
+    void Bind(unsigned int firstUnit = 0) const
+    {
+        for (unsigned int i = 0; i < IDs.size(); i++)
+            GLState::Get().BindTextureUnit(firstUnit + i, GL_TEXTURE_2D_ARRAY, IDs[i]);
+    }
+
+private:
+    // decoded image waiting for Build
+    struct Image {
+        int Size;
+        TextureLayer Location;
+        std::vector<unsigned char> Pixels;
+    };
+
+    std::vector<Image> Images;
+    std::vector<int> LayerCounts;
+
+    // power of two closest to the larger side of the image
+    static int sizeClass(int width, int height)
+    {
+        int longest = width > height ? width : height;
+        int size = 1;
+        while (size * 2 <= longest)
+            size *= 2;
+        if (longest - size > size * 2 - longest)
+            size *= 2;
+        return size;
+    }
+
+    // index of the size class with edge 'size', creating it on first use
+    int classIndex(int size)
+    {
+        for (unsigned int i = 0; i < Sizes.size(); i++)
+            if (Sizes[i] == size)
+                return i;
+        Sizes.push_back(size);
+        LayerCounts.push_back(0);
+        return Sizes.size() - 1;
+    }
+
+    // bilinear resample of an RGBA image to size x size texels
+    static std::vector<unsigned char> resample(const unsigned char *data, int width, int height, int size)
+    {
+        std::vector<unsigned char> out(size * size * 4);
+        if (width == size && height == size)
+        {
+            out.assign(data, data + size * size * 4);
+            return out;
+        }
+        for (int y = 0; y < size; y++)
+        {
+            // texel centres of the target mapped into the source image
+            float fy = (y + 0.5f) * height / size - 0.5f;
+            int y0 = fy < 0.0f ? 0 : (int)fy;
+            int y1 = y0 + 1 < height ? y0 + 1 : height - 1;
+            float ty = fy < 0.0f ? 0.0f : fy - y0;
+            for (int x = 0; x < size; x++)
+            {
+                float fx = (x + 0.5f) * width / size - 0.5f;
+                int x0 = fx < 0.0f ? 0 : (int)fx;
+                int x1 = x0 + 1 < width ? x0 + 1 : width - 1;
+                float tx = fx < 0.0f ? 0.0f : fx - x0;
+                for (int c = 0; c < 4; c++)
+                {
+                    float top    = data[(y0 * width + x0) * 4 + c] * (1.0f - tx) + data[(y0 * width + x1) * 4 + c] * tx;
+                    float bottom = data[(y1 * width + x0) * 4 + c] * (1.0f - tx) + data[(y1 * width + x1) * 4 + c] * tx;
+                    out[(y * size + x) * 4 + c] = (unsigned char)(top * (1.0f - ty) + bottom * ty + 0.5f);
+                }
+            }
+        }
+        return out;
+    }
+};
+#endif
@@ -0,0 +1,151 @@
+#ifndef UNIFORM_BUFFER_H
+#define UNIFORM_BUFFER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/ring_buffer.h>
+
+#include <cstring>
+
+// Fixed binding points of the uniform blocks every program shares. Shader binds any of these
+// blocks it finds in a program right after linking, so one buffer per block serves all programs.
+enum UniformBlockBinding {
+    FRAME_DATA_BINDING = 0,
+    LIGHT_DATA_BINDING = 1
+};
+
+const unsigned int MAX_POINT_LIGHTS = 4;
+
+// The structs below mirror the std140 blocks declared in the shaders:
+//
+//   layout (std140) uniform FrameData {
+//       mat4 view;
+//       mat4 projection;
+//       vec3 viewPos;
+//   };
+//   layout (std140) uniform LightData {
+//       PointLight pointLights[MAX_POINT_LIGHTS];
+//       DirLight dirLight;
+//       SpotLight spotLight;
+//   };
+//
+// std140 aligns a vec3 to 16 bytes, so every vec3 is followed by a float (either a real member
+// or padding) and the C++ side can use glm::vec3 without any manual offsets.
+struct FrameData {
+    glm::mat4 View;
+    glm::mat4 Projection;
+    glm::vec3 ViewPos;
+    float Padding;
+};
+
+struct DirLightData {
+    glm::vec3 Direction;
+    float Padding0;
+    glm::vec3 Ambient;
+    float Padding1;
+    glm::vec3 Diffuse;
+    float Padding2;
+    glm::vec3 Specular;
+    float Padding3;
+};
+
+struct PointLightData {
+    glm::vec3 Position;
+    float Constant;
+    glm::vec3 Ambient;
+    float Linear;
+    glm::vec3 Diffuse;
+    float Quadratic;
+    glm::vec3 Specular;
+    float Padding;
+};
+
+struct SpotLightData {
+    glm::vec3 Position;
+    float CutOff;
+    glm::vec3 Direction;
+    float OuterCutOff;
+    glm::vec3 Ambient;
+    float Constant;
+    glm::vec3 Diffuse;
+    float Linear;
+    glm::vec3 Specular;
+    float Quadratic;
+};
+
+struct LightData {
+    PointLightData PointLights[MAX_POINT_LIGHTS];
+    DirLightData DirLight;
+    SpotLightData SpotLight;
+};
+
+static_assert(sizeof(FrameData) == 144, "FrameData does not match its std140 layout");
+static_assert(sizeof(PointLightData) == 64 && sizeof(DirLightData) == 64 && sizeof(SpotLightData) == 80, "light structs do not match their std140 layout");
+static_assert(sizeof(LightData) == MAX_POINT_LIGHTS * 64 + 64 + 80, "LightData does not match its std140 layout");
+
+// binds the shared uniform blocks 'program' declares to their fixed binding points
+inline void bindUniformBlocks(unsigned int program)
+{
+    unsigned int frameData = glGetUniformBlockIndex(program, "FrameData");
+    if (frameData != GL_INVALID_INDEX)
+        glUniformBlockBinding(program, frameData, FRAME_DATA_BINDING);
+    unsigned int lightData = glGetUniformBlockIndex(program, "LightData");
+    if (lightData != GL_INVALID_INDEX)
+        glUniformBlockBinding(program, lightData, LIGHT_DATA_BINDING);
+}
+
+// Uniform buffer holding one T, attached to 'binding' for its whole lifetime. Update writes the
+// whole block with a single glBufferSubData, and only if it changed since the last write.
+// Given a RingBuffer the block is streamed instead: every Update copies it into this frame's slot of
+// the ring and binds that range, so it has to be called every frame between BeginFrame and EndFrame.
+template <typename T>
+class UniformBuffer
+{
+public:
+    unsigned int UBO;
+
+    UniformBuffer(unsigned int binding, RingBuffer *ring = NULL)
+        : UBO(0), Binding(binding), Ring(ring), Alignment(0), Valid(false)
+    {
+        if (Ring)
+        {
+            Alignment = RingBuffer::UniformAlignment();
+            return;
+        }
+        glGenBuffers(1, &UBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(T), NULL, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, binding, UBO);
+    }
+
+    void Update(const T &data)
+    {
+        if (Ring)
+        {
+            RingAllocation allocation = Ring->Write(&data, sizeof(T), Alignment);
+            if (allocation.Pointer)
+            {
+                Ring->Flush();
+                glBindBufferRange(GL_UNIFORM_BUFFER, Binding, allocation.Buffer, allocation.Offset, sizeof(T));
+            }
+            return;
+        }
+        if (Valid && std::memcmp(&Last, &data, sizeof(T)) == 0)
+            return;
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(T), &data);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        Last = data;
+        Valid = true;
+    }
+
+private:
+    unsigned int Binding;
+    RingBuffer *Ring;
+    size_t Alignment;
+    T Last;
+    bool Valid;
+};
+#endif
@@ -0,0 +1,289 @@
+#ifndef UNIFORM_CACHE_H
+#define UNIFORM_CACHE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Resolved uniform of a program, returned by UniformCache::Find (and Shader::uniform).
+// Setting an invalid handle does nothing, just like setting location -1.
+struct UniformHandle {
+    int Index;
+
+    UniformHandle() : Index(-1) {}
+    explicit UniformHandle(int index) : Index(index) {}
+    bool Valid() const { return Index >= 0; }
+};
+
+// All active uniforms of a linked program, reflected once through GL_ACTIVE_UNIFORMS into an open
+// addressing hash table so looking a name up neither allocates nor calls glGetUniformLocation.
+// It also remembers the last value written to every uniform and skips the glUniform* call when
+// the same value is set again. Uniforms are per program state, so the shadow stays valid across
+// program switches as long as every write goes through the cache. Set* write to whatever program
+// is current, so the reflected one has to be bound when they are called: the shadow would otherwise
+// record a value another program received. Debug builds assert this.
+class UniformCache
+{
+public:
+    // number of glUniform* calls skipped because the value did not change
+    unsigned long long Skipped;
+
+    UniformCache() : Skipped(0), Program(0) {}
+
+    // reads all active uniforms of 'program'. Arrays of basic types get one entry per element
+    // ("name[0]", "name[1]", ...) plus "name" as an alias of the first element.
+    void Reflect(unsigned int program)
+    {
+        Program = program;
+        Entries.clear();
+        Keys.clear();
+        Names.clear();
+        int count = 0, maxLength = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<char> name(maxLength + 1);
+        for (int i = 0; i < count; i++)
+        {
+            GLint size = 0;
+            GLenum type = 0;
+            GLsizei length = 0;
+            glGetActiveUniform(program, i, (GLsizei)name.size(), &length, &size, &type, &name[0]);
+            std::string uniformName(&name[0], length);
+            // uniforms living in a uniform block have no location
+            int location = glGetUniformLocation(program, uniformName.c_str());
+            if (location < 0)
+                continue;
+            if (size > 1 && uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0)
+            {
+                std::string base = uniformName.substr(0, uniformName.size() - 3);
+                addEntry(uniformName, location, size);
+                addKey(base, Entries.size() - 1);
+                for (int j = 1; j < size; j++)
+                {
+                    std::string element = base + "[" + std::to_string(j) + "]";
+                    addEntry(element, glGetUniformLocation(program, element.c_str()), size - j);
+                }
+            }
+            else
+                addEntry(uniformName, location, 1);
+        }
+        buildTable();
+    }
+
+    // handle of the uniform called 'name', invalid if the program has no such active uniform
+    UniformHandle Find(const char *name) const
+    {
+        if (Slots.empty())
+            return UniformHandle();
+        unsigned int mask = Slots.size() - 1;
+        for (unsigned int slot = hash(name) & mask; Slots[slot] >= 0; slot = (slot + 1) & mask)
+        {
+            const Key &key = Keys[Slots[slot]];
+            if (std::strcmp(&Names[key.Name], name) == 0)
+                return UniformHandle(key.Entry);
+        }
+        return UniformHandle();
+    }
+
+    // location of the uniform, -1 for invalid handles
+    int Location(UniformHandle uniform) const
+    {
+        return uniform.Valid() ? Entries[uniform.Index].Location : -1;
+    }
+
+    // ------------------------------------------------------------------------
+    void Set(UniformHandle uniform, int value)
+    {
+        if (changed(uniform, &value, sizeof(value)))
+            glUniform1i(Entries[uniform.Index].Location, value);
+    }
+    void Set(UniformHandle uniform, float value)
+    {
+        if (changed(uniform, &value, sizeof(value)))
+            glUniform1f(Entries[uniform.Index].Location, value);
+    }
+    void Set(UniformHandle uniform, const glm::vec2 &value)
+    {
+        if (changed(uniform, &value[0], sizeof(value)))
+            glUniform2fv(Entries[uniform.Index].Location, 1, &value[0]);
+    }
+    void Set(UniformHandle uniform, const glm::vec3 &value)
+    {
+        if (changed(uniform, &value[0], sizeof(value)))
+            glUniform3fv(Entries[uniform.Index].Location, 1, &value[0]);
+    }
+    void Set(UniformHandle uniform, const glm::vec4 &value)
+    {
+        if (changed(uniform, &value[0], sizeof(value)))
+            glUniform4fv(Entries[uniform.Index].Location, 1, &value[0]);
+    }
+    void Set(UniformHandle uniform, const glm::mat2 &value)
+    {
+        if (changed(uniform, &value[0][0], sizeof(value)))
+            glUniformMatrix2fv(Entries[uniform.Index].Location, 1, GL_FALSE, &value[0][0]);
+    }
+    void Set(UniformHandle uniform, const glm::mat3 &value)
+    {
+        if (changed(uniform, &value[0][0], sizeof(value)))
+            glUniformMatrix3fv(Entries[uniform.Index].Location, 1, GL_FALSE, &value[0][0]);
+    }
+    void Set(UniformHandle uniform, const glm::mat4 &value)
+    {
+        if (changed(uniform, &value[0][0], sizeof(value)))
+            glUniformMatrix4fv(Entries[uniform.Index].Location, 1, GL_FALSE, &value[0][0]);
+    }
+
+    // 'count' consecutive elements of an array uniform starting at 'uniform', uploaded with one call
+    // if any of them changed. Elements past the end of the array are left out.
+    void Set(UniformHandle uniform, const int *values, unsigned int count)
+    {
+        if ((count = changedArray(uniform, values, sizeof(int), count)) > 0)
+            glUniform1iv(Entries[uniform.Index].Location, count, values);
+    }
+    void Set(UniformHandle uniform, const glm::ivec4 *values, unsigned int count)
+    {
+        if ((count = changedArray(uniform, values, sizeof(glm::ivec4), count)) > 0)
+            glUniform4iv(Entries[uniform.Index].Location, count, &values[0][0]);
+    }
+    void Set(UniformHandle uniform, const glm::vec4 *values, unsigned int count)
+    {
+        if ((count = changedArray(uniform, values, sizeof(glm::vec4), count)) > 0)
+            glUniform4fv(Entries[uniform.Index].Location, count, &values[0][0]);
+    }
+    void Set(UniformHandle uniform, const glm::mat4 *values, unsigned int count)
+    {
+        if ((count = changedArray(uniform, values, sizeof(glm::mat4), count)) > 0)
+            glUniformMatrix4fv(Entries[uniform.Index].Location, count, GL_FALSE, &values[0][0][0]);
+    }
+
+    // forgets the shadowed value of 'uniform', for code that writes it with raw glUniform* calls
+    void Forget(UniformHandle uniform)
+    {
+        if (uniform.Valid())
+            Entries[uniform.Index].Known = false;
+    }
+
+private:
+    // a name in the hash table, several names can share an entry
+    struct Key {
+        unsigned int Name;       // offset into Names
+        unsigned int Entry;
+    };
+    struct Entry {
+        int Location;
+        int Remaining;           // array elements from this one to the end of the array, 1 for plain uniforms
+        bool Known;              // Value holds what the program currently has
+        unsigned char Value[64]; // large enough for a mat4
+    };
+
+    unsigned int Program;
+    std::vector<Entry> Entries;
+    std::vector<Key> Keys;
+    std::vector<char> Names;
+    std::vector<int> Slots;
+
+    void addEntry(const std::string &name, int location, int remaining)
+    {
+        Entry entry;
+        entry.Location = location;
+        entry.Remaining = remaining;
+        entry.Known = false;
+        Entries.push_back(entry);
+        addKey(name, Entries.size() - 1);
+    }
+
+    void addKey(const std::string &name, unsigned int entry)
+    {
+        Key key;
+        key.Name = Names.size();
+        key.Entry = entry;
+        Names.insert(Names.end(), name.begin(), name.end());
+        Names.push_back('\0');
+        Keys.push_back(key);
+    }
+
+    // table of key indices at least twice the key count, -1 marks a free slot
+    void buildTable()
+    {
+        unsigned int size = 8;
+        while (size < Keys.size() * 2)
+            size *= 2;
+        Slots.assign(size, -1);
+        for (unsigned int i = 0; i < Keys.size(); i++)
+        {
+            unsigned int slot = hash(&Names[Keys[i].Name]) & (size - 1);
+            while (Slots[slot] >= 0)
+                slot = (slot + 1) & (size - 1);
+            Slots[slot] = i;
+        }
+    }
+
+    // FNV-1a
+    static unsigned int hash(const char *name)
+    {
+        unsigned int h = 2166136261u;
+        for (; *name; name++)
+            h = (h ^ (unsigned char)*name) * 16777619u;
+        return h;
+    }
+
+    // checks that Set* was called with the reflected program in use
+    void checkBound() const
+    {
+#ifndef NDEBUG
+        GLint current = 0;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &current);
+        assert((unsigned int)current == Program && "UniformCache::Set with another program bound");
+#endif
+    }
+
+    // compares 'value' against the shadow and stores it, true if the GL call is needed
+    bool changed(UniformHandle uniform, const void *value, size_t size)
+    {
+        if (!uniform.Valid())
+            return false;
+        checkBound();
+        Entry &entry = Entries[uniform.Index];
+        if (entry.Known && std::memcmp(entry.Value, value, size) == 0)
+        {
+            Skipped++;
+            return false;
+        }
+        std::memcpy(entry.Value, value, size);
+        entry.Known = true;
+        return true;
+    }
+
+    // the array version of changed, every element is shadowed in its own entry. Returns how many
+    // elements to upload, 0 if none changed.
+    unsigned int changedArray(UniformHandle uniform, const void *values, size_t size, unsigned int count)
+    {
+        if (!uniform.Valid())
+            return 0;
+        checkBound();
+        count = std::min(count, (unsigned int)Entries[uniform.Index].Remaining);
+        bool any = false;
+        for (unsigned int i = 0; i < count; i++)
+        {
+            Entry &entry = Entries[uniform.Index + i];
+            const unsigned char *value = (const unsigned char*)values + i * size;
+            if (entry.Known && std::memcmp(entry.Value, value, size) == 0)
+                continue;
+            std::memcpy(entry.Value, value, size);
+            entry.Known = true;
+            any = true;
+        }
+        if (!any)
+        {
+            Skipped++;
+            return 0;
+        }
+        return count;
+    }
+};
+#endif
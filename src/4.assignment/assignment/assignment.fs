@@ -1,48 +1,94 @@
 #version 330 core
 out vec4 FragColor;
 
+// MAX_SIZE_CLASSES and MAX_MATERIALS are defined by main.cpp when it builds the shader
+#if MAX_SIZE_CLASSES > 4
+#error sampleLayer picks between at most four texture arrays
+#endif
+#define MAX_POINT_LIGHTS 4
+
 struct Material {
-    sampler2D diffuse;
-    sampler2D specular;    
     float shininess;
 }; 
 
-struct Light {
+// members are ordered so that the std140 layout packs each float behind a vec3
+struct PointLight {
     vec3 position;
-
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-
     float constant;
+    vec3 ambient;
     float linear;
+    vec3 diffuse;
     float quadratic;
+    vec3 specular;
 };
 
 in vec3 FragPos;  
 in vec3 Normal;  
 in vec2 TexCoords;
+flat in uint MaterialIndex;
   
-uniform vec3 viewPos;
+// shared with every other program, written once per frame
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+// the torch is the first point light. The directional and spot light following the
+// point lights in the block are not used here, so they are left out of the declaration.
+layout (std140) uniform LightData {
+    PointLight pointLights[MAX_POINT_LIGHTS];
+};
+
 uniform Material material;
-uniform Light light;
+
+// one texture array per size class, bound once at startup
+uniform sampler2DArray sizeClasses[MAX_SIZE_CLASSES];
+// per material: diffuse size class, diffuse layer, specular size class, specular layer
+uniform ivec4 materialLayers[MAX_MATERIALS];
+
+// samples a layer of one of the texture arrays. The array is picked per fragment, so the
+// gradients are taken outside the branch to keep mipmapping well defined.
+vec3 sampleLayer(int sizeClass, int layer, vec2 dx, vec2 dy)
+{
+    vec3 coords = vec3(TexCoords, float(layer));
+#if MAX_SIZE_CLASSES > 1
+    if (sizeClass == 1)
+        return textureGrad(sizeClasses[1], coords, dx, dy).rgb;
+#endif
+#if MAX_SIZE_CLASSES > 2
+    if (sizeClass == 2)
+        return textureGrad(sizeClasses[2], coords, dx, dy).rgb;
+#endif
+#if MAX_SIZE_CLASSES > 3
+    if (sizeClass == 3)
+        return textureGrad(sizeClasses[3], coords, dx, dy).rgb;
+#endif
+    return textureGrad(sizeClasses[0], coords, dx, dy).rgb;
+}
 
 void main()
 {
+    PointLight light = pointLights[0];
+    vec2 dx = dFdx(TexCoords);
+    vec2 dy = dFdy(TexCoords);
+    ivec4 layers = materialLayers[MaterialIndex];
+    vec3 diffuseColor = sampleLayer(layers.x, layers.y, dx, dy);
+    vec3 specularColor = sampleLayer(layers.z, layers.w, dx, dy);
+
     // ambient
-    vec3 ambient = light.ambient * texture(material.diffuse, TexCoords).rgb;
+    vec3 ambient = light.ambient * diffuseColor;
   	
     // diffuse 
     vec3 norm = normalize(Normal);
     vec3 lightDir = normalize(light.position - FragPos);
     float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = light.diffuse * diff * texture(material.diffuse, TexCoords).rgb;  
+    vec3 diffuse = light.diffuse * diff * diffuseColor;  
     
     // specular
     vec3 viewDir = normalize(viewPos - FragPos);
     vec3 reflectDir = reflect(-lightDir, norm);  
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-    vec3 specular = light.specular * spec * texture(material.specular, TexCoords).rgb;  
+    vec3 specular = light.specular * spec * specularColor;  
  
     float distance = length(light.position - FragPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
@@ -2,20 +2,28 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in mat4 aInstanceModel; // per instance, takes locations 3 to 6
+layout (location = 7) in uint aMaterial;
+layout (location = 8) in mat3 aInstanceNormal; // transpose(inverse(mat3(aInstanceModel))), takes locations 8 to 10
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
+flat out uint MaterialIndex;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// shared with every other program, written once per frame
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
 
 void main()
 {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;  
+    FragPos = vec3(aInstanceModel * vec4(aPos, 1.0));
+    Normal = aInstanceNormal * aNormal;
     TexCoords = aTexCoords;
+    MaterialIndex = aMaterial;
     
     gl_Position = projection * view * vec4(FragPos, 1.0);
 }
@@ -0,0 +1,72 @@
+#ifndef CREATURE_LAYOUT_H
+#define CREATURE_LAYOUT_H
+
+#include <glm/glm.hpp>
+
+// The boxes the creatures of the assignment are built out of, every part relative to the
+// creature's position. Shared by the game and logl_bench, so the benchmark times the creatures
+// the game actually draws.
+
+//Sven, minecraft wolf
+const int SVEN_PARTS = 11;
+const int SVEN_TAIL = 6;
+const glm::vec3 sven_scales[] = {
+	glm::vec3( 0.25f, 0.25f, 0.20f ), // upper bod
+	glm::vec3( 0.20f, 0.20f, 0.40f ), // lower back
+	glm::vec3( 0.08f, 0.3f, 0.08f ), // leg 1 front left
+	glm::vec3( 0.08f, 0.3f, 0.08f ), // leg 2 front right
+	glm::vec3( 0.08f, 0.33f, 0.08f ), // leg 3 back left
+	glm::vec3( 0.08f, 0.33f, 0.08f ), // leg 4 back right
+	glm::vec3( 0.1f, 0.1f, 0.2f ), // tail
+	glm::vec3( 0.08f, 0.08f, 0.03f ), // left ear
+	glm::vec3( 0.08f, 0.08f, 0.03f ), // right ear
+	glm::vec3( 0.22f, 0.22f, 0.15f), // head
+	glm::vec3( 0.22f, 0.22f, 0.01f), //face
+};
+const glm::vec3 sven_positions[] = {
+	glm::vec3( 0.0f, 0.0f, 0.0f), // upper bod
+	glm::vec3( 0.0f, 0.02f, -0.25f), // lower back
+	glm::vec3( -0.05f, -0.3f, 0.0f), // leg 1
+	glm::vec3( 0.05f, -0.3f, 0.0f), // leg 2
+	glm::vec3( -0.05f, -0.3f, -0.3f), // leg 3
+	glm::vec3( 0.05f, -0.3f, -0.3f), // leg 4
+	glm::vec3( 0.0f, 0.05f, -0.45f), // tail
+	glm::vec3( -0.06f, 0.21f, 0.13f), // left ear
+	glm::vec3( 0.06f, 0.21f, 0.13f), // right ear
+	glm::vec3( 0.0f, 0.01f, 0.15f), // head
+	glm::vec3( 0.0f, 0.01f, 0.23f), // face
+};
+
+//WaterSheep
+const int SHEEP_PARTS = 11;
+const glm::vec3 water_sheep_scales[] = {
+	glm::vec3( 0.25f, 0.25f, 0.25f), // head
+	glm::vec3( 0.20f, 0.20f, 0.05f ), // face
+	glm::vec3( 0.4f, 0.4f, 0.7f ), // upper bod
+	glm::vec3( 0.1f, -0.3f, 0.1f ), // leg 1 front left
+	glm::vec3( 0.1f, -0.3f, 0.1f ), // leg 2 front right
+	glm::vec3( 0.1f, -0.3f, 0.1f ), // leg 3 back left
+	glm::vec3( 0.1f, -0.3f, 0.1f ), // leg 4 back right
+	glm::vec3( 0.15f, -0.2f, 0.12f ), // upper leg
+	glm::vec3( 0.15f, -0.2f, 0.12f ), // upper leg
+	glm::vec3( 0.15f, -0.2f, 0.12f ), // upper leg
+	glm::vec3( 0.15f, -0.2f, 0.12f ), // upper leg
+};
+const glm::vec3 water_sheep_positions[] = {
+	glm::vec3( 0.0f, 0.0f, 0.0f), // head
+	glm::vec3( 0.0f, 0.02f, 0.125f ), // face
+	glm::vec3( 0.0f, -0.25f, -0.35f ), // upper bod
+	glm::vec3( -0.08f, -0.25f, -0.15f ), // front leg 1
+	glm::vec3( 0.08f, -0.25f, -0.15f ), // front leg 2
+	glm::vec3( -0.08f, -0.25f, -0.55f ), // hind leg 3
+	glm::vec3( 0.08f, -0.25f, -0.55f ), // hind leg 4
+	glm::vec3( 0.08f, -0.15f, -0.15f ), // front upper leg
+	glm::vec3( -0.08f, -0.15f, -0.15f ), // front upper leg
+	glm::vec3( 0.08f, -0.15f, -0.55f ), // hind upper leg
+	glm::vec3( -0.08f, -0.15f, -0.55f ), // hind upper leg
+};
+//legs swinging together, 3 and 4 are not allowed to move in same direction at the same time, likewise for 5 and 6
+const int sheep_legs_one[] = { 3, 6, 8, 9 };
+const int sheep_legs_two[] = { 4, 5, 7, 10 };
+
+#endif
@@ -0,0 +1,169 @@
+#include "flythrough.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+bool Flythrough::Load(const std::string &path)
+{
+	std::ifstream file(path.c_str());
+	if (!file)
+	{
+		std::cout << "Failed to open flythrough " << path << "\n";
+		return false;
+	}
+	Times.clear();
+	Keys.clear();
+	std::string line;
+	for (int number = 1; std::getline(file, line); number++)
+	{
+		line = line.substr(0, line.find('#'));
+		std::istringstream words(line);
+		std::string word;
+		if (!(words >> word))
+			continue;
+		bool ok = true;
+		if (word == "frames")
+			ok = (bool)(words >> Frames) && Frames > 0;
+		else if (word == "warmup")
+			ok = (bool)(words >> Warmup) && Warmup >= 0;
+		else if (word == "step")
+			ok = (bool)(words >> Step) && Step > 0.0;
+		else if (word == "key")
+		{
+			double time;
+			CameraPose pose;
+			ok = (bool)(words >> time >> pose.Position.x >> pose.Position.y >> pose.Position.z >> pose.Yaw >> pose.Pitch);
+			// keys have to come in order of time
+			ok = ok && (Times.empty() || time > Times.back());
+			if (ok)
+			{
+				Times.push_back(time);
+				Keys.push_back(pose);
+			}
+		}
+		else
+			ok = false;
+		if (!ok)
+		{
+			std::cout << path << ":" << number << ": cannot read '" << line << "'\n";
+			return false;
+		}
+	}
+	if (Keys.empty())
+	{
+		std::cout << path << ": no keys\n";
+		return false;
+	}
+	return true;
+}
+
+// Catmull-Rom between p1 and p2 with their neighbours p0 and p3, t from 0 to 1
+template <typename T>
+static T catmull_rom(const T &p0, const T &p1, const T &p2, const T &p3, float t)
+{
+	float t2 = t * t, t3 = t2 * t;
+	return 0.5f * ((2.0f * p1) + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 + (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+}
+
+CameraPose Flythrough::Pose(double time) const
+{
+	if (time <= Times.front())
+		return Keys.front();
+	if (time >= Times.back())
+		return Keys.back();
+	int next = std::upper_bound(Times.begin(), Times.end(), time) - Times.begin();
+	int last = Keys.size() - 1;
+	int i0 = std::max(next - 2, 0), i1 = next - 1, i2 = next, i3 = std::min(next + 1, last);
+	float t = (float)((time - Times[i1]) / (Times[i2] - Times[i1]));
+	CameraPose pose;
+	pose.Position = catmull_rom(Keys[i0].Position, Keys[i1].Position, Keys[i2].Position, Keys[i3].Position, t);
+	pose.Yaw = catmull_rom(Keys[i0].Yaw, Keys[i1].Yaw, Keys[i2].Yaw, Keys[i3].Yaw, t);
+	pose.Pitch = catmull_rom(Keys[i0].Pitch, Keys[i1].Pitch, Keys[i2].Pitch, Keys[i3].Pitch, t);
+	return pose;
+}
+
+void Flythrough::Apply(int frame, Camera &camera) const
+{
+	CameraPose pose = Pose(frame * Step);
+	camera.Position = pose.Position;
+	camera.SetOrientation(pose.Yaw, pose.Pitch);
+}
+
+void PathRecorder::Add(double time, const Camera &camera)
+{
+	// a script needs its keys strictly in order
+	if (!Times.empty() && time <= Times.back())
+		return;
+	CameraPose pose = { camera.Position, camera.Yaw, camera.Pitch };
+	Times.push_back(time);
+	Poses.push_back(pose);
+}
+
+bool PathRecorder::Write(const std::string &path, double step) const
+{
+	std::ofstream file(path.c_str());
+	if (!file)
+		return false;
+	file << "# recorded camera path, " << Poses.size() << " frames\n";
+	file << "frames " << std::max<size_t>(Poses.size(), 1) << "\nwarmup 0\nstep " << step << "\n";
+	file << std::setprecision(9);
+	for (size_t i = 0; i < Poses.size(); i++)
+		file << "key " << Times[i] << " " << Poses[i].Position.x << " " << Poses[i].Position.y << " " << Poses[i].Position.z
+			<< " " << Poses[i].Yaw << " " << Poses[i].Pitch << "\n";
+	return (bool)file;
+}
+
+void FrameStatistics::Add(double cpu_ms, unsigned int draw_calls, unsigned long long state_changes)
+{
+	CpuMs.push_back(cpu_ms);
+	DrawCalls.push_back(draw_calls);
+	StateChanges.push_back((double)state_changes);
+}
+
+// "name": { "mean": .., "p50": .., "p99": .., "max": .. }
+static void write_distribution(std::ostream &out, const char *name, std::vector<double> values)
+{
+	out << "  \"" << name << "\": { ";
+	if (values.empty())
+	{
+		out << "\"samples\": 0 }";
+		return;
+	}
+	std::sort(values.begin(), values.end());
+	double sum = 0.0;
+	for (size_t i = 0; i < values.size(); i++)
+		sum += values[i];
+	size_t p50 = (size_t)(0.50 * (values.size() - 1) + 0.5);
+	size_t p99 = (size_t)(0.99 * (values.size() - 1) + 0.5);
+	out << "\"samples\": " << values.size() << ", \"mean\": " << sum / values.size() << ", \"p50\": " << values[p50]
+		<< ", \"p99\": " << values[p99] << ", \"max\": " << values.back() << " }";
+}
+
+void FrameStatistics::WriteJson(std::ostream &out, const std::string &script, const std::vector<long long> &gpu_ns) const
+{
+	// the profiler's frames include the warmup, the measured ones are the last
+	std::vector<double> gpu_ms;
+	size_t first = gpu_ns.size() > CpuMs.size() ? gpu_ns.size() - CpuMs.size() : 0;
+	for (size_t i = first; i < gpu_ns.size(); i++)
+		gpu_ms.push_back(gpu_ns[i] * 1e-6);
+
+	std::string escaped;
+	for (size_t i = 0; i < script.size(); i++)
+	{
+		if (script[i] == '"' || script[i] == '\\')
+			escaped += '\\';
+		escaped += script[i];
+	}
+	out << "{\n  \"benchmark\": \"" << escaped << "\",\n  \"frames\": " << CpuMs.size() << ",\n";
+	write_distribution(out, "cpu_frame_ms", CpuMs);
+	out << ",\n";
+	write_distribution(out, "gpu_frame_ms", gpu_ms);
+	out << ",\n";
+	write_distribution(out, "draw_calls", DrawCalls);
+	out << ",\n";
+	write_distribution(out, "state_changes", StateChanges);
+	out << "\n}\n";
+}
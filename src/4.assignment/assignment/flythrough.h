@@ -0,0 +1,81 @@
+#ifndef FLYTHROUGH_H
+#define FLYTHROUGH_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/camera.h>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Scripted camera for the frame benchmark: the camera follows a Catmull-Rom spline through keyed
+// poses, one frame every Step seconds of path time whatever the real frame rate, so two runs render
+// the same frames. A script is text, one setting or key per line, '#' starts a comment:
+//
+//   frames 600              frames measured
+//   warmup 30               frames rendered before measuring
+//   step 0.0166667          seconds of path (and game) time per frame
+//   key 0  0 1 3  -90 0     time, position x y z, yaw, pitch in degrees
+//   key 4  0 1 -8 -90 -10
+//
+// A path recorded while playing (--record-path) is a script with a key for every frame.
+
+struct CameraPose {
+	glm::vec3 Position;
+	float Yaw, Pitch;
+};
+
+class Flythrough
+{
+public:
+	int Frames;
+	int Warmup;
+	double Step;
+
+	Flythrough() : Frames(600), Warmup(30), Step(1.0 / 60.0) { }
+
+	// reads a script, false (with the reason printed) if it has no keys or a line makes no sense
+	bool Load(const std::string &path);
+	// pose at 'time' seconds along the path, the ends are held
+	CameraPose Pose(double time) const;
+	// puts the camera at the pose of the given frame
+	void Apply(int frame, Camera &camera) const;
+
+	int TotalFrames() const
+	{
+		return Warmup + Frames;
+	}
+
+private:
+	std::vector<double> Times;
+	std::vector<CameraPose> Keys;
+};
+
+// Keys a pose every frame of a live session, written out as a flythrough script at the end.
+class PathRecorder
+{
+public:
+	void Add(double time, const Camera &camera);
+	bool Write(const std::string &path, double step) const;
+
+private:
+	std::vector<double> Times;
+	std::vector<CameraPose> Poses;
+};
+
+// What every measured frame of a benchmark cost, printed as JSON at the end.
+class FrameStatistics
+{
+public:
+	void Add(double cpu_ms, unsigned int draw_calls, unsigned long long state_changes);
+	// 'gpu_ns' are the GPU frame times the profiler collected, possibly fewer than frames
+	void WriteJson(std::ostream &out, const std::string &script, const std::vector<long long> &gpu_ns) const;
+
+private:
+	std::vector<double> CpuMs;
+	std::vector<double> DrawCalls;
+	std::vector<double> StateChanges;
+};
+
+#endif
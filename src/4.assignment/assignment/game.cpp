@@ -0,0 +1,370 @@
+#include "game.h"
+
+#include <cmath>
+#include <random>
+
+const float Game::INTERACTION_RADIUS = 1.6f;
+const float Game::KEY_DELAY = 1.0f / 3.0f;
+
+// Rotation around y that turns +z towards 'direction'.
+// Deriving angle between two vectors : https://stackoverflow.com/questions/41984724/calculating-angle-between-two-vectors-in-glsl
+static float facing_towards(const glm::vec3 &direction)
+{
+    float angle = acos(glm::dot(glm::vec3(0, 0, 1), direction));
+    //if cross product found to produce -ve value of y, rotate clockwise
+    if (glm::cross(glm::vec3(0, 0, 1), direction).y < 0)
+        angle = -angle;
+    return angle;
+}
+
+template <typename F>
+void Game::parallelFor(size_t count, const F &f)
+{
+    if (Jobs)
+        Jobs->ParallelFor(0, count, JOB_GRAIN, f);
+    else if (count > 0)
+        f(0, count);
+}
+
+Game::Game() : Epoch(0), Jobs(NULL), MaxRadius(0.0f)
+{
+    spawnLevel();
+}
+
+void Game::Restart()
+{
+    // every entity goes at once, the storage stays for the respawn
+    World.Clear();
+    Triggers.Clear();
+    ProxyOwner.clear();
+    Inside.clear();
+    MaxRadius = 0.0f;
+    // the restart key keeps its delay so holding it down does not restart every frame
+    float restartDelay = State.RestartDelay;
+    State = GameState();
+    State.RestartDelay = restartDelay;
+    spawnLevel();
+    Epoch++;
+}
+
+void Game::spawnLevel()
+{
+    SpawnSven(glm::vec3(2.0f, 0.3f, -1.0f));
+    SpawnSheep(glm::vec3(-2.0f, 0.55f, -0.65f));
+    SpawnTorch(glm::vec3(0.0f, 0.735f, 0.1f));
+    SpawnPortal(glm::vec3(0.0f, 0.0f, -10.0f));
+
+    // the stress scene's creatures, at the heights of the ones above
+    std::vector<Transform> places = Stress.Scatter(Stress.Svens, STRESS_SVENS);
+    for (unsigned int i = 0; i < places.size(); i++)
+        SpawnSven(places[i].Position + glm::vec3(0.0f, 0.3f, 0.0f));
+    places = Stress.Scatter(Stress.WaterSheep, STRESS_WATER_SHEEP);
+    for (unsigned int i = 0; i < places.size(); i++)
+        SpawnSheep(places[i].Position + glm::vec3(0.0f, 0.55f, 0.0f));
+    Triggers.Build();
+}
+
+std::vector<Transform> StressScene::Scatter(int count, StressKind kind) const
+{
+    // mt19937 gives the same numbers everywhere, the standard distributions do not, so the
+    // floats are made from its raw output
+    std::mt19937 random(Seed * 5u + kind);
+    auto uniform = [&](float low, float high)
+    {
+        return low + (high - low) * (float)(random() >> 8) / 16777216.0f;
+    };
+    // the player starts at (0, 1, 3), nothing may stand within reach of a sheep from there
+    const glm::vec3 start(0.0f, 0.0f, 3.0f);
+    const float clearing = 2.0f * Game::INTERACTION_RADIUS;
+
+    std::vector<Transform> places;
+    places.reserve(count);
+    while ((int)places.size() < count)
+    {
+        Transform place = { glm::vec3(uniform(-Extent, Extent), 0.0f, uniform(-Extent, Extent)), uniform(-3.14159265f, 3.14159265f) };
+        if (Extent > clearing && glm::distance(place.Position, start) < clearing)
+            continue;
+        places.push_back(place);
+    }
+    return places;
+}
+
+int Game::addTrigger(Entity entity, const glm::vec3 &position, float radius)
+{
+    int proxy = Triggers.Insert(AABB(position, position), entity.Index);
+    if ((int)ProxyOwner.size() <= proxy)
+        ProxyOwner.resize(proxy + 1);
+    ProxyOwner[proxy] = entity;
+    MaxRadius = glm::max(MaxRadius, radius);
+    return proxy;
+}
+
+//Sven, minecraft wolf, its tail wags all the time
+Entity Game::SpawnSven(const glm::vec3 &position)
+{
+    Transform transform = { position, 0.0f };
+    Body body = { SHAPE_SVEN, -1 };
+    Carryable carryable = { false, true };
+    Swing tail = { 0.0f, 120.0f, true, 0.0f };
+    ProximityTrigger trigger = { INTERACTION_RADIUS, -1, false };
+    PreviousTransform previous = { transform };
+    Entity entity = World.Create(transform, previous, body, carryable, tail, trigger, Wolf());
+    World.Get<ProximityTrigger>(entity).Proxy = addTrigger(entity, position, trigger.Radius);
+    return entity;
+}
+
+//WaterSheep, chases the player while sven is carried, 1.1 units per second
+Entity Game::SpawnSheep(const glm::vec3 &position)
+{
+    Transform transform = { position, 0.0f };
+    Body body = { SHAPE_SHEEP, -1 };
+    Chaser chaser = { 1.1f, false };
+    Swing legs = { 0.0f, 480.0f, false, 0.0f };
+    ProximityTrigger trigger = { INTERACTION_RADIUS, -1, false };
+    PreviousTransform previous = { transform };
+    Entity entity = World.Create(transform, previous, body, chaser, legs, trigger, Sheep());
+    World.Get<ProximityTrigger>(entity).Proxy = addTrigger(entity, position, trigger.Radius);
+    return entity;
+}
+
+//Torch, carries the point light
+Entity Game::SpawnTorch(const glm::vec3 &position)
+{
+    Transform transform = { position, 0.0f };
+    Body body = { SHAPE_TORCH, -1 };
+    Carryable carryable = { false, false };
+    ProximityTrigger trigger = { INTERACTION_RADIUS, -1, false };
+    PreviousTransform previous = { transform };
+    Entity entity = World.Create(transform, previous, body, carryable, trigger, Torch());
+    World.Get<ProximityTrigger>(entity).Proxy = addTrigger(entity, position, trigger.Radius);
+    return entity;
+}
+
+//Win Portal, the portal itself is baked with the static scene, only its trigger is an entity
+Entity Game::SpawnPortal(const glm::vec3 &position)
+{
+    Transform transform = { position, 0.0f };
+    ProximityTrigger trigger = { INTERACTION_RADIUS, -1, false };
+    Entity entity = World.Create(transform, trigger, Portal());
+    World.Get<ProximityTrigger>(entity).Proxy = addTrigger(entity, position, trigger.Radius);
+    return entity;
+}
+
+static void count_down(float &delay, float deltaTime)
+{
+    delay = glm::max(delay - deltaTime, 0.0f);
+}
+
+// Countdown until the button trigger can be pressed again.
+// This prevents accidental burst repeat clicking of the key.
+void Game::UpdateDelays(float deltaTime)
+{
+    count_down(State.RestartDelay, deltaTime);
+    count_down(State.TorchDelay, deltaTime);
+    count_down(State.ShowDelay, deltaTime);
+    count_down(State.PickUpDelay, deltaTime);
+    count_down(State.LightDelay, deltaTime);
+    count_down(State.CameraDelay, deltaTime);
+    count_down(State.AttenuationDelay, deltaTime);
+}
+
+void Game::Update(const glm::vec3 &player, const glm::vec3 &front, float deltaTime)
+{
+    snapshotSystem();
+    carrySystem(player, front);
+    chaseSystem(player, deltaTime);
+    animationSystem(deltaTime);
+    proximitySystem(player);
+    rulesSystem();
+}
+
+// keeps the transforms of the step before for the renderer to interpolate from
+void Game::snapshotSystem()
+{
+    World.EachArray<Transform, PreviousTransform>([&](size_t count, const Entity *entities, Transform *transforms, PreviousTransform *previous)
+    {
+        for (size_t i = 0; i < count; i++)
+            previous[i].Value = transforms[i];
+    });
+}
+
+// carried entities stay in front of the player and face the player's direction
+// Keep object in front of camera : https://stackoverflow.com/questions/46858950/placing-objects-right-in-front-of-camera
+void Game::carrySystem(const glm::vec3 &player, const glm::vec3 &front)
+{
+    World.Each<Transform, Carryable>([&](Entity entity, Transform &transform, Carryable &carryable)
+    {
+        if (!carryable.Carried)
+            return;
+        glm::vec3 position = player + front;
+        if (carryable.KeepHeight)
+            position.y = transform.Position.y;
+        transform.Position = position;
+        transform.Facing = facing_towards(front);
+    });
+}
+
+// Movement of Sheep towards the player : https://stackoverflow.com/questions/2625021/game-enemy-move-towards-player
+// chasers only move while the player carries the wolf and has not won, their legs swing while they move
+void Game::chaseSystem(const glm::vec3 &player, float deltaTime)
+{
+    bool chasing = State.CarryingWolf && !State.Won;
+    World.EachArray<Transform, Chaser, Swing>([&](size_t count, const Entity *entities, Transform *transforms, Chaser *chasers, Swing *legs)
+    {
+        parallelFor(count, [&](size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; i++)
+            {
+                chasers[i].Active = chasing;
+                legs[i].Active = chasing;
+                if (!chasing)
+                    continue;
+                // calculate vector towards the player
+                Transform &transform = transforms[i];
+                glm::vec3 toPlayer(player.x - transform.Position.x, 0.0f, player.z - transform.Position.z);
+                float distance = glm::length(toPlayer);
+                if (distance == 0.0f)
+                    continue;
+                toPlayer /= distance;
+                transform.Facing = facing_towards(toPlayer);
+                //move by direction * speed
+                transform.Position += toPlayer * chasers[i].Speed * deltaTime;
+            }
+        });
+    });
+}
+
+void Game::animationSystem(float deltaTime)
+{
+    World.EachArray<Swing>([&](size_t count, const Entity *entities, Swing *swings)
+    {
+        parallelFor(count, [&](size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; i++)
+            {
+                Swing &swing = swings[i];
+                swing.Previous = swing.Angle;
+                if (!swing.Active)
+                    continue;
+                //if reached max rotation, rotate the other way
+                if (swing.Angle <= -30.0f)
+                    swing.Step = std::fabs(swing.Step);
+                else if (swing.Angle >= 30.0f)
+                    swing.Step = -std::fabs(swing.Step);
+                swing.Angle += swing.Step * deltaTime;
+            }
+        });
+    });
+}
+
+// moves the trigger points along with their entities and finds the ones the player is inside of.
+// The tree is refitted once by the query instead of once per moved point.
+void Game::proximitySystem(const glm::vec3 &player)
+{
+    World.Each<Transform, ProximityTrigger>([&](Entity entity, Transform &transform, ProximityTrigger &trigger)
+    {
+        if (Triggers.Bounds(trigger.Proxy).Min != transform.Position)
+            Triggers.SetBounds(trigger.Proxy, AABB(transform.Position, transform.Position));
+    });
+
+    // only the entities that were inside last frame need their flag cleared
+    for (unsigned int i = 0; i < Inside.size(); i++)
+        if (World.IsAlive(Inside[i]))
+            World.Get<ProximityTrigger>(Inside[i]).Inside = false;
+    Inside.clear();
+
+    Nearby.clear();
+    Triggers.QueryRadius(player, MaxRadius, Nearby);
+    for (unsigned int i = 0; i < Nearby.size(); i++)
+    {
+        Entity entity = ProxyOwner[Nearby[i]];
+        ProximityTrigger &trigger = World.Get<ProximityTrigger>(entity);
+        if (glm::distance(Triggers.Bounds(trigger.Proxy).Min, player) > trigger.Radius)
+            continue;
+        trigger.Inside = true;
+        Inside.push_back(entity);
+    }
+}
+
+// what the triggers the player is in mean for the game
+void Game::rulesSystem()
+{
+    State.WolfInReach = false;
+    State.TorchInReach = false;
+    // the player loses while a sheep is close and wins once the wolf is carried into the portal
+    State.Lost = false;
+    for (unsigned int i = 0; i < Inside.size(); i++)
+    {
+        Entity entity = Inside[i];
+        if (World.Has<Wolf>(entity))
+            State.WolfInReach = true;
+        if (World.Has<Torch>(entity))
+            State.TorchInReach = true;
+        if (World.Has<Sheep>(entity))
+            State.Lost = true;
+        if (World.Has<Portal>(entity) && State.CarryingWolf)
+            State.Won = true;
+    }
+}
+
+// drops what is carried, or picks up the first entity in reach
+template <typename Tag>
+void Game::toggleCarry()
+{
+    Entity carried = { 0xFFFFFFFF, 0 };
+    World.Each<Carryable, Tag>([&](Entity entity, Carryable &carryable, Tag &)
+    {
+        if (carryable.Carried)
+            carried = entity;
+    });
+    if (World.IsAlive(carried))
+    {
+        World.Get<Carryable>(carried).Carried = false;
+        // sven sits facing forward again once put down
+        if (World.Has<Wolf>(carried))
+            World.Get<Transform>(carried).Facing = 0.0f;
+    }
+    else
+    {
+        for (unsigned int i = 0; i < Inside.size(); i++)
+        {
+            if (World.Has<Tag>(Inside[i]) && World.Has<Carryable>(Inside[i]))
+            {
+                carried = Inside[i];
+                World.Get<Carryable>(carried).Carried = true;
+                break;
+            }
+        }
+        if (!World.IsAlive(carried))
+            return;
+    }
+    State.PickUpDelay = KEY_DELAY;
+    State.CarryingWolf = World.Has<Wolf>(carried) ? World.Get<Carryable>(carried).Carried : State.CarryingWolf;
+    State.CarryingTorch = World.Has<Torch>(carried) ? World.Get<Carryable>(carried).Carried : State.CarryingTorch;
+}
+
+void Game::ToggleCarryWolf()
+{
+    if (State.PickUpDelay == 0.0f && (State.WolfInReach || State.CarryingWolf))
+        toggleCarry<Wolf>();
+}
+
+void Game::ToggleCarryTorch()
+{
+    if (State.PickUpDelay == 0.0f && (State.TorchInReach || State.CarryingTorch))
+        toggleCarry<Torch>();
+}
+
+void Game::ToggleTorchLight()
+{
+    if (State.TorchDelay == 0.0f && State.TorchInReach)
+    {
+        State.TorchDelay = KEY_DELAY;
+        State.TorchOn = !State.TorchOn;
+    }
+}
+
+Entity Game::LightTorch() const
+{
+    return World.First<Torch>();
+}
@@ -0,0 +1,186 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/ecs.h>
+#include <learnopengl/bvh.h>
+#include <learnopengl/job_system.h>
+
+#include <vector>
+
+// Game logic of the assignment: the wolf, the water sheep, the torch and the portal are entities,
+// the rules are systems that run over their components. Nothing in here touches OpenGL, the render
+// loop reads the components after Update and draws them.
+// Update is meant to be called with a fixed time step, so the game plays the same at any frame
+// rate; the previous step's transforms and swing angles are kept for the renderer to interpolate.
+
+// components
+// ----------
+// where an entity stands, Facing is the rotation around y in radians
+struct Transform {
+    glm::vec3 Position;
+    float Facing;
+};
+
+// the Transform before the last Update
+struct PreviousTransform {
+    Transform Value;
+};
+
+// what an entity looks like, the renderer keeps a scene graph node per body in Root
+enum BodyShape {
+    SHAPE_SVEN,
+    SHAPE_SHEEP,
+    SHAPE_TORCH
+};
+struct Body {
+    int Shape;
+    int Root;
+};
+
+// can be picked up, then it stays in front of the player
+struct Carryable {
+    bool Carried;
+    bool KeepHeight; // stays at its own height instead of the player's
+};
+
+// runs towards the player at Speed units per second while Active
+struct Chaser {
+    float Speed;
+    bool Active;
+};
+
+// swings back and forth between -30 and 30 degrees, Step degrees per second while Active
+struct Swing {
+    float Angle;
+    float Step;
+    bool Active;
+    float Previous; // Angle before the last Update
+};
+
+// Inside is set while the player is within Radius, Proxy is the entity's point in the trigger BVH
+struct ProximityTrigger {
+    float Radius;
+    int Proxy;
+    bool Inside;
+};
+
+// tags, they mark what role an entity plays in the rules
+struct Wolf {};
+struct Sheep {};
+struct Torch {};
+struct Portal {};
+
+// everything that is not an entity: toggles, key delays and the outcome
+struct GameState {
+    bool Lost, Won;
+    bool TorchOn;
+    bool ShowCoordinates;
+    bool Orthographic;
+    bool BrightMode;
+    int Attenuation; // index into the attenuation tables
+
+    // derived by Update, what the player can interact with right now
+    bool CarryingWolf, CarryingTorch;
+    bool WolfInReach, TorchInReach;
+
+    // seconds until a key may toggle its state again, prevents burst repeats of a held key
+    float TorchDelay, ShowDelay, PickUpDelay, LightDelay, CameraDelay, AttenuationDelay, RestartDelay;
+
+    GameState() : Lost(false), Won(false), TorchOn(true), ShowCoordinates(false), Orthographic(false), BrightMode(false), Attenuation(0),
+        CarryingWolf(false), CarryingTorch(false), WolfInReach(false), TorchInReach(false),
+        TorchDelay(0.0f), ShowDelay(0.0f), PickUpDelay(0.0f), LightDelay(0.0f), CameraDelay(0.0f), AttenuationDelay(0.0f), RestartDelay(0.0f)
+    {
+    }
+};
+
+// Extra Svens, water sheep and props scattered over the field for scaling tests. A generator seeded
+// with Seed places them, so the same settings always build the same scene.
+enum StressKind {
+    STRESS_TREES,
+    STRESS_ANVILS,
+    STRESS_CHESTS,
+    STRESS_SVENS,
+    STRESS_WATER_SHEEP
+};
+struct StressScene {
+    int Trees, Anvils, Chests, Svens, WaterSheep;
+    unsigned int Seed;
+    float Extent; // everything stands within -Extent .. Extent on x and z
+
+    StressScene() : Trees(0), Anvils(0), Chests(0), Svens(0), WaterSheep(0), Seed(1), Extent(19.0f)
+    {
+    }
+
+    // 'count' places on the ground, clear of where the player starts. Every StressKind draws from a
+    // sequence of its own, so changing one count leaves the others where they were.
+    std::vector<Transform> Scatter(int count, StressKind kind) const;
+};
+
+class Game
+{
+public:
+    // within this distance the player can pick things up, gets caught or enters the portal
+    static const float INTERACTION_RADIUS;
+    static const float KEY_DELAY;
+    // entities per job when a system spreads its arrays over the job system
+    static const size_t JOB_GRAIN = 2048;
+
+    EntityWorld World;
+    GameState State;
+    // changes every time the entities are respawned, so the renderer knows to rebuild its nodes
+    unsigned int Epoch;
+    // if set, the per entity systems run in parallel on it
+    JobSystem *Jobs;
+    // spawned along with the level, Restart after changing it
+    StressScene Stress;
+
+    Game();
+
+    // destroys every entity and spawns the level again
+    void Restart();
+
+    Entity SpawnSven(const glm::vec3 &position);
+    Entity SpawnSheep(const glm::vec3 &position);
+    Entity SpawnTorch(const glm::vec3 &position);
+    Entity SpawnPortal(const glm::vec3 &position);
+
+    // counts the key delays down
+    void UpdateDelays(float deltaTime);
+    // advances the game by one step for a player at 'player' looking along 'front'
+    void Update(const glm::vec3 &player, const glm::vec3 &front, float deltaTime);
+
+    // key actions, they respect the key delays and the reach of the player
+    void ToggleCarryWolf();
+    void ToggleCarryTorch();
+    void ToggleTorchLight();
+
+    // the torch whose light the scene uses, an invalid handle if there is none
+    Entity LightTorch() const;
+
+private:
+    BVH Triggers;                  // one point per proximity trigger
+    std::vector<Entity> ProxyOwner; // entity of every trigger proxy
+    std::vector<int> Nearby;
+    std::vector<Entity> Inside;     // entities whose trigger is set
+    float MaxRadius;
+
+    void spawnLevel();
+    int addTrigger(Entity entity, const glm::vec3 &position, float radius);
+
+    // systems, in the order Update runs them
+    void snapshotSystem();
+    void carrySystem(const glm::vec3 &player, const glm::vec3 &front);
+    void chaseSystem(const glm::vec3 &player, float deltaTime);
+    void animationSystem(float deltaTime);
+    void proximitySystem(const glm::vec3 &player);
+    void rulesSystem();
+
+    template <typename Tag>
+    void toggleCarry();
+    // calls f(first, last) over [0, count), split over the job system if there is one
+    template <typename F>
+    void parallelFor(size_t count, const F &f);
+};
+#endif
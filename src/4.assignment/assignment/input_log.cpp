@@ -0,0 +1,91 @@
+#include "input_log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+static const char INPUT_LOG_MAGIC[] = "LOGLINP1";
+
+bool InputRecorder::Open(const std::string &path, unsigned int keyCount)
+{
+	Close();
+	File = std::fopen(path.c_str(), "wb");
+	if (!File)
+		return false;
+	unsigned char keys = (unsigned char)keyCount;
+	std::fwrite(INPUT_LOG_MAGIC, 1, 8, File);
+	std::fwrite(&keys, 1, 1, File);
+	return true;
+}
+
+void InputRecorder::Close()
+{
+	if (File)
+		std::fclose(File);
+	File = NULL;
+	Pending.clear();
+}
+
+void InputRecorder::Mouse(float xOffset, float yOffset)
+{
+	if (File)
+		Pending.push_back(glm::vec2(xOffset, yOffset));
+}
+
+void InputRecorder::Frame(double deltaTime, unsigned int keys)
+{
+	if (!File)
+		return;
+	// a frame holds at most 65535 movements, the rest carry over into the next one
+	unsigned short mask = (unsigned short)keys;
+	unsigned short moves = (unsigned short)std::min(Pending.size(), (size_t)0xFFFF);
+	std::fwrite(&deltaTime, sizeof(deltaTime), 1, File);
+	std::fwrite(&mask, sizeof(mask), 1, File);
+	std::fwrite(&moves, sizeof(moves), 1, File);
+	if (moves > 0)
+		std::fwrite(&Pending[0], sizeof(glm::vec2), moves, File);
+	Pending.erase(Pending.begin(), Pending.begin() + moves);
+}
+
+bool InputReplay::Load(const std::string &path, unsigned int keyCount)
+{
+	Inputs.clear();
+	std::FILE *file = std::fopen(path.c_str(), "rb");
+	if (!file)
+	{
+		std::cout << "Failed to open input recording " << path << "\n";
+		return false;
+	}
+	char magic[8];
+	unsigned char keys = 0;
+	bool ok = std::fread(magic, 1, 8, file) == 8 && std::memcmp(magic, INPUT_LOG_MAGIC, 8) == 0 && std::fread(&keys, 1, 1, file) == 1;
+	if (!ok || keys != keyCount)
+	{
+		std::cout << path << ": not an input recording of this version of the game\n";
+		std::fclose(file);
+		return false;
+	}
+	FrameInput input;
+	unsigned short mask, moves;
+	bool truncated = false;
+	while (std::fread(&input.DeltaTime, sizeof(input.DeltaTime), 1, file) == 1)
+	{
+		truncated = std::fread(&mask, sizeof(mask), 1, file) != 1 || std::fread(&moves, sizeof(moves), 1, file) != 1;
+		if (!truncated)
+		{
+			input.Mouse.resize(moves);
+			truncated = moves > 0 && std::fread(&input.Mouse[0], sizeof(glm::vec2), moves, file) != moves;
+		}
+		if (truncated)
+			break;
+		input.Keys = mask;
+		Inputs.push_back(input);
+	}
+	std::fclose(file);
+	// a recording cut off in the middle of a frame still plays up to there
+	if (truncated)
+		std::cout << path << ": truncated after " << Inputs.size() << " frames\n";
+	if (Inputs.empty())
+		std::cout << path << ": no frames recorded\n";
+	return !Inputs.empty();
+}
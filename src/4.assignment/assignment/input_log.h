@@ -0,0 +1,74 @@
+#ifndef INPUT_LOG_H
+#define INPUT_LOG_H
+
+#include <glm/glm.hpp>
+
+#include <cassert>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Recording and replay of everything the player does, so a session plays out again exactly: the
+// frame times, the InputKey mask of every frame and every mouse movement in the order
+// mouse_callback handed it to the camera. Binary, in the machine's byte order:
+//
+//   "LOGLINP1" u8 key count                   file header, the key count is INPUT_KEY_COUNT
+//   f64 delta time, u16 keys, u16 moves       one per frame
+//   f32 x offset, f32 y offset                one per mouse movement since the frame before
+//
+// The delta time is kept as the double the loop computed, a float would make the fixed steps of
+// the replay come out differently.
+
+// the input of one frame
+struct FrameInput {
+	double DeltaTime;
+	unsigned int Keys;
+	std::vector<glm::vec2> Mouse; // offsets for Camera::ProcessMouseMovement, oldest first
+};
+
+class InputRecorder
+{
+public:
+	InputRecorder() : File(NULL) { }
+	~InputRecorder() { Close(); }
+
+	bool Open(const std::string &path, unsigned int keyCount);
+	void Close();
+
+	bool Recording() const
+	{
+		return File != NULL;
+	}
+
+	// a mouse movement, kept for the next frame
+	void Mouse(float xOffset, float yOffset);
+	// writes a frame with the mouse movements since the last one
+	void Frame(double deltaTime, unsigned int keys);
+
+private:
+	std::FILE *File;
+	std::vector<glm::vec2> Pending;
+};
+
+class InputReplay
+{
+public:
+	// reads a whole recording, false (with the reason printed) if it cannot be played back
+	bool Load(const std::string &path, unsigned int keyCount);
+
+	int Frames() const
+	{
+		return (int)Inputs.size();
+	}
+
+	const FrameInput &Frame(int index) const
+	{
+		assert(index >= 0 && index < (int)Inputs.size());
+		return Inputs[index];
+	}
+
+private:
+	std::vector<FrameInput> Inputs;
+};
+
+#endif
@@ -7,11 +7,34 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <learnopengl/filesystem.h>
+#include <learnopengl/gl_state.h>
+#include <learnopengl/ring_buffer.h>
 #include <learnopengl/shader_m.h>
 #include <learnopengl/camera.h>
-
+#include <learnopengl/instance_batch.h>
+#include <learnopengl/static_batch.h>
+#include <learnopengl/texture_array.h>
+#include <learnopengl/uniform_buffer.h>
+#include <learnopengl/render_queue.h>
+#include <learnopengl/bvh.h>
+#include <learnopengl/scene_graph.h>
+#include <learnopengl/matrix_kernels.h>
+#include <learnopengl/job_system.h>
+#include <learnopengl/logger.h>
+#include <learnopengl/profiler.h>
+#include <learnopengl/render_context.h>
+
+#include "flythrough.h"
+#include "creature_layout.h"
+#include "input_log.h"
+#include "simulation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #define PI 3.14159265
 
@@ -80,77 +103,87 @@ float box[] = {
 	-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f
 };
 
+// Every box part is drawn with one of these diffuse/specular texture pairs.
+// The index is stored per instance and the shader looks the pair up itself.
+enum BoxMaterial {
+	MAT_GRASS,
+	MAT_OBSIDIAN,
+	MAT_NETHER_PORTAL,
+	MAT_METAL,
+	MAT_CHEST,
+	MAT_WOOD,
+	MAT_TREE_LEAVES,
+	MAT_SVEN_BODY,
+	MAT_SVEN_FACE,
+	MAT_WATER_SHEEP_BODY,
+	MAT_WATER_SHEEP_FACE,
+	MAT_RED,
+	MAT_GREEN,
+	MAT_BLUE,
+	MAT_COUNT
+};
+
+// sizes of the texture arrays in assignment.fs, handed to it as #defines when it is built
+const int MAX_SIZE_CLASSES = 4;
+const int MAX_MATERIALS = 32;
+static_assert(MAT_COUNT <= MAX_MATERIALS, "materialLayers in assignment.fs has no room for every BoxMaterial");
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
-void process_input(GLFWwindow *window);
-unsigned int loadTexture(char const * path);
+unsigned int read_input(GLFWwindow *window);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
-void jump();
-void restart_button();
+void bake_static_scene(StaticBatch &static_scene);
+
+// the props that never move, an anvil, a chest or a tree
+enum PropShape {
+	PROP_ANVIL,
+	PROP_CHEST,
+	PROP_TREE
+};
+// one box of a prop, placed where the prop's layout puts it
+struct PropPart {
+	BoxMaterial Material;
+	glm::mat4 Model;
+
+	PropPart(BoxMaterial material, const glm::mat4 &model) : Material(material), Model(model) {}
+};
+std::vector<PropPart> prop_parts(PropShape shape);
+
+// the props of a stress scene, too many to bake: their parts are drawn as box instances and culled
+// per prop. The parts of prop i are First[i] .. First[i + 1] - 1, the proxies of Culling are props.
+struct PropField {
+	std::vector<unsigned int> First;
+	std::vector<BoxMaterial> Materials;
+	std::vector<glm::mat4> Models;
+	std::vector<AABB> Bounds;
+	BVH Culling;
+};
+void scatter_props(const StressScene &stress, PropField &field);
 
 // settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 800;
 
-// camera
-Camera camera(glm::vec3(0.0f, 1.0f, 3.0f));
-
+// mouse
 bool firstMouse = true;
 float lastX = (float)SCR_WIDTH/2, lastY = (float)SCR_HEIGHT/2;
-
-// game variables
-bool LOSE_CONDITION = false;
-bool WIN_CONDITION = false;
-
-// lighting
-float torchAngle = 0.0f;
-glm::vec3 light_object_pos(0.0f, 0.0f, 0.0f);
-glm::vec3 light_pos(0.0f, 0.735f, 0.1f);
-
-// remembering where we left sven
-glm::vec3 sven_glob_pos(2.0f, 0.3f, -1.0f);
-glm::vec3 sven_curr_pos(0.0f, 0.0f, 0.0f);
-float tailAngle = 0.0f;
-float moveTail = 2.0f;
-float svenAngle = 0.0f;
-
-// watersheep global position
-glm::vec3 sheep_glob_pos(-2.0f, 0.55f, -0.65f);
-glm::vec3 sheep_curr_pos(0, 0, 0);
+unsigned int mouse_epoch = 0; // game.Epoch the cursor was last seen in, a restart starts it over
+// --record-input, sees every mouse movement the camera gets
+InputRecorder input_recorder;
 
 // timing
-float delta_time = 0.0f;	// time between current frame and last frame
-float last_frame = 0.0f;
-
-//Toggle (Animation or states)
-bool TORCH_PRESSED = true;
-int TORCH_DELAY = 0;
-bool TORCH_CLOSE_ENOUGH = false;
-
-bool SHOW_COORDINATE = false;
-int SHOW_DELAY = 0;
+double delta_time = 0.0;	// time between current frame and last frame
+double last_frame = 0.0;
 
-bool PICK_UP_TORCH = false;
-bool PICK_UP_SVEN = false;
-int PICK_UP_DELAY = 0;
-bool SVEN_CLOSE = false;
-bool TORCH_CLOSE = false;
+// longest frame the simulation catches up with, after a stall it slows down instead of spiraling
+const double MAX_FRAME_TIME = 0.25;
 
-bool PROJECTION = false;
-int CAMERA_DELAY = 0;
-
-bool LIGHT_MODE = false;
-int LIGHT_DELAY = 0;
-
-//WATER SHEEP MOVEMENT VARIABLES
-float water_sheep_speed = 1.0f;
-float angle = 0.0f;
-float legAngleOne = 0.0f;
-float moveLegOne = 2.0f;
-float legAngleTwo = 0.0f;
-float moveLegTwo = -2.0f;
+// GLFW key of every InputKey, they are read once per frame and applied on every simulation step of the frame
+const int input_glfw_keys[INPUT_KEY_COUNT] = {
+	GLFW_KEY_W, GLFW_KEY_S, GLFW_KEY_A, GLFW_KEY_D, GLFW_KEY_SPACE, GLFW_KEY_LEFT_SHIFT,
+	GLFW_KEY_L, GLFW_KEY_K, GLFW_KEY_T, GLFW_KEY_R, GLFW_KEY_C, GLFW_KEY_E, GLFW_KEY_F, GLFW_KEY_O, GLFW_KEY_P,
+};
 
 //attenuation
-int attIndex = 0;
 float linear[] = {
     0.7, 0.35, 0.22, 0.14, 0.09, 0.07, 0.027, 0.022, 0.014, 0.007, 0.0014
 };
@@ -160,110 +193,237 @@ float quad[] = {
     0.0002, 0.000007
 };
 
-int ATTENUATION_DELAY = 0;
+// static world layout, baked once at startup
+//Win Portal
+glm::vec3 portal_scales[] = {
+	glm::vec3( 1.0f,  0.25f,  0.5f),   //top arch
+	glm::vec3( 1.0f,  0.25f,  0.5f),	//bottom arch
+	glm::vec3( 0.5f,  2.0f ,  0.5f),	//left pillar
+	glm::vec3( 0.5f,  2.0f ,  0.5f),	//rightpillar
+	glm::vec3( 1.0f,  1.8f ,  0.01f),	//portal
+};
+glm::vec3 portal_positions[] = {
+	glm::vec3( 0.0f  ,  1.75f ,  -10.0f),  //top arch
+	glm::vec3( 0.0f  ,  0.0f ,  -10.0f),   //bottom arch
+	glm::vec3(-0.75f ,  0.0f ,  -10.0f),	//left pillar
+	glm::vec3( 0.75f ,  0.0f ,  -10.0f),	//right pillar
+	glm::vec3( 0.0f  ,  0.0f ,  -10.0f),	//portal
+};
+
+//Anvil
+glm::vec3 anvil_scales[] = {
+	glm::vec3( 0.5f,  0.2f,  0.3f),	//top
+	glm::vec3( 0.20f,  0.2f,  0.15f), //body
+	glm::vec3( 0.35f,  0.025f, 0.35f),	//waist
+	glm::vec3( 0.45f,  0.11f,  0.45f), //base
+};
+glm::vec3 anvil_positions[] = {
+	glm::vec3( 0.0f, 0.335f,  0.0f),		//top
+	glm::vec3( 0.0f, 0.135f, 0.0f),	//body
+	glm::vec3( 0.0f, 0.11f,  0.0f),	//waist
+	glm::vec3( 0.0f, 0.0f,  0.0f),	//base
+};
 
-//RESTART GAME
-bool RESTART_PRESSED = false;
-int RESTART_DELAY = 0;
+//Chest, 2 boxes for main body, 1 for lock
+glm::vec3 chest_scales[] = {
+	glm::vec3( 0.5f,  0.125f,  0.5f),   //top half of chest
+	glm::vec3( 0.5f,  0.375f,  0.5f),	//bottom half of chest
+	glm::vec3( 0.1f,  0.05f,  0.15f),	//lock 
+};
+glm::vec3 chest_positions[] = {
+	glm::vec3( 2.0f, 0.375f,  2.0f),	//top half of chest
+	glm::vec3( 2.0f, 0.0f,  2.0f),	    //bottom half of chest
+	glm::vec3( 2.0f, 0.45f,  1.72f),	//lock
+};
 
-// Countdown until the button trigger can be pressed again.
-// This prevents accidental burst repeat clicking of the key.
-void update_delay()
-{
-    if(RESTART_DELAY > 0) RESTART_DELAY -= 1;
-    if(TORCH_DELAY > 0) TORCH_DELAY -= 1;
-    if(SHOW_DELAY > 0) SHOW_DELAY -= 1;
-    if(PICK_UP_DELAY > 0) PICK_UP_DELAY -= 1;
-    if(LIGHT_DELAY > 0) LIGHT_DELAY -= 1;
-    if(CAMERA_DELAY > 0) CAMERA_DELAY -= 1;
-    if(ATTENUATION_DELAY > 0) ATTENUATION_DELAY -= 1;
-}
+//Tree
+glm::vec3 tree_scales[] = {
+	glm::vec3( 0.4f,  2.0f,  0.4f),	//trunk
+	glm::vec3( 0.75f,  1.0f,  0.75f),	//top foliage
+	glm::vec3( 1.0f,  1.0f,  1.0f), //bottom foliage
+};
+glm::vec3 tree_positions[] = {
+	glm::vec3( 0.0f, 0.0f,  -1.0f),	//trunk
+	glm::vec3( 0.0f, 1.5f,  -1.0f),	//top foliage
+	glm::vec3( 0.0f, 1.0f,  -1.0f),	//bottom foliage
+};
 
-// Toggle torch light pressing only if the camera is close enough.
-void toggle_torch_light_distance(glm::vec3 button_pos)
-{
-	if(glm::length(camera.Position - light_pos) <= 1.6f)
-		TORCH_CLOSE_ENOUGH = true;
-	else
-		TORCH_CLOSE_ENOUGH = false;
-}
+// the layouts of Sven and the water sheep are in creature_layout.h
 
-// Toggle button pressing only if the camera is close enough.
-void toggle_torch_distance(glm::vec3 torch_pos)
-{
-	if(glm::length(camera.Position - torch_pos) <= 1.6f)
-		TORCH_CLOSE = true;
-	else
-		TORCH_CLOSE = false;
-}
+//Torch
+const int TORCH_PARTS = 2;
+glm::vec3 torch_scales[] = {
+	glm::vec3( 0.05f, 0.2f, 0.05f ), // handle
+	glm::vec3( 0.05f, 0.05f, 0.05f), // top
+};
+glm::vec3 torch_positions[] = {
+	glm::vec3( 0.0f, -0.2f, 0.0f ), // handle
+	glm::vec3( 0.0f, 0.0f, 0.0f ), // top
+};
+
+// part layout of every body shape, indexed by BodyShape
+struct BodyLayout {
+	int Parts;
+	const glm::vec3 *Positions;
+	const glm::vec3 *Scales;
+};
+const BodyLayout body_layouts[] = {
+	{ SVEN_PARTS, sven_positions, sven_scales },               // SHAPE_SVEN
+	{ SHEEP_PARTS, water_sheep_positions, water_sheep_scales }, // SHAPE_SHEEP
+	{ TORCH_PARTS, torch_positions, torch_scales },            // SHAPE_TORCH
+};
+
+// per frame data (instances, uniform blocks) is streamed through a triple buffered ring, a frame
+// gets FRAME_RING_BASE plus room for every part of the stress scene, up to FRAME_RING_LIMIT
+const size_t FRAME_RING_BASE = 4 * 1024 * 1024;
+const size_t FRAME_RING_LIMIT = 128 * 1024 * 1024;
 
-// Toggle button pressing only if the camera is close enough.
-void toggle_sven_distance(glm::vec3 sven_pos)
+// ring space the instances of a stress scene take when all of it is in view
+size_t stress_instance_bytes(const StressScene &stress)
 {
-	if(glm::length(camera.Position - sven_pos) <= 1.6f)
-		SVEN_CLOSE = true;
-	else
-		SVEN_CLOSE = false;
+	size_t parts = (size_t)stress.Trees * 3 + (size_t)stress.Anvils * 4 + (size_t)stress.Chests * 3
+		+ (size_t)stress.Svens * SVEN_PARTS + (size_t)stress.WaterSheep * SHEEP_PARTS;
+	return parts * sizeof(InstanceData);
 }
 
-void check_lose_condition(glm::vec3 sheep_position)
+// the baked objects, indexed by BVH for culling, every proxy carries its index in the static scene
+BVH scene_bvh;
+
+// blends two rotations around y the short way round
+float interpolate_angle(float from, float to, float t)
 {
-	if(glm::length(camera.Position - sheep_position) <= 1.6f)
-		LOSE_CONDITION = true;
-	else
-		LOSE_CONDITION = false;
+	float difference = to - from;
+	while(difference > PI) difference -= 2.0f * PI;
+	while(difference < -PI) difference += 2.0f * PI;
+	return from + difference * t;
 }
 
-void check_win_condition(glm::vec3 portal_position)
+// Transform of a box part relative to its creature: moved to 'position', swung by 'angle' degrees
+// around x (legs and tails), scaled, and lifted so the box stands on its origin.
+glm::mat4 part_transform(glm::vec3 position, glm::vec3 scale, float angle)
 {
-	if(glm::length(camera.Position - portal_position) <= 1.6f)
-		WIN_CONDITION = true;
+	glm::quat swing = glm::angleAxis(glm::radians(angle), glm::vec3(1,0,0));
+	return ComposeTRS(position + swing * glm::vec3(0.0f, 0.5f * scale.y, 0.0f), swing, scale);
 }
 
-int main()
+int main(int argc, char **argv)
 {
-	// glfw: initialize and configure
-	// ------------------------------
-	glfwInit();
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-#ifdef __APPLE__
-//	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // uncomment this statement for OS X
-#endif
-
-	// glfw window creation
-	// --------------------
-	GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "OpenGL Tutorial", NULL, NULL);
-	if (window == NULL)
+	// --headless runs the game logic alone, without a window or OpenGL, for --ticks steps.
+	// --profile trace.json times the frames on the CPU and the GPU and writes a Chrome trace.
+	// --log-level trace|debug|info|warning|error filters the log, --telemetry positions.bin records
+	// the player, the sheep and the torch every frame.
+	// --benchmark path.txt flies the camera along a scripted path with the input off and prints the
+	// frame statistics as JSON (to --benchmark-output results.json if given), --record-path path.txt
+	// writes the camera path of a session as such a script.
+	// --record-input session.bin records the keys, the mouse and the frame times, --replay-input
+	// session.bin plays them back instead of reading the keyboard and the mouse.
+	// --stress N adds N trees, anvils, chests, Svens and water sheep, scattered by --stress-seed S
+	// within --stress-extent E of the centre.
+	// -----------------------------------------------------------------------------------
+	bool headless = false;
+	unsigned long long ticks = 1000000;
+	std::string profile_path;
+	std::string telemetry_path;
+	std::string benchmark_path;
+	std::string benchmark_output;
+	std::string record_path;
+	std::string record_input_path;
+	std::string replay_input_path;
+	for (int i = 1; i < argc; i++)
 	{
-		std::cout << "Failed to create GLFW window" << std::endl;
-		glfwTerminate();
+		std::string arg = argv[i];
+		if (arg == "--headless")
+			headless = true;
+		else if (arg == "--ticks" && i + 1 < argc)
+			ticks = std::stoull(argv[++i]);
+		else if (arg == "--profile" && i + 1 < argc)
+			profile_path = argv[++i];
+		else if (arg == "--telemetry" && i + 1 < argc)
+			telemetry_path = argv[++i];
+		else if (arg == "--benchmark" && i + 1 < argc)
+			benchmark_path = argv[++i];
+		else if (arg == "--benchmark-output" && i + 1 < argc)
+			benchmark_output = argv[++i];
+		else if (arg == "--record-path" && i + 1 < argc)
+			record_path = argv[++i];
+		else if (arg == "--record-input" && i + 1 < argc)
+			record_input_path = argv[++i];
+		else if (arg == "--replay-input" && i + 1 < argc)
+			replay_input_path = argv[++i];
+		else if (arg == "--stress" && i + 1 < argc)
+		{
+			int count = std::stoi(argv[++i]);
+			game.Stress.Trees = game.Stress.Anvils = game.Stress.Chests = game.Stress.Svens = game.Stress.WaterSheep = count;
+		}
+		else if (arg == "--stress-seed" && i + 1 < argc)
+			game.Stress.Seed = std::stoul(argv[++i]);
+		else if (arg == "--stress-extent" && i + 1 < argc)
+			game.Stress.Extent = std::stof(argv[++i]);
+		else if (arg == "--log-level" && i + 1 < argc && !Logger::ParseLevel(argv[++i], Logger::Get().Level))
+			std::cout << "Unknown log level " << argv[i] << "\n";
+	}
+	// the whole stress scene can be in view at once, a frame that does not fit in the ring would
+	// lose every box instance it has
+	if (FRAME_RING_BASE + stress_instance_bytes(game.Stress) > FRAME_RING_LIMIT)
+	{
+		StressScene one;
+		one.Trees = one.Anvils = one.Chests = one.Svens = one.WaterSheep = 1;
+		std::cout << "--stress takes at most " << (FRAME_RING_LIMIT - FRAME_RING_BASE) / stress_instance_bytes(one)
+			<< " of each, more does not fit in the " << FRAME_RING_LIMIT / (1024 * 1024) << " MB frame ring\n";
 		return -1;
 	}
-	glfwMakeContextCurrent(window);
-	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    glfwSetCursorPosCallback(window, mouse_callback);
-
-    // capture mouse movement
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	if (!telemetry_path.empty() && !Logger::Get().OpenTelemetry(telemetry_path.c_str()))
+		std::cout << "Failed to open telemetry file " << telemetry_path << "\n";
+	// the level was spawned before the flags were read
+	if (game.Stress.Svens > 0 || game.Stress.WaterSheep > 0)
+		game.Restart();
+	if (headless)
+		return run_headless(ticks);
+	bool benchmarking = !benchmark_path.empty();
+	Flythrough flythrough;
+	if (benchmarking && !flythrough.Load(benchmark_path))
+		return -1;
+	bool replaying = !replay_input_path.empty();
+	InputReplay input_replay;
+	if (replaying && !input_replay.Load(replay_input_path, INPUT_KEY_COUNT))
+		return -1;
+	if (!record_input_path.empty() && !input_recorder.Open(record_input_path, INPUT_KEY_COUNT))
+		std::cout << "Failed to open input recording " << record_input_path << "\n";
 
-	// glad: load all OpenGL function pointers
-	// ---------------------------------------
-	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
-	{
-		std::cout << "Failed to initialize GLAD" << std::endl;
+	// window, or an offscreen context with --offscreen egl|osmesa --frames N --dump frame.png
+	// ---------------------------------------------------------------------------------------
+	RenderContext context(argc, argv);
+	if (!context.Create(SCR_WIDTH, SCR_HEIGHT, "OpenGL Tutorial"))
 		return -1;
+	GLFWwindow* window = context.Window;
+	// a benchmark ends by itself once the script is through
+	if (benchmarking)
+		context.MaxFrames = flythrough.TotalFrames();
+	// and a replay once the recording is through, even in the middle of a benchmark
+	if (replaying && (context.MaxFrames == 0 || context.MaxFrames > input_replay.Frames()))
+		context.MaxFrames = input_replay.Frames();
+	if (window)
+	{
+		glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+		if (!benchmarking && !replaying)
+			glfwSetCursorPosCallback(window, mouse_callback);
+
+		// capture mouse movement
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 	}
+	// the benchmark takes its GPU frame times from the profiler
+	if (!profile_path.empty() || benchmarking)
+		Profiler::Get().Enable(true);
 
-	// configure global opengl state
-	// -----------------------------
-	glEnable(GL_DEPTH_TEST);
+	// configure global opengl state, everything the render loop touches goes through the state cache
+	// -----------------------------------------------------------------------------------------------
+	GLState &gl_state = GLState::Get();
+	gl_state.Enable(GL_DEPTH_TEST);
 
 	// build and compile our shader zprogram
 	// ------------------------------------
-	Shader lighting_shader("./assignment.vs", "./assignment.fs");
+	Shader lighting_shader("./assignment.vs", "./assignment.fs",
+		"#define MAX_SIZE_CLASSES " + std::to_string(MAX_SIZE_CLASSES) + "\n#define MAX_MATERIALS " + std::to_string(MAX_MATERIALS) + "\n");
 	Shader lamp_shader("./lamp.vs", "./lamp.fs");
 
 	// set up vertex data (and buffer(s)) and configure vertex attributes
@@ -274,7 +434,7 @@ int main()
 	glGenVertexArrays(1, &VAO_box);
 	glGenBuffers(1, &VBO_box);
 
-	glBindVertexArray(VAO_box);
+	gl_state.BindVertexArray(VAO_box);
 
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_box);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(box), box, GL_STATIC_DRAW);
@@ -288,12 +448,16 @@ int main()
 	//texture coordinates
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
 	glEnableVertexAttribArray(2);
+	//per frame data, checked against FRAME_RING_LIMIT when the flags were read
+	RingBuffer frame_ring(FRAME_RING_BASE + stress_instance_bytes(game.Stress));
+	//per instance model matrix and material index
+	InstanceBatch box_instances(VAO_box, frame_ring, MAT_COUNT);
 
 
 	// second, configure the light's VAO (VBO stays the same; the vertices are the same for the light object which is also a 3D cube)
 	unsigned int VAO_light;
 	glGenVertexArrays(1, &VAO_light);
-	glBindVertexArray(VAO_light);
+	gl_state.BindVertexArray(VAO_light);
 
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_box);
 	// note that we update the lamp's position attribute's stride to reflect the updated buffer data
@@ -301,8 +465,9 @@ int main()
 	glEnableVertexAttribArray(0);
 
 
-	// load and create a texture 
-	// -------------------------
+	// load the textures into texture arrays, one per size class
+	// ---------------------------------------------------------
+	TextureArrays texture_arrays;
 	unsigned int tex_wood_diffuse, tex_grass_diffuse, tex_tree_leaves_diffuse, tex_minecraft_chest_diffuse, tex_metal_diffuse, tex_obsidian_diffuse, tex_nether_portal_diffuse;
 	unsigned int tex_wood_specular, tex_grass_specular, tex_tree_leaves_specular, tex_metal_specular, tex_nether_portal_specular;
 
@@ -312,130 +477,381 @@ int main()
     unsigned int tex_water_sheep_diffuse;
     unsigned int tex_white;
     unsigned int tex_sven_specular, tex_sven_diffuse;
-	tex_wood_diffuse = loadTexture(FileSystem::getPath("resources/textures/wood2.jpg").c_str());
-	tex_wood_specular = loadTexture(FileSystem::getPath("resources/textures/wood2_specular.jpg").c_str());
-	tex_grass_diffuse = loadTexture(FileSystem::getPath("resources/textures/grass.jpg").c_str());
-	tex_grass_specular = loadTexture(FileSystem::getPath("resources/textures/grass_specular.jpg").c_str());
-	tex_tree_leaves_specular = loadTexture(FileSystem::getPath("resources/textures/tree_leaves_specular.png").c_str());
-	tex_tree_leaves_diffuse = loadTexture(FileSystem::getPath("resources/textures/tree_leaves.jpg").c_str());
-	tex_minecraft_chest_diffuse = loadTexture(FileSystem::getPath("resources/textures/minecraft_chest.png").c_str());
-	tex_metal_specular = loadTexture(FileSystem::getPath("resources/textures/metal_specular.jpg").c_str());
-	tex_metal_diffuse = loadTexture(FileSystem::getPath("resources/textures/metal.png").c_str());
-	tex_obsidian_diffuse = loadTexture(FileSystem::getPath("resources/textures/obsidian.png").c_str());
-	tex_nether_portal_specular = loadTexture(FileSystem::getPath("resources/textures/nether_portal_specular.png").c_str());
-	tex_nether_portal_diffuse = loadTexture(FileSystem::getPath("resources/textures/nether_portal.jpg").c_str());
-
-	tex_red_dark_diffuse = loadTexture(FileSystem::getPath("resources/textures/red_dark.jpg").c_str());
-	tex_red_dark_specular = loadTexture(FileSystem::getPath("resources/textures/red_dark_specular.jpg").c_str());
-	tex_red_diffuse = loadTexture(FileSystem::getPath("resources/textures/red.jpg").c_str());
-	tex_red_specular = loadTexture(FileSystem::getPath("resources/textures/red_specular.jpg").c_str());
-	tex_green_diffuse = loadTexture(FileSystem::getPath("resources/textures/green.jpg").c_str());
-	tex_green_specular = loadTexture(FileSystem::getPath("resources/textures/green_specular.jpg").c_str());
-	tex_blue_diffuse = loadTexture(FileSystem::getPath("resources/textures/blue.jpg").c_str());
-	tex_blue_specular = loadTexture(FileSystem::getPath("resources/textures/blue_specular.jpg").c_str());
-
-    tex_water_sheep_diffuse = loadTexture(FileSystem::getPath("resources/textures/water_sheep.png").c_str());
-    tex_white = loadTexture(FileSystem::getPath("resources/textures/white.jpg").c_str());
-    tex_sven_specular = loadTexture(FileSystem::getPath("resources/textures/sven_specular.png").c_str());
-    tex_sven_diffuse = loadTexture(FileSystem::getPath("resources/textures/sven.png").c_str());
+	tex_wood_diffuse = texture_arrays.Add(FileSystem::getPath("resources/textures/wood2.jpg"));
+	tex_wood_specular = texture_arrays.Add(FileSystem::getPath("resources/textures/wood2_specular.jpg"));
+	tex_grass_diffuse = texture_arrays.Add(FileSystem::getPath("resources/textures/grass.jpg"));
+	tex_grass_specular = texture_arrays.Add(FileSystem::getPath("resources/textures/grass_specular.jpg"));
+	tex_tree_leaves_specular = texture_arrays.Add(FileSystem::getPath("resources/textures/tree_leaves_specular.png"));
+	tex_tree_leaves_diffuse = texture_arrays.Add(FileSystem::getPath("resources/textures/tree_leaves.jpg"));
+	tex_minecraft_chest_diffuse = texture_arrays.Add(FileSystem::getPath("resources/textures/minecraft_chest.png"));
+	tex_metal_specular = texture_arrays.Add(FileSystem::getPath("resources/textures/metal_specular.jpg"));
+	tex_metal_diffuse = texture_arrays.Add(FileSystem::getPath("resources/textures/metal.png"));
+	tex_obsidian_diffuse = texture_arrays.Add(FileSystem::getPath("resources/textures/obsidian.png"));
+	tex_nether_portal_specular = texture_arrays.Add(FileSystem::getPath("resources/textures/nether_portal_specular.png"));
+	tex_nether_portal_diffuse = texture_arrays.Add(FileSystem::getPath("resources/textures/nether_portal.jpg"));
+
+	tex_red_dark_diffuse = texture_arrays.Add(FileSystem::getPath("resources/textures/red_dark.jpg"));
+	tex_red_dark_specular = texture_arrays.Add(FileSystem::getPath("resources/textures/red_dark_specular.jpg"));
+	tex_red_diffuse = texture_arrays.Add(FileSystem::getPath("resources/textures/red.jpg"));
+	tex_red_specular = texture_arrays.Add(FileSystem::getPath("resources/textures/red_specular.jpg"));
+	tex_green_diffuse = texture_arrays.Add(FileSystem::getPath("resources/textures/green.jpg"));
+	tex_green_specular = texture_arrays.Add(FileSystem::getPath("resources/textures/green_specular.jpg"));
+	tex_blue_diffuse = texture_arrays.Add(FileSystem::getPath("resources/textures/blue.jpg"));
+	tex_blue_specular = texture_arrays.Add(FileSystem::getPath("resources/textures/blue_specular.jpg"));
+
+    tex_water_sheep_diffuse = texture_arrays.Add(FileSystem::getPath("resources/textures/water_sheep.png"));
+    tex_white = texture_arrays.Add(FileSystem::getPath("resources/textures/white.jpg"));
+    tex_sven_specular = texture_arrays.Add(FileSystem::getPath("resources/textures/sven_specular.png"));
+    tex_sven_diffuse = texture_arrays.Add(FileSystem::getPath("resources/textures/sven.png"));
+	texture_arrays.Build();
+	// every size class needs a sampler in the shader
+	if (texture_arrays.IDs.size() > (size_t)MAX_SIZE_CLASSES)
+	{
+		std::cout << "The textures come in " << texture_arrays.IDs.size() << " sizes, the shader samples at most " << MAX_SIZE_CLASSES << "\n";
+		context.Destroy();
+		return -1;
+	}
+
+	// diffuse and specular texture of every box material, indexed by BoxMaterial
+	unsigned int material_textures[MAT_COUNT][2] = {
+		{ tex_grass_diffuse,           tex_grass_specular },          // MAT_GRASS
+		{ tex_obsidian_diffuse,        tex_grass_specular },          // MAT_OBSIDIAN
+		{ tex_nether_portal_diffuse,   tex_nether_portal_specular },  // MAT_NETHER_PORTAL
+		{ tex_metal_diffuse,           tex_metal_specular },          // MAT_METAL
+		{ tex_minecraft_chest_diffuse, tex_tree_leaves_specular },    // MAT_CHEST
+		{ tex_wood_diffuse,            tex_wood_specular },           // MAT_WOOD
+		{ tex_tree_leaves_diffuse,     tex_tree_leaves_specular },    // MAT_TREE_LEAVES
+		{ tex_white,                   tex_grass_specular },          // MAT_SVEN_BODY
+		{ tex_sven_diffuse,            tex_sven_specular },           // MAT_SVEN_FACE
+		{ tex_red_dark_diffuse,        tex_red_dark_specular },       // MAT_WATER_SHEEP_BODY
+		{ tex_water_sheep_diffuse,     tex_grass_specular },          // MAT_WATER_SHEEP_FACE
+		{ tex_red_diffuse,             tex_red_specular },            // MAT_RED
+		{ tex_green_diffuse,           tex_green_specular },          // MAT_GREEN
+		{ tex_blue_diffuse,            tex_blue_specular },           // MAT_BLUE
+	};
+
+	// where the shader finds the textures of every material: size class and layer of the diffuse and specular map
+	glm::ivec4 material_layers[MAT_COUNT];
+	for(int i = 0; i < MAT_COUNT; i++)
+	{
+		TextureLayer diffuse = texture_arrays.Lookup(material_textures[i][0]);
+		TextureLayer specular = texture_arrays.Lookup(material_textures[i][1]);
+		material_layers[i] = glm::ivec4(diffuse.SizeClass, diffuse.Layer, specular.SizeClass, specular.Layer);
+	}
+
+	// transform everything that never moves into world space once
+	StaticBatch static_scene(MAT_COUNT);
+	bake_static_scene(static_scene);
+
+	// index the baked objects for culling
+	for(unsigned int i = 0; i < static_scene.Objects.size(); i++)
+		scene_bvh.Insert(static_scene.Objects[i].Bounds, i);
+	scene_bvh.Build();
+	std::vector<int> visible_proxies;
+	std::vector<unsigned int> visible_objects;
+
+	// the stress scene's props, if there is one
+	PropField prop_field;
+	scatter_props(game.Stress, prop_field);
+	std::vector<int> visible_props;
+
+	// every body is a part hierarchy below its root node, only the roots and swinging parts change per frame.
+	// The parts of a body are added right after its root, so part 'tab' is node Root + 1 + tab.
+	SceneGraph creatures;
+	// world space bounds of every node, recomputed for all of them in one batch per frame
+	std::vector<AABB> creature_bounds;
+	// the nodes are rebuilt whenever the game respawns its entities
+	unsigned int creatures_epoch = game.Epoch - 1;
+	auto build_creatures = [&]()
+	{
+		creatures.Clear();
+		game.World.Each<Body>([&](Entity entity, Body &body)
+		{
+			const BodyLayout &layout = body_layouts[body.Shape];
+			body.Root = creatures.Add(glm::mat4());
+			for(int tab = 0; tab < layout.Parts; tab++)
+				creatures.Add(part_transform(layout.Positions[tab], layout.Scales[tab], 0.0f), body.Root);
+		});
+		creature_bounds.resize(creatures.Size());
+		creatures_epoch = game.Epoch;
+	};
 
 	//shader configuration -------------------------------------------------------------------------------------------
 	lighting_shader.use();
-	lighting_shader.setInt("material.diffuse", 0);
-	lighting_shader.setInt("material.specular", 1);
-	// pass projection matrix to shader (as projection matrix rarely changes there's no need to do this per frame)
-	// -----------------------------------------------------------------------------------------------------------
+	// size class i is bound to texture unit i
+	int size_class_units[MAX_SIZE_CLASSES];
+	for(int i = 0; i < MAX_SIZE_CLASSES; i++)
+		size_class_units[i] = i;
+	lighting_shader.setIntArray(lighting_shader.uniform("sizeClasses"), size_class_units, texture_arrays.IDs.size());
+	lighting_shader.setIvec4Array(lighting_shader.uniform("materialLayers"), material_layers, MAT_COUNT);
+
+	// uniforms written every frame, looked up once here instead of by name on every call
+	UniformHandle u_material_shininess = lighting_shader.uniform("material.shininess");
+	UniformHandle u_lamp_model = lamp_shader.uniform("model");
+	UniformHandle u_lamp_intensity = lamp_shader.uniform("intensity");
+
+	// camera and light state shared by both programs through uniform blocks, written once per frame
+	UniformBuffer<FrameData> frame_buffer(FRAME_DATA_BINDING, &frame_ring);
+	UniformBuffer<LightData> light_buffer(LIGHT_DATA_BINDING, &frame_ring);
+	FrameData frame_data = FrameData();
+	LightData light_data = LightData();
+
+	// render queue, the loop submits draw packets in scene order and the queue decides the GL order
+	// ---------------------------------------------------------------------------------------------
+	RenderQueue render_queue;
+	// draw calls of the current frame, for the benchmark
+	unsigned int draw_calls = 0;
+	unsigned int lighting_program = render_queue.AddShader([&]() { lighting_shader.use(); });
+	unsigned int lamp_program = render_queue.AddShader([&]() { lamp_shader.use(); });
+	// every texture the scene uses lives in the texture arrays, the lamp samples none
+	unsigned int scene_textures = render_queue.AddTextureSet([&]() { texture_arrays.Bind(0); });
+	unsigned int no_textures = render_queue.AddTextureSet([]() {});
+
+	unsigned int static_mesh = render_queue.AddMesh(static_scene.VAO, [&](const std::vector<const DrawPacket*> &run)
+	{
+		static_scene.DrawIndirect();
+		draw_calls += static_scene.DrawCalls;
+	});
+	unsigned int box_mesh = render_queue.AddMesh(VAO_box, [&](const std::vector<const DrawPacket*> &run)
+	{
+		for(unsigned int i = 0; i < run.size(); i++)
+			box_instances.Add(run[i]->Material, run[i]->Model);
+		box_instances.Draw(GL_TRIANGLES, 36);
+		draw_calls += box_instances.DrawCalls;
+	});
+	unsigned int lamp_mesh = render_queue.AddMesh(VAO_light, [&](const std::vector<const DrawPacket*> &run)
+	{
+		gl_state.BindVertexArray(VAO_light);
+		for(unsigned int i = 0; i < run.size(); i++)
+		{
+			lamp_shader.setMat4(u_lamp_model, run[i]->Model);
+			glDrawArrays(GL_TRIANGLES, 0, 36);
+		}
+		draw_calls += run.size();
+	});
+	// every dynamic box part is an instance of the box mesh
+	// the box mesh spans -0.5 .. 0.5 on every axis, every packet carries its world space bounds for culling
+	const AABB box_bounds(glm::vec3(-0.5f), glm::vec3(0.5f));
+	auto submit_box = [&](unsigned int material, const glm::mat4 &model, const AABB &bounds)
+	{
+		render_queue.Submit(lighting_program, box_mesh, scene_textures, material, model, bounds);
+	};
+	// draws culled so far, reported on exit
+	unsigned long long culled_draws = 0;
 	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 300.0f);
-	lighting_shader.setMat4("projection", projection);
 
 
 
-	// render loop
-	// -----------
-	while (!glfwWindowShouldClose(window))
+	// the work of a frame as a task graph, the window and everything touching OpenGL stay on this thread
+	// ---------------------------------------------------------------------------------------------------
+	JobSystem jobs;
+	game.Jobs = &jobs;
+	glm::mat4 view;
+	Frustum frustum;
+	unsigned int input_keys = 0;
+	double simulation_time = 0.0;	// real time the simulation has not caught up with yet
+	float interpolation = 0.0f;		// how far the frame lies between the last two simulation steps
+	glm::vec3 eye = camera.Position;	// camera position, interpolated between the last two steps
+	unsigned long long simulation_steps = 0;
+	// per-frame positions go to the telemetry file instead of the console
+	unsigned int frame_number = 0;
+	unsigned int player_channel = Logger::Get().Channel("player", 3);
+	unsigned int sheep_channel = Logger::Get().Channel("sheep", 4);
+	unsigned int torch_channel = Logger::Get().Channel("torch", 4);
+	TaskGraph frame_graph;
+	int input_task = frame_graph.Add("input", [&]()
 	{
-		// per-frame time logic
-		// --------------------
-		float currentFrame = glfwGetTime();
-		delta_time = currentFrame - last_frame;
-		last_frame = currentFrame;
-
-		//update delay countdown
-		update_delay();
+		PROFILE_ZONE("input");
+		input_keys = read_input(window);
+		if (replaying)
+		{
+			// the recorded keys, and the mouse through the call mouse_callback made
+			const FrameInput &input = input_replay.Frame(context.Frame);
+			input_keys = input.Keys;
+			for(unsigned int i = 0; i < input.Mouse.size(); i++)
+			{
+				camera.ProcessMouseMovement(input.Mouse[i].x, input.Mouse[i].y);
+				input_recorder.Mouse(input.Mouse[i].x, input.Mouse[i].y);
+			}
+		}
+		input_recorder.Frame(delta_time, input_keys);
+		// the benchmark still lets escape close the window, nothing else
+		if (benchmarking)
+			input_keys = 0;
+	}, TaskGraph::MAIN_THREAD);
+
+	// game logic, as many fixed steps as fit into the time that passed
+	int simulate_task = frame_graph.Add("simulate", [&]()
+	{
+		PROFILE_ZONE("simulate");
+		// the warmup frames hold the first pose of the path
+		int path_frame = std::max((int)context.Frame - flythrough.Warmup, 0);
+		if (benchmarking)
+			flythrough.Apply(path_frame, camera);
+		simulation_time += std::min(delta_time, MAX_FRAME_TIME);
+		while(simulation_time >= SIMULATION_STEP)
+		{
+			simulation_step(input_keys, (float)SIMULATION_STEP);
+			simulation_time -= SIMULATION_STEP;
+			simulation_steps++;
+		}
+		interpolation = (float)(simulation_time / SIMULATION_STEP);
+		if (benchmarking)
+		{
+			// the steps move the camera as the player, put it back on the path
+			flythrough.Apply(path_frame, camera);
+			camera_previous = camera.Position;
+		}
+		eye = glm::mix(camera_previous, camera.Position, interpolation);
+	});
 
-		// input
-		// -----
-		process_input(window);
+	// puts the part hierarchies where the game put the entities
+	int animate_task = frame_graph.Add("animate", [&]()
+	{
+		PROFILE_ZONE("animate");
+		if(creatures_epoch != game.Epoch)
+			build_creatures();
 
-		// render
-		// ------
-		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); 
+        //Sven, water sheep and torch, placed where the game put them, in between the last two steps
+        game.World.Each<Transform, PreviousTransform, Body>([&](Entity entity, Transform &transform, PreviousTransform &previous, Body &body)
+        {
+            glm::vec3 position = glm::mix(previous.Value.Position, transform.Position, interpolation);
+            float facing = interpolate_angle(previous.Value.Facing, transform.Facing, interpolation);
+            creatures.SetLocal(body.Root, ComposeTRS(position, glm::angleAxis(facing, glm::vec3(0,1,0)), glm::vec3(1.0f)));
+        });
 
+        //Sven's tail and the sheep's legs, legs only swing while the sheep is chasing you
+        game.World.Each<Body, Swing>([&](Entity entity, Body &body, Swing &swing)
+        {
+            const BodyLayout &layout = body_layouts[body.Shape];
+            float swing_angle = swing.Active ? glm::mix(swing.Previous, swing.Angle, interpolation) : 0.0f;
+            if(body.Shape == SHAPE_SVEN)
+            {
+                creatures.SetLocal(body.Root + 1 + SVEN_TAIL, part_transform(layout.Positions[SVEN_TAIL], layout.Scales[SVEN_TAIL], swing_angle));
+            }
+            else if(body.Shape == SHAPE_SHEEP)
+            {
+                // the two groups of legs always swing in opposite directions
+                for(int leg = 0; leg < 4; leg++)
+                {
+                    int one = sheep_legs_one[leg], two = sheep_legs_two[leg];
+                    creatures.SetLocal(body.Root + 1 + one, part_transform(layout.Positions[one], layout.Scales[one], swing_angle));
+                    creatures.SetLocal(body.Root + 1 + two, part_transform(layout.Positions[two], layout.Scales[two], -swing_angle));
+                }
+            }
+        });
 
-		// activate shader
-		lighting_shader.use();
+        // bring the world matrices of everything that moved up to date
+        creatures.Update();
+        jobs.ParallelFor(0, creatures.Size(), 4096, [&](size_t first, size_t last)
+        {
+            MatrixKernels::Active().TransformBounds(&creatures.World[first], box_bounds, &creature_bounds[first], last - first);
+        });
+	});
 
-        if(PICK_UP_TORCH == false)
+	// camera matrices and the static objects in view, they only depend on the camera the simulation
+	// left behind, so they run next to the animation
+	int cull_task = frame_graph.Add("cull", [&]()
+	{
+		PROFILE_ZONE("cull");
+		// camera/view transformation
+        //checks if player has set to ortho or perspective views
+        if(game.State.Orthographic == true)
+        {
+            projection = glm::ortho(-2.0f, 2.0f, -2.0f, 2.0f, -100.0f, 100.0f);
+        }       
+        else
         {
-		    lighting_shader.setVec3("light.position", light_pos);
+            projection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 300.0f);
+        }
+		view = glm::lookAt(eye, eye + camera.Front, camera.Up);
+		frustum = Frustum(projection * view);
+
+		//Ground, win portal, anvil, chest and tree never move, they were baked into world space at startup
+		visible_proxies.clear();
+		scene_bvh.QueryFrustum(frustum, visible_proxies);
+		visible_objects.clear();
+		for(unsigned int i = 0; i < visible_proxies.size(); i++)
+			visible_objects.push_back(scene_bvh.UserData(visible_proxies[i]));
+		std::sort(visible_objects.begin(), visible_objects.end());
+
+		//the stress scene's props
+		visible_props.clear();
+		prop_field.Culling.QueryFrustum(frustum, visible_props);
+	});
+
+	// fills the uniform blocks and the render queue and hands everything to OpenGL
+	int draw_task = frame_graph.Add("draw", [&]()
+	{
+		PROFILE_ZONE("draw");
+		PROFILE_GPU_ZONE("draw");
+		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); 
+		frame_ring.BeginFrame();
+
+		// the torch is the first point light, while carried it lights from where the player stands
+		PointLightData &light = light_data.PointLights[0];
+		Entity torch = game.LightTorch();
+		glm::vec3 torch_pos(0.0f);
+		if(game.World.IsAlive(torch))
+			torch_pos = glm::mix(game.World.Get<PreviousTransform>(torch).Value.Position, game.World.Get<Transform>(torch).Position, interpolation);
+        if(game.State.CarryingTorch == false)
+        {
+		    light.Position = torch_pos;
         }
         else
         {
-		    lighting_shader.setVec3("light.position", camera.Position);
-            light_pos = glm::vec3(camera.Position.x, 0.2f, camera.Position.z);
+		    light.Position = eye;
         }
-        lighting_shader.setVec3("viewPos", camera.Position);
 
 		// light properties
-        if(LIGHT_MODE == false)
+        int attIndex = game.State.Attenuation;
+        if(game.State.BrightMode == false)
 	    {
-	        lighting_shader.setVec3("light.ambient", 0.1f, 0.1f, 0.1f);
+	        light.Ambient = glm::vec3(0.1f, 0.1f, 0.1f);
 
-	        lighting_shader.setFloat("light.constant", 1.0f);
-	        lighting_shader.setFloat("light.linear", linear[attIndex]);
-	        lighting_shader.setFloat("light.quadratic", quad[attIndex]);
+	        light.Constant = 1.0f;
+	        light.Linear = linear[attIndex];
+	        light.Quadratic = quad[attIndex];
 	    }
         else
 	    {
-            lighting_shader.setVec3("light.ambient", 1.0f, 1.0f, 1.0f);
+            light.Ambient = glm::vec3(1.0f, 1.0f, 1.0f);
 
-	        lighting_shader.setFloat("light.constant", 1.0f);
-	        lighting_shader.setFloat("light.linear", linear[10]);
-	        lighting_shader.setFloat("light.quadratic", quad[10]);
+	        light.Constant = 1.0f;
+	        light.Linear = linear[10];
+	        light.Quadratic = quad[10];
 	    }
-		if(TORCH_PRESSED == true)
+		if(game.State.TorchOn == true)
 		{
-			lighting_shader.setVec3("light.diffuse", 0.8f, 0.8f, 0.8f);
-			lighting_shader.setVec3("light.specular", 1.0f, 1.0f, 1.0f);
+			light.Diffuse = glm::vec3(0.8f, 0.8f, 0.8f);
+			light.Specular = glm::vec3(1.0f, 1.0f, 1.0f);
 		}
 		else
 		{
-			lighting_shader.setVec3("light.diffuse", 0.0f, 0.0f, 0.0f);
-			lighting_shader.setVec3("light.specular", 0.0f, 0.0f, 0.0f);
+			light.Diffuse = glm::vec3(0.0f, 0.0f, 0.0f);
+			light.Specular = glm::vec3(0.0f, 0.0f, 0.0f);
 		}
+		light_buffer.Update(light_data);
 
-	    std::cout << "linear: " <<  linear[attIndex] << " quadratic: " << quad[attIndex] << "\n";
+	    LOG_EVERY(1.0, LEVEL_DEBUG, CATEGORY_RENDER, "linear: %g quadratic: %g", linear[attIndex], quad[attIndex]);
 
 		// material properties
-        	lighting_shader.setFloat("material.shininess", 65.0f);
+		lighting_shader.use();
+        	lighting_shader.setFloat(u_material_shininess, 65.0f);
 		// for now just set the same for every object. But, you can make it dynamic for various objects.
 
-		// camera/view transformation
+		frame_data.View = view;
+		frame_data.Projection = projection;
+		frame_data.ViewPos = eye;
+		frame_buffer.Update(frame_data);
 
-        //checks if player has set to ortho or perspective views
-        if(PROJECTION == true)
-        {
-            projection = glm::ortho(-2.0f, 2.0f, -2.0f, 2.0f, -100.0f, 100.0f);
-        }       
-        else
-        {
-            projection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 300.0f);
-        }
-		glm::mat4 view = camera.GetViewMatrix(); // uses lookAt function
-        lighting_shader.setMat4("view", view);
-	    lighting_shader.setMat4("projection", projection);
-        camera.jump();
+		lamp_shader.use();
+        //check if player is toggling torch
+		if(game.State.TorchOn == true) lamp_shader.setFloat(u_lamp_intensity, 1.0f);
+		else lamp_shader.setFloat(u_lamp_intensity, 0.3f);
+
+		render_queue.Begin(view, 300.0f, frustum);
 
 		//declare transformation matrix
 		glm::mat4 model = glm::mat4();
@@ -443,7 +859,7 @@ int main()
 		//------------------------------------------------------------------------------------------
 
 		//Coordinate System
-		if(SHOW_COORDINATE == true)
+		if(game.State.ShowCoordinates == true)
 		{			
 			glm::vec3 coord_scales[] = {
 				glm::vec3( 100.0f,  0.02f,  0.02f),	//X
@@ -451,532 +867,170 @@ int main()
 				glm::vec3( 0.02f,  0.02f,  100.0f),	//Z
 			};
 
-			glBindVertexArray(VAO_box);
+			BoxMaterial coord_materials[] = {
+				MAT_RED,	//X
+				MAT_GREEN,	//Y
+				MAT_BLUE,	//Z
+			};
 	
 			for(int tab = 0; tab < 3; tab++)
 			{	
-				if(tab == 0) // X
-				{
-					glActiveTexture(GL_TEXTURE0);
-					glBindTexture(GL_TEXTURE_2D, tex_red_diffuse);
-					glActiveTexture(GL_TEXTURE1);
-					glBindTexture(GL_TEXTURE_2D, tex_red_specular);
-				}
-				if(tab == 1) // Y
-				{
-					glActiveTexture(GL_TEXTURE0);
-					glBindTexture(GL_TEXTURE_2D, tex_green_diffuse);
-					glActiveTexture(GL_TEXTURE1);
-					glBindTexture(GL_TEXTURE_2D, tex_green_specular);
-				}
-				if(tab == 2) // Z
-				{
-					glActiveTexture(GL_TEXTURE0);
-					glBindTexture(GL_TEXTURE_2D, tex_blue_diffuse);
-					glActiveTexture(GL_TEXTURE1);
-					glBindTexture(GL_TEXTURE_2D, tex_blue_specular);
-				}
-
 				model = glm::mat4();
 				model = glm::scale(model, coord_scales[tab]);
 
-				lighting_shader.setMat4("model", model);
-
-				glDrawArrays(GL_TRIANGLES, 0, 36);
+				submit_box(coord_materials[tab], model, box_bounds.Transformed(model));
 			}
 		}
 
-		//Grass
-		glBindVertexArray(VAO_box);
-
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, tex_grass_diffuse);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, tex_grass_specular);
-
-		model = glm::mat4();
-		model = glm::translate(model, glm::vec3(0.0f, -0.01f, 0.0f));
-		model = glm::scale(model, glm::vec3(40.0f, 0.001f, 40.0f));
-
-		lighting_shader.setMat4("model", model);
-
-		glDrawArrays(GL_TRIANGLES, 0, 36);
-
-		//Win Portal
-		glm::vec3 portal_scales[] = {
-			glm::vec3( 1.0f,  0.25f,  0.5f),   //top arch
-			glm::vec3( 1.0f,  0.25f,  0.5f),	//bottom arch
-			glm::vec3( 0.5f,  2.0f ,  0.5f),	//left pillar
-			glm::vec3( 0.5f,  2.0f ,  0.5f),	//rightpillar
-			glm::vec3( 1.0f,  1.8f ,  0.01f),	//portal
-		};
-		glm::vec3 portal_positions[] = {
-			glm::vec3( 0.0f  ,  1.75f ,  -10.0f),  //top arch
-			glm::vec3( 0.0f  ,  0.0f ,  -10.0f),   //bottom arch
-			glm::vec3(-0.75f ,  0.0f ,  -10.0f),	//left pillar
-			glm::vec3( 0.75f ,  0.0f ,  -10.0f),	//right pillar
-			glm::vec3( 0.0f  ,  0.0f ,  -10.0f),	//portal
-		};
-
-		glBindVertexArray(VAO_box);
-
-        //binding obsidian texture
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, tex_obsidian_diffuse);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, tex_grass_specular);
-
-        //check for win conditions, see if player is near portal
-        if(PICK_UP_SVEN)
-            check_win_condition(portal_positions[4]);
-		for(int tab = 0; tab < 5; tab++)
-		{	
-            //if reached portal positions, use nether portal texture instead
-            if(tab == 4)
-            {
-		        glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, tex_nether_portal_diffuse);
-                glActiveTexture(GL_TEXTURE1);
-                glBindTexture(GL_TEXTURE_2D, tex_nether_portal_specular);
-            }
-            //transform matrix
-			model = glm::mat4();
-			model = glm::translate(model, portal_positions[tab]);
-            model = glm::scale(model, portal_scales[tab]);
-			model = glm::translate(model, glm::vec3(0.0f, 0.5f, 0.0f));
-
-			lighting_shader.setMat4("model", model);
-
-			glDrawArrays(GL_TRIANGLES, 0, 36);
+		culled_draws += static_scene.SetVisible(visible_objects);
+		render_queue.Submit(lighting_program, static_mesh, scene_textures, 0, glm::mat4());
+		for(unsigned int i = 0; i < visible_props.size(); i++)
+		{
+			unsigned int prop = prop_field.Culling.UserData(visible_props[i]);
+			for(unsigned int part = prop_field.First[prop]; part < prop_field.First[prop + 1]; part++)
+				submit_box(prop_field.Materials[part], prop_field.Models[part], prop_field.Bounds[part]);
 		}
 
-		//Anvil
-		glm::vec3 anvil_scales[] = {
-			glm::vec3( 0.5f,  0.2f,  0.3f),	//top
-			glm::vec3( 0.20f,  0.2f,  0.15f), //body
-			glm::vec3( 0.35f,  0.025f, 0.35f),	//waist
-			glm::vec3( 0.45f,  0.11f,  0.45f), //base
-		};
-		glm::vec3 anvil_positions[] = {
-			glm::vec3( 0.0f, 0.335f,  0.0f),		//top
-			glm::vec3( 0.0f, 0.135f, 0.0f),	//body
-			glm::vec3( 0.0f, 0.11f,  0.0f),	//waist
-			glm::vec3( 0.0f, 0.0f,  0.0f),	//base
-		};
-
-		glBindVertexArray(VAO_box);
-
-        //bind provided metal texture
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, tex_metal_diffuse);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, tex_metal_specular);
-
-		for(int tab = 0; tab < 4; tab++)
-		{	
-            //transform matrix
-			model = glm::mat4();
-			model = glm::translate(model, anvil_positions[tab]);
-			model = glm::scale(model, anvil_scales[tab]);
-			model = glm::translate(model, glm::vec3(0.0f, 0.5f, 0.0f));
-
-			lighting_shader.setMat4("model", model);
-
-			glDrawArrays(GL_TRIANGLES, 0, 36);
+        if(game.World.IsAlive(torch))
+        {
+            const Transform &torch_transform = game.World.Get<Transform>(torch);
+            float torch_sample[] = { torch_transform.Position.x, torch_transform.Position.y, torch_transform.Position.z, torch_transform.Facing };
+            Logger::Get().Sample(torch_channel, frame_number, torch_sample);
         }
 
-		//Chest, 2 boxes for main body, 1 for lock
-		glm::vec3 chest_scales[] = {
-			glm::vec3( 0.5f,  0.125f,  0.5f),   //top half of chest
-			glm::vec3( 0.5f,  0.375f,  0.5f),	//bottom half of chest
-			glm::vec3( 0.1f,  0.05f,  0.15f),	//lock 
-		};
-		glm::vec3 chest_positions[] = {
-			glm::vec3( 2.0f, 0.375f,  2.0f),	//top half of chest
-			glm::vec3( 2.0f, 0.0f,  2.0f),	    //bottom half of chest
-			glm::vec3( 2.0f, 0.45f,  1.72f),	//lock
-		};
-
-		glBindVertexArray(VAO_box);
-
-        //bind chest textures
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, tex_minecraft_chest_diffuse);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, tex_tree_leaves_specular);
-
-		for(int tab = 0; tab < 3; tab++)
-		{	
-            //transform matrix
-			model = glm::mat4();
-			model = glm::translate(model, chest_positions[tab]);
-            //rotate to half of chest, let it be open a little
-            if(tab == 0)
-                model = glm::rotate(model, glm::radians(15.0f), glm::vec3(1,0,0));
-
-            //move lock to be attached to top half
-            if(tab == 2)
-            {
-                //use metal texture for locks
-	            glActiveTexture(GL_TEXTURE0);
-		        glBindTexture(GL_TEXTURE_2D, tex_metal_diffuse);
-		        glActiveTexture(GL_TEXTURE1);
-		        glBindTexture(GL_TEXTURE_2D, tex_metal_specular);
-                model = glm::rotate(model, glm::radians(105.0f), glm::vec3(1,0,0));
-			    
-            }
-            model = glm::scale(model, chest_scales[tab]);
-			model = glm::translate(model, glm::vec3(0.0f, 0.5f, 0.0f));
-
-			lighting_shader.setMat4("model", model);
-			glDrawArrays(GL_TRIANGLES, 0, 36);
-		}
-
-		//Tree
-		glm::vec3 tree_scales[] = {
-			glm::vec3( 0.4f,  2.0f,  0.4f),	//trunk
-			glm::vec3( 0.75f,  1.0f,  0.75f),	//top foliage
-			glm::vec3( 1.0f,  1.0f,  1.0f), //bottom foliage
-		};
-		glm::vec3 tree_positions[] = {
-			glm::vec3( 0.0f, 0.0f,  -1.0f),	//trunk
-			glm::vec3( 0.0f, 1.5f,  -1.0f),	//top foliage
-			glm::vec3( 0.0f, 1.0f,  -1.0f),	//bottom foliage
-		};
-
-		glBindVertexArray(VAO_box);
-
-        //use wood texture for tree trunk
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, tex_wood_diffuse);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, tex_wood_specular);
-
-		for(int tab = 0; tab < 3; tab++)
-		{	
-            //transform matrix
-			model = glm::mat4();
-			model = glm::translate(model, tree_positions[tab]);
-			model = glm::scale(model, tree_scales[tab]);
-			model = glm::translate(model, glm::vec3(0.0f, 0.5f, 0.0f));
-            
-            //check if moved on from tree trunk, if true use leaf textures
-            if (tab != 0)
+        // submit every part
+        game.World.Each<Body>([&](Entity entity, Body &body)
+        {
+            int first = body.Root + 1;
+            if(body.Shape == SHAPE_SVEN)
             {
-                //bind leaf textures
-		        glActiveTexture(GL_TEXTURE0);
-		        glBindTexture(GL_TEXTURE_2D, tex_tree_leaves_diffuse);
-		        glActiveTexture(GL_TEXTURE1);
-		        glBindTexture(GL_TEXTURE_2D, tex_tree_leaves_specular);
+                //if not the face, use provided white texture, if it is the face, use sven face
+                for(int tab = 0; tab < SVEN_PARTS; tab++)
+                    submit_box(tab == 10 ? MAT_SVEN_FACE : MAT_SVEN_BODY, creatures.World[first + tab], creature_bounds[first + tab]);
             }
-            
-			lighting_shader.setMat4("model", model);
-			glDrawArrays(GL_TRIANGLES, 0, 36);
-		}
-
-        //Sven, minecraft wolf
-        glm::vec3 sven_scales[] = {
-            glm::vec3( 0.25f, 0.25f, 0.20f ), // upper bod
-            glm::vec3( 0.20f, 0.20f, 0.40f ), // lower back
-            glm::vec3( 0.08f, 0.3f, 0.08f ), // leg 1 front left
-            glm::vec3( 0.08f, 0.3f, 0.08f ), // leg 2 front right
-            glm::vec3( 0.08f, 0.33f, 0.08f ), // leg 3 back left
-            glm::vec3( 0.08f, 0.33f, 0.08f ), // leg 4 back right
-            glm::vec3( 0.1f, 0.1f, 0.2f ), // tail
-            glm::vec3( 0.08f, 0.08f, 0.03f ), // left ear
-            glm::vec3( 0.08f, 0.08f, 0.03f ), // right ear
-            glm::vec3( 0.22f, 0.22f, 0.15f), // head
-            glm::vec3( 0.22f, 0.22f, 0.01f), //face
-        };
-
-        glm::vec3 sven_positions[] = {
-            glm::vec3( sven_curr_pos.x, sven_curr_pos.y, sven_curr_pos.z), // upper bod
-            glm::vec3( sven_curr_pos.x, sven_curr_pos.y + 0.02f, sven_curr_pos.z - 0.25f), // lower back
-            glm::vec3( sven_curr_pos.x - 0.05f, sven_curr_pos.y - 0.3f, sven_curr_pos.z), // leg 1
-            glm::vec3( sven_curr_pos.x + 0.05f, sven_curr_pos.y - 0.3f, sven_curr_pos.z), // leg 2
-            glm::vec3( sven_curr_pos.x - 0.05f, sven_curr_pos.y - 0.3f, sven_curr_pos.z - 0.3f), // leg 3
-            glm::vec3( sven_curr_pos.x + 0.05f, sven_curr_pos.y - 0.3f, sven_curr_pos.z - 0.3f), // leg 4
-            glm::vec3( sven_curr_pos.x, sven_curr_pos.y + 0.05f, sven_curr_pos.z - 0.45f), // tail
-            glm::vec3( sven_curr_pos.x - 0.06f, sven_curr_pos.y + 0.21f, sven_curr_pos.z + 0.13f), // left ear
-            glm::vec3( sven_curr_pos.x + 0.06f, sven_curr_pos.y + 0.21f, sven_curr_pos.z + 0.13f), // right ear
-            glm::vec3( sven_curr_pos.x, sven_curr_pos.y + 0.01f, sven_curr_pos.z + 0.15f), // head
-            glm::vec3( sven_curr_pos.x, sven_curr_pos.y + 0.01f, sven_curr_pos.z + 0.23f), // face
-        };
-
-		for(int tab = 0; tab < 11; tab++)
-		{	
-		    glBindVertexArray(VAO_box);
-
-            //if not the face, use provided white texture
-            if (tab != 10)
+            else if(body.Shape == SHAPE_SHEEP)
             {
-		        glActiveTexture(GL_TEXTURE0);
-		        glBindTexture(GL_TEXTURE_2D, tex_white);
-		        glActiveTexture(GL_TEXTURE1);
-		        glBindTexture(GL_TEXTURE_2D, tex_grass_specular);
+                //if this block is the face, use water sheep face texture, if not use dark red texture
+                for(int tab = 0; tab < SHEEP_PARTS; tab++)
+                    submit_box(tab == 1 ? MAT_WATER_SHEEP_FACE : MAT_WATER_SHEEP_BODY, creatures.World[first + tab], creature_bounds[first + tab]);
             }
             else
             {
-                // if it is the face, use sven face
-		        glActiveTexture(GL_TEXTURE0);
-		        glBindTexture(GL_TEXTURE_2D, tex_sven_diffuse);
-		        glActiveTexture(GL_TEXTURE1);
-		        glBindTexture(GL_TEXTURE_2D, tex_sven_specular);
-
+                // torch top is drawn by the lamp shader, otherwise just use handle texture
+                submit_box(MAT_WOOD, creatures.World[first], creature_bounds[first]);
+                render_queue.Submit(lamp_program, lamp_mesh, no_textures, 0, creatures.World[first + 1], creature_bounds[first + 1]);
             }
-			model = glm::mat4();
-            if(PICK_UP_SVEN == true)
-            {
-                // set sven to be in front of you, with camera's position and direction
-                sven_glob_pos = camera.Position + camera.Front;
-                //modify height in which sven is elevated
-                sven_glob_pos = glm::vec3(sven_glob_pos.x, 0.3, sven_glob_pos.z);
-                model = glm::translate(model, sven_glob_pos);
+        });
 
-                //calculate angle so sven faces your direction
-                svenAngle = acos(dot(glm::vec3(0,0,1), camera.Front));
-                glm::vec3 cross(glm::cross(glm::vec3(0,0,1), camera.Front));
+		// sort everything submitted above and hand it to OpenGL
+		render_queue.Execute();
+		frame_ring.EndFrame();
+		culled_draws += render_queue.Stats.Culled;
 
-                //if cross product found to produce -ve value of y, rotate clockwise
-                if(cross.y < 0)
-                    svenAngle = -svenAngle;
-
-                model = glm::rotate(model, svenAngle, glm::vec3(0,1,0));
-            }
-            else
-            {
-                model = glm::translate(model, sven_glob_pos);
-            }
-
-            model = glm::translate(model, sven_positions[tab]);
-            
-	        if(tab == 6) // rotate tail
-            {
-                //if tail is at end of one side, start moving towards other side
-		        if(tailAngle <= -30.0f)
-			        moveTail = 2.0f;
-		        else if(tailAngle >= 30.0f)
-			        moveTail = -2.0f;
-
-                //increase rotation of tail
-		        tailAngle += moveTail;
-			    
-                model = glm::rotate(model, glm::radians(tailAngle), glm::vec3(1,0,0));
-	        }
-
-            model = glm::scale(model, sven_scales[tab]);
-			model = glm::translate(model, glm::vec3(0.0f, 0.5f, 0.0f));
+    Logger::Get().Sample(player_channel, frame_number, &camera.Position[0]);
+    Entity sheep = game.World.First<Sheep>();
+    if(game.World.IsAlive(sheep))
+    {
+        const Transform &sheep_transform = game.World.Get<Transform>(sheep);
+        float sheep_sample[] = { sheep_transform.Position.x, sheep_transform.Position.y, sheep_transform.Position.z, sheep_transform.Facing };
+        Logger::Get().Sample(sheep_channel, frame_number, sheep_sample);
+        LOG_EVERY(1.0, LEVEL_DEBUG, CATEGORY_GAME, "Player Coordinates X-Coords: %g Y-Coords: %g Z-Coords: %g Sheep Coordinates X-Coords: %g Y-Coords: %g Z-Coords: %g Sheep to Player Angle: %g",
+            camera.Position.x, camera.Position.y, camera.Position.z, sheep_transform.Position.x, sheep_transform.Position.y, sheep_transform.Position.z, sheep_transform.Facing);
+    }
+    frame_number++;
+	}, TaskGraph::MAIN_THREAD);
 
-			lighting_shader.setMat4("model", model);
-            toggle_sven_distance(sven_glob_pos);
+	frame_graph.Depend(simulate_task, input_task);
+	// simulate moves the eye, the camera vectors and the projection mode cull builds the view from
+	frame_graph.Depend(cull_task, simulate_task);
+	frame_graph.Depend(animate_task, simulate_task);
+	frame_graph.Depend(draw_task, animate_task);
+	frame_graph.Depend(draw_task, cull_task);
 
-			glDrawArrays(GL_TRIANGLES, 0, 36);
-		}
+	FrameStatistics frame_statistics;
+	PathRecorder path_recorder;
+	double recorded_time = 0.0;
 
-        //WaterSheep
-        glm::vec3 water_sheep_scales[] = {
-            glm::vec3( 0.25f, 0.25f, 0.25f), // head
-            glm::vec3( 0.20f, 0.20f, 0.05f ), // face
-            glm::vec3( 0.4f, 0.4f, 0.7f ), // upper bod
-            glm::vec3( 0.1f, -0.3f, 0.1f ), // leg 1 front left
-            glm::vec3( 0.1f, -0.3f, 0.1f ), // leg 2 front right
-            glm::vec3( 0.1f, -0.3f, 0.1f ), // leg 3 back left
-            glm::vec3( 0.1f, -0.3f, 0.1f ), // leg 4 back right
-            glm::vec3( 0.15f, -0.2f, 0.12f ), // upper leg
-            glm::vec3( 0.15f, -0.2f, 0.12f ), // upper leg
-            glm::vec3( 0.15f, -0.2f, 0.12f ), // upper leg
-            glm::vec3( 0.15f, -0.2f, 0.12f ), // upper leg
-        };
-
-        glm::vec3 water_sheep_positions[] = {
-            glm::vec3( sheep_curr_pos.x, sheep_curr_pos.y, sheep_curr_pos.z), // head
-            glm::vec3( sheep_curr_pos.x, sheep_curr_pos.y + 0.02f, sheep_curr_pos.z + 0.125f ), // face
-            glm::vec3( sheep_curr_pos.x, sheep_curr_pos.y - 0.25f, sheep_curr_pos.z - 0.35f ), // upper bod
-            glm::vec3( sheep_curr_pos.x -0.08f, sheep_curr_pos.y - 0.25f, sheep_curr_pos.z - 0.15f ), // front leg 1
-            glm::vec3( sheep_curr_pos.x +0.08f, sheep_curr_pos.y - 0.25f, sheep_curr_pos.z - 0.15f ), // front leg 2
-            glm::vec3( sheep_curr_pos.x -0.08f, sheep_curr_pos.y - 0.25f, sheep_curr_pos.z - 0.55f ), // hind leg 3
-            glm::vec3( sheep_curr_pos.x +0.08f, sheep_curr_pos.y - 0.25f, sheep_curr_pos.z - 0.55f ), // hind leg 4
-            glm::vec3( sheep_curr_pos.x +0.08f, sheep_curr_pos.y - 0.15f, sheep_curr_pos.z - 0.15f ), // front upper leg
-            glm::vec3( sheep_curr_pos.x -0.08f, sheep_curr_pos.y - 0.15f, sheep_curr_pos.z - 0.15f ), // front upper leg
-            glm::vec3( sheep_curr_pos.x +0.08f, sheep_curr_pos.y - 0.15f, sheep_curr_pos.z - 0.55f ), // hind upper leg
-            glm::vec3( sheep_curr_pos.x -0.08f, sheep_curr_pos.y - 0.15f, sheep_curr_pos.z - 0.55f ), // hind upper leg
-        };
-
-		glBindVertexArray(VAO_box);
-
-
-	for(int tab = 0; tab < 11; tab++)
+	// render loop
+	// -----------
+	while (!context.ShouldClose())
 	{
-            //if this block is the face, use water sheep face texture
-            if (tab == 1)
-            {
-		        glActiveTexture(GL_TEXTURE0);
-		        glBindTexture(GL_TEXTURE_2D, tex_water_sheep_diffuse);
-		        glActiveTexture(GL_TEXTURE1);
-		        glBindTexture(GL_TEXTURE_2D, tex_grass_specular);
-            }
-            else //if not use dark red texture
-            {
-		        glActiveTexture(GL_TEXTURE0);
-		        glBindTexture(GL_TEXTURE_2D, tex_red_dark_diffuse);
-		        glActiveTexture(GL_TEXTURE1);
-		        glBindTexture(GL_TEXTURE_2D, tex_red_dark_specular);
-            }
-            
-            //allow sheep to move only if sven is picked up and you have not won the game
-            if(PICK_UP_SVEN && !WIN_CONDITION)
-            {
-                // calculate vector towards your direction
-                float xDist = camera.Position.x - sheep_glob_pos.x;
-                float zDist = camera.Position.z - sheep_glob_pos.z;
-                float hypotenuse = sqrt(xDist * xDist + zDist * zDist);
-
-                //calculate angle to you
-                angle = acos(dot(glm::vec3(0,0,1), glm::normalize(glm::vec3(xDist, 0, zDist))));
-                glm::vec3 cross(glm::cross(glm::vec3(0,0,1), glm::normalize(glm::vec3(xDist, 0, zDist))));
-
-                //check if cross.y is -ve, if true rotate clockwise
-                if(cross.y < 0)
-                    angle = -angle;
-
-                //normalize
-                xDist /= hypotenuse;
-                zDist /= hypotenuse;
-
-                //move by distance * speed
-                sheep_glob_pos.x += xDist * water_sheep_speed/10 * delta_time;
-                sheep_glob_pos.z += zDist * water_sheep_speed/10 * delta_time;
-            }
-
-            //transform matrix
-		    model = glm::mat4();
-            model = glm::translate(model, sheep_glob_pos);
-            model = glm::rotate(model, angle, glm::vec3(0,1,0));
-	        model = glm::translate(model, water_sheep_positions[tab]);
-	    
-            //animation for 2 legs
-            if((tab == 3 || tab == 6 || tab == 8 || tab == 9) && PICK_UP_SVEN && !WIN_CONDITION)
-	        {
-                //if reached max rotation, rotate the other way
-		        if(legAngleOne <= -30.0f)
-			        moveLegOne = 2.0f;
-		        else if(legAngleOne >= 30.0f)
-			        moveLegOne = -2.0f;
-
-		        legAngleOne += moveLegOne;
-			    
-                model = glm::rotate(model, glm::radians(legAngleOne), glm::vec3(1,0,0));
-	        }
-
-            //animation for other 2 legs, 3 and 4 are not allowed 
-            //to move in same direction at the same time, likewise for 5 and 6
-	        if((tab == 4 || tab == 5 || tab == 7 || tab == 10) && PICK_UP_SVEN && !WIN_CONDITION)
-	        {
-                //if reached max rotation, rotate the other way
-		        if(legAngleTwo <= -30.0f)
-			        moveLegTwo = 2.0f;
-		        else if(legAngleTwo >= 30.0f)
-			        moveLegTwo = -2.0f;
-
-		        legAngleTwo += moveLegTwo;
-			    
-                model = glm::rotate(model, glm::radians(legAngleTwo), glm::vec3(1,0,0));
-	        }
-			model = glm::scale(model, water_sheep_scales[tab]);
-			model = glm::translate(model, glm::vec3(0.0f, 0.5f, 0.0f));
-            
-			lighting_shader.setMat4("model", model);
+		PROFILE_ZONE("frame");
+		std::chrono::steady_clock::time_point frame_start = std::chrono::steady_clock::now();
+		unsigned long long state_changes = gl_state.Issued;
+		draw_calls = 0;
+
+		// per-frame time logic, the benchmark advances the game by the step of its script and a
+		// replay by the recorded frame times
+		// ----------------------------------------------------------------------------------------
+		double currentFrame = context.Time();
+		delta_time = currentFrame - last_frame;
+		if (benchmarking)
+			delta_time = flythrough.Step;
+		else if (replaying)
+			delta_time = input_replay.Frame(context.Frame).DeltaTime;
+		last_frame = currentFrame;
 
-			glDrawArrays(GL_TRIANGLES, 0, 36);
+		// input, game logic and render
+		// ----------------------------
+		frame_graph.Run(jobs);
+		Profiler::Get().EndFrame();
+		if (!record_path.empty())
+		{
+			recorded_time += delta_time;
+			path_recorder.Add(recorded_time, camera);
 		}
 
-        //Torch
-        glm::vec3 torch_scales[] = {
-            glm::vec3( 0.05f, 0.2f, 0.05f ), // handle
-            glm::vec3( 0.05f, 0.05f, 0.05f), // top
-        };
-        
-        glm::vec3 torch_positions[] = {
-            glm::vec3( light_object_pos.x, light_object_pos.y - 0.2, light_object_pos.z ), // handle
-            glm::vec3( light_object_pos.x, light_object_pos.y, light_object_pos.z ), // top
-        };
-
-        //check if player close enough to torch
-	    toggle_torch_light_distance(light_pos); 
-		
-        for(int tab = 0; tab < 2; tab++)
-		{	
-		    glBindVertexArray(VAO_box);
-            // if torch top bind with plain white
-			if(tab == 1)
-			{	
-				glActiveTexture(GL_TEXTURE0);
-				glBindTexture(GL_TEXTURE_2D, tex_white);
-		        lamp_shader.use();
-		        lamp_shader.setMat4("projection", projection);
-		        lamp_shader.setMat4("view", view);
-			}
-            else // otherwise just use handle texture
-            {
-		        glActiveTexture(GL_TEXTURE0);
-		        glBindTexture(GL_TEXTURE_2D, tex_wood_diffuse);
-		        glActiveTexture(GL_TEXTURE1);
-		        glBindTexture(GL_TEXTURE_2D, tex_wood_specular);
-            }
-			model = glm::mat4();
-            
-            if(PICK_UP_TORCH == true) // check if torch has been picked up
-            {
-                //set light to be in front of player at all times
-                light_pos = camera.Position + camera.Front;
-
-                //rotate torch to player's direction
-                torchAngle = acos(dot(glm::vec3(0,0,1), camera.Front));
-                glm::vec3 cross(glm::cross(glm::vec3(0,0,1), camera.Front));
-
-                //check if cross.y is -ve, if found true, rotate clockwise
-                if(cross.y < 0)
-                    torchAngle = -torchAngle;
-            }
-
-            //performing transformations
-			model = glm::translate(model, light_pos);
-            std::cout << "Torch Angle: " << torchAngle << "\n";
-            model = glm::rotate(model, glm::radians(torchAngle), glm::vec3(0,1,0));
-			model = glm::translate(model, torch_positions[tab]);
-			model = glm::scale(model, torch_scales[tab]);
-			model = glm::translate(model, glm::vec3(0.0f, 0.5f, 0.0f));
-            
-            //check if player is toggling torch
-            if (tab == 1)
-            {
-                if(TORCH_PRESSED == true) lamp_shader.setFloat("intensity", 1.0);
-		        else lamp_shader.setFloat("intensity", 0.3f);
-		        
-                glBindVertexArray(VAO_light);
-            }
-			lighting_shader.setMat4("model", model);
+		// swap buffers and poll IO events, offscreen count the frame and dump it if asked to
+		// ----------------------------------------------------------------------------------
+		bool measured = benchmarking && (int)context.Frame >= flythrough.Warmup;
+		context.EndFrame();
+		if (measured)
+			frame_statistics.Add(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame_start).count(),
+				draw_calls, gl_state.Issued - state_changes);
+	}
+	Logger::Get().Flush();
+	input_recorder.Close();
 
-		    toggle_torch_distance(light_pos); 
-			glDrawArrays(GL_TRIANGLES, 0, 36);
+	if (!record_path.empty())
+	{
+		// replayed in as many frames as were recorded
+		double step = context.Frame > 0 ? recorded_time / context.Frame : 1.0 / 60.0;
+		if (path_recorder.Write(record_path, step))
+			std::cout << "Camera path written to " << record_path << "\n";
+		else
+			std::cout << "Failed to write camera path " << record_path << "\n";
+	}
+	if (benchmarking)
+	{
+		// the JSON alone, so the output can be piped straight into a tool
+		Profiler::Get().Finish();
+		if (benchmark_output.empty())
+			frame_statistics.WriteJson(std::cout, benchmark_path, Profiler::Get().GpuFrameTimes());
+		else
+		{
+			std::ofstream file(benchmark_output.c_str());
+			frame_statistics.WriteJson(file, benchmark_path, Profiler::Get().GpuFrameTimes());
+			if (!file)
+				std::cout << "Failed to write " << benchmark_output << "\n";
 		}
-
-    std::cout << "Player Coordinates X-Coords: " << camera.Position.x << " Y-Coords: " << camera.Position.y << " Z-Coords: " << camera.Position.z << " Angle to face Player: " << angle <<"\n";
-    std::cout << "Sheep Coordinates X-Coords: " << sheep_glob_pos.x << " Y-Coords: " << sheep_glob_pos.y << " Z-Coords: " <<sheep_glob_pos.z << "\n";
-    std::cout << "Sheep to Player Angle: " << angle << "\n"; 
-
-
-    //check if player has lost, if true, player lies down on his back and looks at the sky
-	check_lose_condition(sheep_glob_pos);
-	if(LOSE_CONDITION == true)
+	}
+	else
 	{
-	    camera.Pitch = 89.0f;
+		// what the caches and the job system saved
+		std::cout << "GL state cache: " << gl_state.Dropped << " of " << gl_state.Issued + gl_state.Dropped << " state changes dropped as redundant\n";
+		std::cout << "Frustum culling: " << culled_draws << " draws culled\n";
+		std::cout << "Frame ring: " << (frame_ring.Persistent ? "persistent mapping" : "orphaning") << ", " << frame_ring.Stalls << " stalls\n";
+		std::cout << "Simulation: " << simulation_steps << " steps of " << SIMULATION_STEP * 1000.0 << " ms\n";
+		std::cout << "Job system: " << jobs.WorkerCount() << " workers, " << jobs.Executed << " jobs, " << jobs.Stolen << " stolen\n";
+		std::cout << "Uniform cache: " << lighting_shader.skippedUniforms() + lamp_shader.skippedUniforms() << " unchanged uniform writes skipped\n";
 	}
-
-		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
-		// -------------------------------------------------------------------------------
-		glfwSwapBuffers(window);
-		glfwPollEvents();
+	if (!profile_path.empty())
+	{
+		Profiler::Get().Finish();
+		Profiler::Get().PrintSummary(std::cout);
+		if (Profiler::Get().WriteChromeTrace(profile_path))
+			std::cout << "Chrome trace written to " << profile_path << "\n";
 	}
 
 	// optional: de-allocate all resources once they've outlived their purpose:
@@ -984,137 +1038,32 @@ int main()
 	glDeleteVertexArrays(1, &VAO_box);
 	glDeleteBuffers(1, &VBO_box);
 
-	// glfw: terminate, clearing all previously allocated GLFW resources.
-	// ------------------------------------------------------------------
-	glfwTerminate();
+	// release the window or the offscreen context
+	// -------------------------------------------
+	context.Destroy();
 	return 0;
 }
 
 
 
-// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
-// ---------------------------------------------------------------------------------------------------------
-void process_input(GLFWwindow *window)
+// reads every key the game reacts to from GLFW, one bit per InputKey
+// ------------------------------------------------------------------
+unsigned int read_input(GLFWwindow *window)
 {
+    // offscreen there is nobody pressing keys
+    if (!window)
+        return 0;
+
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
     {
         glfwSetWindowShouldClose(window, true);
     }
 
-	if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_RELEASE)
-		camera.MovementSpeed = 2.5; 
-	else
-		camera.MovementSpeed = 2.5 * 2;	// double speed with "Shift" pressed
-
-    //if player has lost, they can no longer move
-    if(!LOSE_CONDITION)
-    {
-        if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-            camera.ProcessKeyboard(FORWARD, delta_time);
-        if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-            camera.ProcessKeyboard(BACKWARD, delta_time);
-        if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-            camera.ProcessKeyboard(LEFT, delta_time);
-        if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-            camera.ProcessKeyboard(RIGHT, delta_time);
-        //jumping mechanic
-        if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS)
-        {
-            camera.ProcessKeyboard(JUMP, delta_time);
-        }
-        else if (glfwGetKey(window, GLFW_KEY_SPACE) != GLFW_PRESS && 
-                camera.CurrJumping == false && camera.Falling == false)
-        {
-            camera.Position.y = 1.0f; //temporary, for flat floor
-        }
-	}
-
-    //increase light attenuation
-    if (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS && ATTENUATION_DELAY == 0)
-    {
-        //check if lowest setting
-        if(attIndex < 10)
-            attIndex += 1;
-    }
-
-    //decrease light attenuation
-    if (glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS && ATTENUATION_DELAY == 0)
-    {
-        //check if highest setting
-        if(attIndex > 0)
-            attIndex -= 1;
-    }
-
-	//toggle torch light
-	if (glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS && TORCH_DELAY == 0 && TORCH_CLOSE_ENOUGH == true)
-	{
-        //allow delay for time to register
-		TORCH_DELAY = 20;
-        //toggle value changes if already pressed
-		if(TORCH_PRESSED == false) 		
-			TORCH_PRESSED = true;
-		else
-			TORCH_PRESSED = false;
-	}
-
-    //reset's all values to initial save game, except restart delay
-	if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS && RESTART_DELAY == 0)
-	{
-		RESTART_DELAY = 20;
-		restart_button();
-	}
-	
-	//toggle coordinate visibility
-	if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS && SHOW_DELAY == 0)
-	{
-		SHOW_DELAY = 20;
-		if(SHOW_COORDINATE == false) 		
-			SHOW_COORDINATE = true;
-		else
-			SHOW_COORDINATE = false;
-	}
-
-    //Picking up functions
-    //Pick up Sven
-    if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS && PICK_UP_DELAY == 0 && SVEN_CLOSE == true)
-    {
-        PICK_UP_DELAY = 20;
-        if(PICK_UP_SVEN == false)
-            PICK_UP_SVEN = true;
-        else
-            PICK_UP_SVEN = false;
-    }
-
-    //Pick up torch
-	if (glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS && PICK_UP_DELAY == 0 && TORCH_CLOSE == true)
-    {
-        PICK_UP_DELAY = 20;
-        if(PICK_UP_TORCH == false)
-            PICK_UP_TORCH = true;
-        else
-            PICK_UP_TORCH = false;
-    }
-
-    //Set entire world to be bright, ambient set to 1.0
-    if (glfwGetKey(window,  GLFW_KEY_O) == GLFW_PRESS && LIGHT_DELAY == 0)
-    {
-        LIGHT_DELAY = 20;
-        if(LIGHT_MODE == false)
-            LIGHT_MODE = true;
-        else
-            LIGHT_MODE = false;
-    }
-
-    //change which view is being used, changes to ortho
-    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS && CAMERA_DELAY == 0)
-    {
-        CAMERA_DELAY = 20;
-        if(PROJECTION == false)
-            PROJECTION = true;
-        else
-            PROJECTION = false;
-    }
-
+    unsigned int keys = 0;
+    for (int key = 0; key < INPUT_KEY_COUNT; key++)
+        if (glfwGetKey(window, input_glfw_keys[key]) == GLFW_PRESS)
+            keys |= 1u << key;
+    return keys;
 }
 
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
@@ -1123,53 +1072,14 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
 	// make sure the viewport matches the new window dimensions; note that width and 
 	// height will be significantly larger than specified on retina displays.
-	glViewport(0, 0, width, height);
-}
-
-unsigned int loadTexture(char const * path)
-{
-	unsigned int textureID;
-	glGenTextures(1, &textureID);
-
-	int width, height, nrComponents;
-	stbi_set_flip_vertically_on_load(true); // tell stb_image.h to flip loaded texture's on the y-axis.
-	unsigned char *data = stbi_load(path, &width, &height, &nrComponents, 0);
-	if (data)
-	{
-		GLenum format;
-		if (nrComponents == 1)
-			format = GL_RED;
-		else if (nrComponents == 3)
-			format = GL_RGB;
-		else if (nrComponents == 4)
-			format = GL_RGBA;
-
-		glBindTexture(GL_TEXTURE_2D, textureID);
-		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-        //deals with images not being 4byte
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		stbi_image_free(data);
-	}
-	else
-	{
-		std::cout << "Texture failed to load at path: " << path << std::endl;
-		stbi_image_free(data);
-	}
-
-	return textureID;
+	GLState::Get().Viewport(0, 0, width, height);
 }
 
 void mouse_callback(GLFWwindow* window, double xpos, double ypos)
 {
-    if(firstMouse)
+    if(firstMouse || mouse_epoch != game.Epoch)
     {
+        mouse_epoch = game.Epoch;
         lastX = xpos;
         lastY = ypos;
         firstMouse = false;
@@ -1181,70 +1091,136 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos)
     lastX = xpos;
     lastY = ypos;
 
+    input_recorder.Mouse(xOffset, yOffset);
     camera.ProcessMouseMovement(xOffset, yOffset);
 }
 
-void restart_button()
+// Transforms the ground, win portal, anvil, chest and tree into world space and
+// merges them per material, so the render loop draws them without any matrix math.
+void bake_static_scene(StaticBatch &static_scene)
+{
+	glm::mat4 model;
+
+	//Grass
+	model = glm::mat4();
+	model = glm::translate(model, glm::vec3(0.0f, -0.01f, 0.0f));
+	model = glm::scale(model, glm::vec3(40.0f, 0.001f, 40.0f));
+
+	static_scene.Add(MAT_GRASS, box, 36, model);
+
+	//Win Portal
+	for(int tab = 0; tab < 5; tab++)
+	{	
+        //transform matrix
+		model = glm::mat4();
+		model = glm::translate(model, portal_positions[tab]);
+        model = glm::scale(model, portal_scales[tab]);
+		model = glm::translate(model, glm::vec3(0.0f, 0.5f, 0.0f));
+
+        //frame is obsidian, if reached portal positions, use nether portal texture instead
+		static_scene.Add(tab == 4 ? MAT_NETHER_PORTAL : MAT_OBSIDIAN, box, 36, model);
+	}
+
+	//Anvil, chest and tree
+	const PropShape props[] = { PROP_ANVIL, PROP_CHEST, PROP_TREE };
+	for(int prop = 0; prop < 3; prop++)
+	{
+		std::vector<PropPart> parts = prop_parts(props[prop]);
+		for(unsigned int i = 0; i < parts.size(); i++)
+			static_scene.Add(parts[i].Material, box, 36, parts[i].Model);
+	}
+
+	static_scene.Bake();
+}
+
+// Every box of an anvil, a chest or a tree where the layouts above put it.
+std::vector<PropPart> prop_parts(PropShape shape)
 {
-    camera = Camera(glm::vec3(0.0f, 1.0f, 3.0f));
-    firstMouse = true;
-    lastX = (float)SCR_WIDTH/2, lastY = (float)SCR_HEIGHT/2;
-    // game variables
-    LOSE_CONDITION = false;
-    WIN_CONDITION = false;
-
-    // lighting
-    torchAngle = 0.0f;
-    light_object_pos = glm::vec3(0.0f, 0.0f, 0.0f);
-    light_pos = glm::vec3(0.0f, 0.735f, 0.1f);
-
-    // remembering where we left sven
-    sven_glob_pos =  glm::vec3(2.0f, 0.3f, -1.0f);
-    sven_curr_pos = glm::vec3(0.0f, 0.0f, 0.0f);
-    tailAngle = 0.0f;
-    moveTail = 2.0f;
-    svenAngle = 0.0f;
-
-    // watersheep global position
-    sheep_glob_pos = glm::vec3(-2.0f, 0.55f, -0.65f);
-    sheep_curr_pos = glm::vec3(0, 0, 0);
-
-    // timing
-    delta_time = 0.0f;	// time between current frame and last frame
-    last_frame = 0.0f;
-
-    //Toggle (Animation or states)
-    TORCH_PRESSED = true;
-    TORCH_DELAY = 0;
-    TORCH_CLOSE_ENOUGH = false;
-
-    SHOW_COORDINATE = false;
-    SHOW_DELAY = 0;
-
-    PICK_UP_TORCH = false;
-    PICK_UP_SVEN = false;
-    PICK_UP_DELAY = 0;
-    SVEN_CLOSE = false;
-    TORCH_CLOSE = false;
-
-    PROJECTION = false;
-    CAMERA_DELAY = 0;
-
-    LIGHT_MODE = false;
-    LIGHT_DELAY = 0;
-
-    //WATER SHEEP MOVEMENT VARIABLES
-    water_sheep_speed = 1.0f;
-    angle = 0.0f;
-    legAngleOne = 0.0f;
-    moveLegOne = 2.0f;
-    legAngleTwo = 0.0f;
-    moveLegTwo = -2.0f;
-
-    //attenuation
-    attIndex = 0;
-    ATTENUATION_DELAY = 0;
-
-    //RESTART GAME
-    RESTART_PRESSED = false;
+	std::vector<PropPart> parts;
+	glm::mat4 model;
+	if(shape == PROP_ANVIL)
+	{
+		for(int tab = 0; tab < 4; tab++)
+		{
+			//transform matrix
+			model = glm::mat4();
+			model = glm::translate(model, anvil_positions[tab]);
+			model = glm::scale(model, anvil_scales[tab]);
+			model = glm::translate(model, glm::vec3(0.0f, 0.5f, 0.0f));
+
+			//use provided metal texture
+			parts.push_back(PropPart(MAT_METAL, model));
+		}
+	}
+	else if(shape == PROP_CHEST)
+	{
+		//2 boxes for main body, 1 for lock
+		for(int tab = 0; tab < 3; tab++)
+		{
+			//transform matrix
+			model = glm::mat4();
+			model = glm::translate(model, chest_positions[tab]);
+			//rotate to half of chest, let it be open a little
+			if(tab == 0)
+				model = glm::rotate(model, glm::radians(15.0f), glm::vec3(1,0,0));
+
+			//move lock to be attached to top half
+			if(tab == 2)
+				model = glm::rotate(model, glm::radians(105.0f), glm::vec3(1,0,0));
+
+			model = glm::scale(model, chest_scales[tab]);
+			model = glm::translate(model, glm::vec3(0.0f, 0.5f, 0.0f));
+
+			//use chest textures, metal texture for locks
+			parts.push_back(PropPart(tab == 2 ? MAT_METAL : MAT_CHEST, model));
+		}
+	}
+	else
+	{
+		for(int tab = 0; tab < 3; tab++)
+		{
+			//transform matrix
+			model = glm::mat4();
+			model = glm::translate(model, tree_positions[tab]);
+			model = glm::scale(model, tree_scales[tab]);
+			model = glm::translate(model, glm::vec3(0.0f, 0.5f, 0.0f));
+
+			//use wood texture for tree trunk, once moved on from tree trunk use leaf textures
+			parts.push_back(PropPart(tab == 0 ? MAT_WOOD : MAT_TREE_LEAVES, model));
+		}
+	}
+	return parts;
+}
+
+// Scatters the stress scene's anvils, chests and trees, turned around y, and indexes them for culling.
+void scatter_props(const StressScene &stress, PropField &field)
+{
+	const PropShape shapes[] = { PROP_TREE, PROP_ANVIL, PROP_CHEST };
+	const StressKind kinds[] = { STRESS_TREES, STRESS_ANVILS, STRESS_CHESTS };
+	const int counts[] = { stress.Trees, stress.Anvils, stress.Chests };
+	const AABB box_bounds(glm::vec3(-0.5f), glm::vec3(0.5f));
+	field.First.push_back(0);
+	for(int shape = 0; shape < 3; shape++)
+	{
+		std::vector<PropPart> parts = prop_parts(shapes[shape]);
+		std::vector<Transform> places = stress.Scatter(counts[shape], kinds[shape]);
+		for(unsigned int i = 0; i < places.size(); i++)
+		{
+			glm::mat4 place = ComposeTRS(places[i].Position, glm::angleAxis(places[i].Facing, glm::vec3(0,1,0)), glm::vec3(1.0f));
+			AABB bounds;
+			for(unsigned int tab = 0; tab < parts.size(); tab++)
+			{
+				glm::mat4 model = place * parts[tab].Model;
+				AABB part_bounds = box_bounds.Transformed(model);
+				field.Materials.push_back(parts[tab].Material);
+				field.Models.push_back(model);
+				field.Bounds.push_back(part_bounds);
+				bounds.Extend(part_bounds.Min);
+				bounds.Extend(part_bounds.Max);
+			}
+			field.Culling.Insert(bounds, field.First.size() - 1);
+			field.First.push_back(field.Models.size());
+		}
+	}
+	field.Culling.Build();
 }
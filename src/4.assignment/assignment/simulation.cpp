@@ -0,0 +1,186 @@
+#include "simulation.h"
+
+#include <learnopengl/profiler.h>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+Camera camera(glm::vec3(0.0f, 1.0f, 3.0f));
+glm::vec3 camera_previous = camera.Position;
+Game game;
+
+static bool key_held(unsigned int keys, InputKey key)
+{
+    return (keys & (1u << key)) != 0;
+}
+
+// process all input: react to the keys held during this simulation step
+// ---------------------------------------------------------------------
+static void process_input(unsigned int keys, float delta_time)
+{
+	if (!key_held(keys, KEY_SPRINT))
+		camera.MovementSpeed = 2.5; 
+	else
+		camera.MovementSpeed = 2.5 * 2;	// double speed with "Shift" pressed
+
+    //if player has lost, they can no longer move
+    if(!game.State.Lost)
+    {
+        if (key_held(keys, KEY_FORWARD))
+            camera.ProcessKeyboard(FORWARD, delta_time);
+        if (key_held(keys, KEY_BACKWARD))
+            camera.ProcessKeyboard(BACKWARD, delta_time);
+        if (key_held(keys, KEY_LEFT))
+            camera.ProcessKeyboard(LEFT, delta_time);
+        if (key_held(keys, KEY_RIGHT))
+            camera.ProcessKeyboard(RIGHT, delta_time);
+        //jumping mechanic
+        if (key_held(keys, KEY_JUMP))
+        {
+            camera.ProcessKeyboard(JUMP, delta_time);
+        }
+        else if (camera.CurrJumping == false && camera.Falling == false)
+        {
+            camera.Position.y = 1.0f; //temporary, for flat floor
+        }
+	}
+
+    //increase light attenuation
+    if (key_held(keys, KEY_ATTENUATION_UP) && game.State.AttenuationDelay == 0.0f)
+    {
+        //check if lowest setting
+        if(game.State.Attenuation < 10)
+            game.State.Attenuation += 1;
+    }
+
+    //decrease light attenuation
+    if (key_held(keys, KEY_ATTENUATION_DOWN) && game.State.AttenuationDelay == 0.0f)
+    {
+        //check if highest setting
+        if(game.State.Attenuation > 0)
+            game.State.Attenuation -= 1;
+    }
+
+	//toggle torch light, only if close enough
+	if (key_held(keys, KEY_TORCH_LIGHT))
+		game.ToggleTorchLight();
+
+    //reset's all values to initial save game, except restart delay
+	if (key_held(keys, KEY_RESTART) && game.State.RestartDelay == 0.0f)
+	{
+		game.State.RestartDelay = Game::KEY_DELAY;
+		restart_button();
+	}
+	
+	//toggle coordinate visibility
+	if (key_held(keys, KEY_COORDINATES) && game.State.ShowDelay == 0.0f)
+	{
+		game.State.ShowDelay = Game::KEY_DELAY;
+		game.State.ShowCoordinates = !game.State.ShowCoordinates;
+	}
+
+    //Picking up functions
+    //Pick up Sven
+    if (key_held(keys, KEY_PICK_UP_SVEN))
+        game.ToggleCarryWolf();
+
+    //Pick up torch
+	if (key_held(keys, KEY_PICK_UP_TORCH))
+        game.ToggleCarryTorch();
+
+    //Set entire world to be bright, ambient set to 1.0
+    if (key_held(keys, KEY_BRIGHT_MODE) && game.State.LightDelay == 0.0f)
+    {
+        game.State.LightDelay = Game::KEY_DELAY;
+        game.State.BrightMode = !game.State.BrightMode;
+    }
+
+    //change which view is being used, changes to ortho
+    if (key_held(keys, KEY_PROJECTION) && game.State.CameraDelay == 0.0f)
+    {
+        game.State.CameraDelay = Game::KEY_DELAY;
+        game.State.Orthographic = !game.State.Orthographic;
+    }
+
+}
+
+void simulation_step(unsigned int keys, float delta_time)
+{
+	PROFILE_ZONE("simulation step");
+	camera_previous = camera.Position;
+	//update delay countdown
+	game.UpdateDelays(delta_time);
+	process_input(keys, delta_time);
+	camera.jump(delta_time);
+	game.Update(camera.Position, camera.Front, delta_time);
+
+	//check if player has lost, if true, player lies down on his back and looks at the sky
+	if(game.State.Lost == true)
+	{
+		camera.Pitch = 89.0f;
+	}
+}
+
+void restart_button()
+{
+    camera = Camera(glm::vec3(0.0f, 1.0f, 3.0f));
+    camera_previous = camera.Position;
+    game.Restart();
+}
+
+// headless mode
+// -------------
+// the autopilot plays the intended route: walk up to Sven, pick him up, carry him into the portal
+// while the sheep chases, and restart once the game is won or lost
+static unsigned int autopilot()
+{
+	if (game.State.Won || game.State.Lost)
+		return 1u << KEY_RESTART;
+	if (!game.State.CarryingWolf && game.State.WolfInReach)
+		return 1u << KEY_PICK_UP_SVEN;
+
+	Entity target = game.State.CarryingWolf ? game.World.First<Portal>() : game.World.First<Wolf>();
+	if (!game.World.IsAlive(target))
+		return 0;
+	// turn through the same path the mouse takes, by the offset that faces the target
+	glm::vec3 to_target = game.World.Get<Transform>(target).Position - camera.Position;
+	float yaw = glm::degrees(atan2(to_target.z, to_target.x));
+	camera.ProcessMouseMovement((yaw - camera.Yaw) / camera.MouseSensitivity, 0.0f);
+	return 1u << KEY_FORWARD;
+}
+
+int run_headless(unsigned long long ticks)
+{
+	unsigned long long won = 0, lost = 0;
+	bool was_won = false, was_lost = false;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (unsigned long long tick = 0; tick < ticks; tick++)
+	{
+		simulation_step(autopilot(), (float)SIMULATION_STEP);
+		if (game.State.Won && !was_won)
+			won++;
+		if (game.State.Lost && !was_lost)
+			lost++;
+		was_won = game.State.Won;
+		was_lost = game.State.Lost;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << "Headless: " << ticks << " ticks (" << ticks * SIMULATION_STEP << " s of game time) in " << seconds << " s, "
+		<< (seconds > 0.0 ? ticks / seconds : 0.0) << " ticks/s, " << (ticks > 0 ? seconds * 1e9 / ticks : 0.0) << " ns per tick\n";
+	std::cout << "Outcomes: " << won << " won, " << lost << " lost, " << game.Epoch << " restarts\n";
+	std::cout << "Player Coordinates X-Coords: " << camera.Position.x << " Y-Coords: " << camera.Position.y << " Z-Coords: " << camera.Position.z << "\n";
+	Entity sheep = game.World.First<Sheep>();
+	if (game.World.IsAlive(sheep))
+	{
+		const Transform &sheep_transform = game.World.Get<Transform>(sheep);
+		std::cout << "Sheep Coordinates X-Coords: " << sheep_transform.Position.x << " Y-Coords: " << sheep_transform.Position.y << " Z-Coords: " << sheep_transform.Position.z << "\n";
+	}
+	std::cout << "Game state: " << (game.State.Won ? "won" : game.State.Lost ? "lost" : "playing")
+		<< ", carrying Sven: " << (game.State.CarryingWolf ? "yes" : "no")
+		<< ", carrying torch: " << (game.State.CarryingTorch ? "yes" : "no")
+		<< ", " << game.World.Size() << " entities\n";
+	return 0;
+}
@@ -0,0 +1,51 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/camera.h>
+
+#include "game.h"
+
+// One step of the assignment without any window or OpenGL: the keys held move the player's
+// camera, start jumps and toggle things, then the game runs its systems. The render loop feeds it
+// the keys GLFW reports, the headless mode feeds it keys of its own.
+
+// the game advances in fixed steps whatever the frame rate, so it plays the same at 30 or 300 frames per second
+const double SIMULATION_STEP = 1.0 / 120.0;
+
+// keys the game reacts to, one bit each in the key masks handed to simulation_step
+enum InputKey {
+	KEY_FORWARD,
+	KEY_BACKWARD,
+	KEY_LEFT,
+	KEY_RIGHT,
+	KEY_JUMP,
+	KEY_SPRINT,
+	KEY_ATTENUATION_UP,
+	KEY_ATTENUATION_DOWN,
+	KEY_TORCH_LIGHT,
+	KEY_RESTART,
+	KEY_COORDINATES,
+	KEY_PICK_UP_SVEN,
+	KEY_PICK_UP_TORCH,
+	KEY_BRIGHT_MODE,
+	KEY_PROJECTION,
+	INPUT_KEY_COUNT
+};
+
+// the player
+extern Camera camera;
+extern glm::vec3 camera_previous; // at the step before, the view is interpolated between the two
+extern Game game;
+
+// advances the player and the game by delta_time seconds with 'keys' held
+void simulation_step(unsigned int keys, float delta_time);
+// puts the player back at the start and respawns every entity in one go
+void restart_button();
+
+// runs 'ticks' steps as fast as possible with the player steered by a simple autopilot, then
+// prints the throughput and how the game ended up
+int run_headless(unsigned long long ticks);
+
+#endif
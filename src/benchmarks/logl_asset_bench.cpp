@@ -0,0 +1,328 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <stb_image.h>
+
+#include <learnopengl/benchmark.h>
+#include <learnopengl/filesystem.h>
+#include <learnopengl/model.h>
+#include <learnopengl/profiler.h>
+#include <learnopengl/render_context.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+// Throughput of the asset pipeline, stage by stage and asset by asset: for every image the file
+// read, the stb_image decode, the upload and the mipmap generation, for every model Assimp's
+// ReadFile, the conversion in Model::processMesh and the buffer upload in Mesh::setupMesh. The
+// model stages come from the profiler zones inside Model and Mesh. Reads and decodes are rated in
+// MB/s of file, uploads and mipmaps in MB/s of texels or vertices and indices, every stage also
+// in assets/s.
+//
+// GL work is finished with glFinish inside the timed stage, so it is counted where it happens and
+// not in the next stage. Reads after the first come from the OS file cache.
+//
+//   logl_asset_bench [--textures dir] [--model file]... [--triangles N]... [--json results.json]
+//                    [--window] [--filter name] [--repetitions 3] [--warmup 1] [--label abc123]
+//
+// Without --model, synthetic grids of 10k, 100k and 1M triangles (or the --triangles given) are
+// written as OBJ next to the working directory, loaded, and deleted again.
+
+const unsigned int SCR_WIDTH = 64;
+const unsigned int SCR_HEIGHT = 64;
+
+std::string file_name(const std::string &path)
+{
+	size_t slash = path.find_last_of("/\\");
+	return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+// images in 'directory', sorted by name
+std::vector<std::string> list_images(const std::string &directory)
+{
+	std::vector<std::string> names;
+#ifdef _WIN32
+	WIN32_FIND_DATAA data;
+	HANDLE find = FindFirstFileA((directory + "/*").c_str(), &data);
+	if (find != INVALID_HANDLE_VALUE)
+	{
+		do names.push_back(data.cFileName); while (FindNextFileA(find, &data));
+		FindClose(find);
+	}
+#else
+	DIR *dir = opendir(directory.c_str());
+	if (dir)
+	{
+		while (dirent *entry = readdir(dir))
+			names.push_back(entry->d_name);
+		closedir(dir);
+	}
+#endif
+	std::vector<std::string> images;
+	for (unsigned int i = 0; i < names.size(); i++)
+	{
+		std::string extension = names[i].substr(names[i].find_last_of('.') + 1);
+		if (extension == "jpg" || extension == "jpeg" || extension == "png" || extension == "tga" || extension == "bmp")
+			images.push_back(directory + "/" + names[i]);
+	}
+	std::sort(images.begin(), images.end());
+	return images;
+}
+
+bool read_file(const std::string &path, std::vector<unsigned char> &bytes)
+{
+	std::ifstream file(path.c_str(), std::ios::binary | std::ios::ate);
+	if (!file)
+		return false;
+	bytes.resize((size_t)file.tellg());
+	file.seekg(0);
+	file.read((char *)&bytes[0], bytes.size());
+	return (bool)file;
+}
+
+// flat grid of at least 'triangles' triangles with a gentle wave, normals and texture coordinates
+bool write_grid_obj(const std::string &path, unsigned int triangles)
+{
+	FILE *file = std::fopen(path.c_str(), "w");
+	if (!file)
+		return false;
+	int n = std::max(1, (int)std::ceil(std::sqrt(triangles / 2.0)));
+	for (int z = 0; z <= n; z++)
+		for (int x = 0; x <= n; x++)
+			std::fprintf(file, "v %f %f %f\n", x / (float)n - 0.5f, 0.05f * std::sin(x * 0.3f) * std::cos(z * 0.3f), z / (float)n - 0.5f);
+	for (int z = 0; z <= n; z++)
+		for (int x = 0; x <= n; x++)
+			std::fprintf(file, "vt %f %f\n", x / (float)n, z / (float)n);
+	std::fprintf(file, "vn 0 1 0\n");
+	for (int z = 0; z < n; z++)
+	{
+		for (int x = 0; x < n; x++)
+		{
+			int a = z * (n + 1) + x + 1, b = a + 1, c = a + n + 1, d = c + 1;
+			std::fprintf(file, "f %d/%d/1 %d/%d/1 %d/%d/1\n", a, a, c, c, b, b);
+			std::fprintf(file, "f %d/%d/1 %d/%d/1 %d/%d/1\n", b, b, c, c, d, d);
+		}
+	}
+	return std::fclose(file) == 0;
+}
+
+// total duration of the zones named 'name' recorded since 'since'
+double zone_time(const std::vector<ProfileEvent> &events, long long since, const char *name)
+{
+	double total = 0.0;
+	for (unsigned int i = 0; i < events.size(); i++)
+		if (events[i].Begin >= since && std::string(events[i].Name) == name)
+			total += (double)(events[i].End - events[i].Begin);
+	return total;
+}
+
+void benchmark_texture(BenchmarkSuite &suite, const std::string &path)
+{
+	std::string name = "texture/" + file_name(path);
+	std::vector<unsigned char> bytes;
+	if (!read_file(path, bytes) || bytes.empty())
+	{
+		std::cout << "Failed to read " << path << "\n";
+		return;
+	}
+	int width = 0, height = 0, components = 0;
+	unsigned char *pixels = stbi_load_from_memory(&bytes[0], bytes.size(), &width, &height, &components, 0);
+	if (!pixels)
+	{
+		std::cout << "Failed to decode " << path << "\n";
+		return;
+	}
+	double texels = (double)width * height * components;
+	GLenum format = components == 1 ? GL_RED : components == 2 ? GL_RG : components == 3 ? GL_RGB : GL_RGBA;
+
+	std::vector<unsigned char> scratch;
+	suite.Run(name + "/read", 1, [&]() { read_file(path, scratch); }, bytes.size());
+	suite.Run(name + "/decode", 1, [&]()
+	{
+		int w, h, c;
+		stbi_image_free(stbi_load_from_memory(&bytes[0], bytes.size(), &w, &h, &c, 0));
+	}, bytes.size());
+
+	// the same calls as TextureFromFile
+	unsigned int texture;
+	glGenTextures(1, &texture);
+	GLState::Get().BindTexture(GL_TEXTURE_2D, texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	suite.Run(name + "/upload", 1, [&]()
+	{
+		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, pixels);
+		glFinish();
+	}, texels);
+	suite.Run(name + "/mipmaps", 1, [&]()
+	{
+		glGenerateMipmap(GL_TEXTURE_2D);
+		glFinish();
+	}, texels);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	GLState::Get().BindTexture(GL_TEXTURE_2D, 0);
+	glDeleteTextures(1, &texture);
+	stbi_image_free(pixels);
+}
+
+// the textures one after the other, the way the programs load them at startup
+void benchmark_all_textures(BenchmarkSuite &suite, const std::vector<std::string> &paths)
+{
+	double total = 0.0;
+	std::vector<unsigned char> bytes;
+	for (unsigned int i = 0; i < paths.size(); i++)
+		if (read_file(paths[i], bytes))
+			total += bytes.size();
+	suite.Run("textures/all", paths.size(), [&]()
+	{
+		for (unsigned int i = 0; i < paths.size(); i++)
+		{
+			unsigned int texture = TextureFromFile(file_name(paths[i]).c_str(), paths[i].substr(0, paths[i].find_last_of("/\\")));
+			glDeleteTextures(1, &texture);
+		}
+		glFinish();
+	}, total);
+}
+
+void benchmark_model(BenchmarkSuite &suite, const std::string &path, const std::string &name)
+{
+	std::vector<unsigned char> bytes;
+	if (!read_file(path, bytes))
+	{
+		std::cout << "Failed to read " << path << "\n";
+		return;
+	}
+	std::vector<unsigned char> scratch;
+	suite.Run(name + "/read", 1, [&]() { read_file(path, scratch); }, bytes.size());
+	const char *stages[] = { "/Assimp::ReadFile", "/processMesh", "/setupMesh", "/glFinish", "/total" };
+	bool selected = false;
+	for (int i = 0; i < 5; i++)
+		selected = selected || suite.Selected(name + stages[i]);
+	if (!selected)
+		return;
+
+	std::vector<double> total, read, convert, upload, finish;
+	double geometry = 0.0;
+	for (unsigned int i = 0; i < suite.Warmup + suite.Repetitions; i++)
+	{
+		long long start = Profiler::Get().Now();
+		Model model(path);
+		long long loaded = Profiler::Get().Now();
+		glFinish();
+		long long finished = Profiler::Get().Now();
+		if (i < suite.Warmup)
+			continue;
+
+		std::vector<ProfileEvent> events = Profiler::Get().Recorded();
+		double setup = zone_time(events, start, "Mesh::setupMesh");
+		total.push_back((double)(finished - start));
+		read.push_back(zone_time(events, start, "Assimp::ReadFile"));
+		// processMesh builds the Mesh, so it contains setupMesh and the material textures
+		convert.push_back(zone_time(events, start, "Model::processMesh") - setup - zone_time(events, start, "TextureFromFile"));
+		upload.push_back(setup);
+		finish.push_back((double)(finished - loaded));
+		geometry = 0.0;
+		for (unsigned int m = 0; m < model.meshes.size(); m++)
+		{
+			geometry += model.meshes[m].vertices.size() * sizeof(Vertex) + model.meshes[m].indices.size() * sizeof(unsigned int);
+			glDeleteVertexArrays(1, &model.meshes[m].VAO);
+		}
+	}
+	suite.AddSamples(name + stages[0], 1, 1, read, std::vector<double>(), bytes.size());
+	suite.AddSamples(name + stages[1], 1, 1, convert, std::vector<double>(), geometry);
+	suite.AddSamples(name + stages[2], 1, 1, upload, std::vector<double>(), geometry);
+	suite.AddSamples(name + stages[3], 1, 1, finish, std::vector<double>(), geometry);
+	suite.AddSamples(name + stages[4], 1, 1, total, std::vector<double>(), bytes.size());
+}
+
+int main(int argc, char **argv)
+{
+	BenchmarkSuite suite("logl_asset_bench");
+	suite.Warmup = 1;
+	suite.Repetitions = 3;
+	suite.ParseArguments(argc, argv);
+	std::string json_path;
+	std::string texture_directory = FileSystem::getPath("resources/textures");
+	std::vector<std::string> models;
+	std::vector<unsigned int> triangles;
+	bool window = false;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--json" && i + 1 < argc)
+			json_path = argv[++i];
+		else if (arg == "--textures" && i + 1 < argc)
+			texture_directory = argv[++i];
+		else if (arg == "--model" && i + 1 < argc)
+			models.push_back(argv[++i]);
+		else if (arg == "--triangles" && i + 1 < argc)
+			triangles.push_back(std::atoi(argv[++i]));
+		else if (arg == "--window")
+			window = true;
+	}
+	if (models.empty() && triangles.empty())
+	{
+		triangles.push_back(10000);
+		triangles.push_back(100000);
+		triangles.push_back(1000000);
+	}
+
+	// uploads need a context, offscreen unless asked for a window
+	RenderContext context(argc, argv);
+#if defined(LOGL_HAVE_EGL)
+	if (!window && context.Type == RenderContext::WINDOW)
+		context.Type = RenderContext::EGL_SURFACELESS;
+#elif defined(LOGL_HAVE_OSMESA)
+	if (!window && context.Type == RenderContext::WINDOW)
+		context.Type = RenderContext::OSMESA;
+#endif
+	if (!context.Create(SCR_WIDTH, SCR_HEIGHT, "Asset benchmark"))
+		return -1;
+	// the zones inside Model and Mesh time the model stages
+	Profiler::Get().Enable(false);
+
+	std::vector<std::string> textures = list_images(texture_directory);
+	std::cout << textures.size() << " images in " << texture_directory << "\n";
+	for (unsigned int i = 0; i < textures.size(); i++)
+		benchmark_texture(suite, textures[i]);
+	if (!textures.empty())
+		benchmark_all_textures(suite, textures);
+
+	for (unsigned int i = 0; i < models.size(); i++)
+		benchmark_model(suite, models[i], "model/" + file_name(models[i]));
+	for (unsigned int i = 0; i < triangles.size(); i++)
+	{
+		std::string path = "logl_asset_bench_grid_" + std::to_string(triangles[i]) + ".obj";
+		if (!write_grid_obj(path, triangles[i]))
+		{
+			std::cout << "Failed to write " << path << "\n";
+			continue;
+		}
+		benchmark_model(suite, path, "model/grid " + std::to_string(triangles[i]) + " triangles");
+		std::remove(path.c_str());
+	}
+
+	if (!json_path.empty())
+	{
+		std::ofstream file(json_path.c_str());
+		suite.WriteJson(file);
+		if (!file)
+		{
+			std::cout << "Failed to write " << json_path << "\n";
+			context.Destroy();
+			return 1;
+		}
+		std::cout << "Results written to " << json_path << "\n";
+	}
+	context.Destroy();
+	return 0;
+}
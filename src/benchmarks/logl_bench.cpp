@@ -0,0 +1,288 @@
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <learnopengl/benchmark.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/matrix_kernels.h>
+#include <learnopengl/scene_graph.h>
+
+#include "../4.assignment/assignment/creature_layout.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// CPU micro-benchmarks of the math the assignment runs every frame: the camera, the creature
+// transforms and the normal matrices. Needs no window or OpenGL. --check instead compares every
+// SIMD level of MatrixKernels the CPU supports against the scalar reference and exits with 1 if
+// any kernel is off by more than the tolerance.
+//
+//   logl_bench [--json results.json] [--filter camera] [--repetitions 25] [--warmup 3] [--label abc123]
+//   logl_bench --check
+
+const int CREATURES = 1024;
+
+// swing of every water sheep part, +1 and -1 for the two groups of legs, filled in by main. The
+// water sheep is the creature with the most moving parts.
+float sheep_swing[SHEEP_PARTS];
+
+float random_float(float low, float high)
+{
+	return low + (high - low) * (std::rand() / (float)RAND_MAX);
+}
+
+// largest difference between two float arrays, relative to the reference value where it is above 1
+float max_error(const float *values, const float *reference, size_t count)
+{
+	float error = 0.0f;
+	for (size_t i = 0; i < count; i++)
+		error = std::max(error, std::fabs(values[i] - reference[i]) / std::max(1.0f, std::fabs(reference[i])));
+	return error;
+}
+
+// runs every kernel of every supported level on the same random affine transforms and compares the
+// results with MatrixKernels::Reference(), returns the exit code
+int check_kernels()
+{
+	// the AVX2 kernels fuse multiply-adds, the inverses in the normal matrices amplify that a little
+	const float TOLERANCE = 1e-4f;
+	// odd, so the SIMD kernels also run their leftover instances
+	const int COUNT = 4099;
+	std::vector<glm::vec3> translations(COUNT), scales(COUNT), points(COUNT);
+	std::vector<glm::quat> rotations(COUNT);
+	for (int i = 0; i < COUNT; i++)
+	{
+		translations[i] = glm::vec3(random_float(-50.0f, 50.0f), random_float(-5.0f, 5.0f), random_float(-50.0f, 50.0f));
+		rotations[i] = glm::angleAxis(random_float(-3.14f, 3.14f), glm::normalize(glm::vec3(random_float(-1.0f, 1.0f), random_float(0.1f, 1.0f), random_float(-1.0f, 1.0f))));
+		scales[i] = glm::vec3(random_float(0.05f, 2.0f), random_float(0.05f, 2.0f), random_float(0.05f, 2.0f));
+		points[i] = glm::vec3(random_float(-1.0f, 1.0f), random_float(-1.0f, 1.0f), random_float(-1.0f, 1.0f));
+	}
+	const AABB box(glm::vec3(-0.5f), glm::vec3(0.5f));
+
+	// what a kernel set makes of the inputs, every output one after the other
+	struct Results {
+		std::vector<glm::mat4> Composed, Products, Children;
+		std::vector<glm::mat3> Normals;
+		std::vector<glm::vec3> Points;
+		std::vector<AABB> Bounds;
+	};
+	auto run = [&](const MatrixKernelSet &kernels, Results &results)
+	{
+		results.Composed.resize(COUNT);
+		results.Products.resize(COUNT);
+		results.Children.resize(COUNT);
+		results.Normals.resize(COUNT);
+		results.Points.resize(COUNT);
+		results.Bounds.resize(COUNT);
+		// the inputs of the later kernels come from the reference, so errors do not add up
+		const MatrixKernelSet &reference = MatrixKernels::Reference();
+		std::vector<glm::mat4> models(COUNT);
+		reference.ComposeTRS(&translations[0], &rotations[0], &scales[0], &models[0], COUNT);
+		kernels.ComposeTRS(&translations[0], &rotations[0], &scales[0], &results.Composed[0], COUNT);
+		kernels.Multiply(&models[0], &models[COUNT / 2], &results.Products[0], COUNT / 2);
+		kernels.MultiplyParent(models[0], &models[0], &results.Children[0], COUNT);
+		kernels.NormalMatrices(&models[0], sizeof(glm::mat4), &results.Normals[0], sizeof(glm::mat3), COUNT);
+		kernels.TransformPoints(models[1], &points[0], &results.Points[0], COUNT);
+		kernels.TransformBounds(&models[0], box, &results.Bounds[0], COUNT);
+	};
+
+	Results expected;
+	run(MatrixKernels::Reference(), expected);
+	bool passed = true;
+	const SimdLevel levels[] = { SIMD_SSE41, SIMD_AVX2 };
+	for (int l = 0; l < 2 && levels[l] <= MatrixKernels::Supported(); l++)
+	{
+		MatrixKernels::Select(levels[l]);
+		const MatrixKernelSet &kernels = MatrixKernels::Active();
+		Results results;
+		run(kernels, results);
+		const char *names[] = { "ComposeTRS", "Multiply", "MultiplyParent", "NormalMatrices", "TransformPoints", "TransformBounds" };
+		float errors[] = {
+			max_error(&results.Composed[0][0][0], &expected.Composed[0][0][0], COUNT * 16),
+			max_error(&results.Products[0][0][0], &expected.Products[0][0][0], COUNT / 2 * 16),
+			max_error(&results.Children[0][0][0], &expected.Children[0][0][0], COUNT * 16),
+			max_error(&results.Normals[0][0][0], &expected.Normals[0][0][0], COUNT * 9),
+			max_error(&results.Points[0][0], &expected.Points[0][0], COUNT * 3),
+			max_error(&results.Bounds[0].Min[0], &expected.Bounds[0].Min[0], COUNT * 6),
+		};
+		for (int k = 0; k < 6; k++)
+		{
+			bool ok = errors[k] <= TOLERANCE;
+			passed = passed && ok;
+			std::cout << (ok ? "ok     " : "FAILED ") << kernels.Name << " " << names[k] << ": max error " << errors[k] << "\n";
+		}
+	}
+	if (MatrixKernels::Supported() == SIMD_SCALAR)
+		std::cout << "Only the scalar kernels run on this CPU, nothing to check\n";
+	return passed ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+	BenchmarkSuite suite("logl_bench");
+	suite.ParseArguments(argc, argv);
+	std::string json_path;
+	for (int i = 1; i + 1 < argc; i++)
+		if (std::string(argv[i]) == "--json")
+			json_path = argv[i + 1];
+	std::srand(1);
+	for (int i = 1; i < argc; i++)
+		if (std::string(argv[i]) == "--check")
+			return check_kernels();
+
+	std::vector<glm::vec3> positions(CREATURES);
+	std::vector<float> facings(CREATURES), swings(CREATURES);
+	for (int i = 0; i < CREATURES; i++)
+	{
+		positions[i] = glm::vec3(random_float(-20.0f, 20.0f), 0.55f, random_float(-20.0f, 20.0f));
+		facings[i] = random_float(-3.14f, 3.14f);
+		swings[i] = random_float(-30.0f, 30.0f);
+	}
+	for (int leg = 0; leg < 4; leg++)
+	{
+		sheep_swing[sheep_legs_one[leg]] = 1.0f;
+		sheep_swing[sheep_legs_two[leg]] = -1.0f;
+	}
+
+	// camera
+	// ------
+	std::vector<glm::vec2> mouse(CREATURES);
+	for (int i = 0; i < CREATURES; i++)
+		mouse[i] = glm::vec2(random_float(-20.0f, 20.0f), random_float(-20.0f, 20.0f));
+	Camera camera(glm::vec3(0.0f, 1.0f, 3.0f));
+	suite.Run("camera/ProcessMouseMovement", mouse.size(), [&]()
+	{
+		// updateCameraVectors runs inside every call
+		for (size_t i = 0; i < mouse.size(); i++)
+			camera.ProcessMouseMovement(mouse[i].x, mouse[i].y);
+		benchmark_keep(camera.Front);
+	});
+
+	std::vector<Camera> cameras;
+	for (int i = 0; i < CREATURES; i++)
+		cameras.push_back(Camera(positions[i], glm::vec3(0.0f, 1.0f, 0.0f), facings[i] * 57.3f, swings[i]));
+	std::vector<glm::mat4> views(CREATURES);
+	suite.Run("camera/GetViewMatrix", cameras.size(), [&]()
+	{
+		for (size_t i = 0; i < cameras.size(); i++)
+			views[i] = cameras[i].GetViewMatrix();
+		benchmark_keep(views[0]);
+	});
+
+	// creature transforms, items are parts
+	// ------------------------------------
+	std::vector<glm::mat4> parts(CREATURES * SHEEP_PARTS);
+	suite.Run("creature/glm translate-rotate-scale chain", parts.size(), [&]()
+	{
+		// how every part used to be placed: one chain of glm calls per part
+		for (int c = 0; c < CREATURES; c++)
+		{
+			for (int tab = 0; tab < SHEEP_PARTS; tab++)
+			{
+				glm::mat4 model;
+				model = glm::translate(model, positions[c]);
+				model = glm::rotate(model, facings[c], glm::vec3(0, 1, 0));
+				model = glm::translate(model, water_sheep_positions[tab]);
+				if (sheep_swing[tab] != 0.0f)
+					model = glm::rotate(model, glm::radians(sheep_swing[tab] * swings[c]), glm::vec3(1, 0, 0));
+				model = glm::scale(model, water_sheep_scales[tab]);
+				model = glm::translate(model, glm::vec3(0.0f, 0.5f, 0.0f));
+				parts[c * SHEEP_PARTS + tab] = model;
+			}
+		}
+		benchmark_keep(parts[0]);
+	});
+
+	SceneGraph creatures;
+	for (int c = 0; c < CREATURES; c++)
+	{
+		int root = creatures.Add(glm::mat4());
+		for (int tab = 0; tab < SHEEP_PARTS; tab++)
+			creatures.Add(glm::mat4(), root);
+	}
+	float phase = 0.0f;
+	suite.Run("creature/ComposeTRS + SceneGraph::Update", CREATURES * SHEEP_PARTS, [&]()
+	{
+		// how the assignment places them now: a composed TRS per moving node, then one batched update
+		phase = phase > 1.0f ? 0.0f : phase + 0.001f;
+		for (int c = 0; c < CREATURES; c++)
+		{
+			int root = c * (SHEEP_PARTS + 1);
+			creatures.SetLocal(root, ComposeTRS(positions[c], glm::angleAxis(facings[c] + phase, glm::vec3(0, 1, 0)), glm::vec3(1.0f)));
+			for (int tab = 0; tab < SHEEP_PARTS; tab++)
+			{
+				glm::quat swing = glm::angleAxis(glm::radians(sheep_swing[tab] * (swings[c] + phase)), glm::vec3(1, 0, 0));
+				glm::vec3 lift = swing * glm::vec3(0.0f, 0.5f * water_sheep_scales[tab].y, 0.0f);
+				creatures.SetLocal(root + 1 + tab, ComposeTRS(water_sheep_positions[tab] + lift, swing, water_sheep_scales[tab]));
+			}
+		}
+		benchmark_keep(creatures.Update());
+	});
+	std::vector<glm::vec3> part_positions(parts.size()), part_scales(parts.size());
+	std::vector<glm::quat> part_swings(parts.size());
+	std::vector<glm::mat4> composed(parts.size());
+	for (size_t i = 0; i < parts.size(); i++)
+	{
+		int tab = i % SHEEP_PARTS;
+		part_positions[i] = water_sheep_positions[tab];
+		part_scales[i] = water_sheep_scales[tab];
+		part_swings[i] = glm::angleAxis(glm::radians(sheep_swing[tab] * swings[i / SHEEP_PARTS]), glm::vec3(1, 0, 0));
+	}
+	const SimdLevel levels[] = { SIMD_SCALAR, SIMD_SSE41, SIMD_AVX2 };
+	for (int l = 0; l < 3 && levels[l] <= MatrixKernels::Supported(); l++)
+	{
+		MatrixKernels::Select(levels[l]);
+		const MatrixKernelSet &kernels = MatrixKernels::Active();
+		suite.Run(std::string("creature/MatrixKernels::ComposeTRS ") + kernels.Name, parts.size(), [&]()
+		{
+			kernels.ComposeTRS(&part_positions[0], &part_swings[0], &part_scales[0], &composed[0], composed.size());
+			benchmark_keep(composed[0]);
+		});
+	}
+
+	// normal matrices, items are matrices
+	// -----------------------------------
+	std::vector<glm::mat4> models(parts);
+	std::vector<glm::mat4> normals4(models.size());
+	std::vector<glm::mat3> normals3(models.size());
+	suite.Run("normal/transpose(inverse(mat4))", models.size(), [&]()
+	{
+		for (size_t i = 0; i < models.size(); i++)
+			normals4[i] = glm::transpose(glm::inverse(models[i]));
+		benchmark_keep(normals4[0]);
+	});
+	suite.Run("normal/transpose(inverse(mat3))", models.size(), [&]()
+	{
+		for (size_t i = 0; i < models.size(); i++)
+			normals3[i] = glm::transpose(glm::inverse(glm::mat3(models[i])));
+		benchmark_keep(normals3[0]);
+	});
+	for (int l = 0; l < 3 && levels[l] <= MatrixKernels::Supported(); l++)
+	{
+		MatrixKernels::Select(levels[l]);
+		const MatrixKernelSet &kernels = MatrixKernels::Active();
+		suite.Run(std::string("normal/MatrixKernels::NormalMatrices ") + kernels.Name, models.size(), [&]()
+		{
+			kernels.NormalMatrices(&models[0], sizeof(glm::mat4), &normals3[0], sizeof(glm::mat3), models.size());
+			benchmark_keep(normals3[0]);
+		});
+	}
+
+	if (!json_path.empty())
+	{
+		std::ofstream file(json_path.c_str());
+		suite.WriteJson(file);
+		if (!file)
+		{
+			std::cout << "Failed to write " << json_path << "\n";
+			return 1;
+		}
+		std::cout << "Results written to " << json_path << "\n";
+	}
+	return 0;
+}